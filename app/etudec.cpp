@@ -0,0 +1,203 @@
+#include <driver/build.hpp>
+
+#include <server/compile_server.hpp>
+#include <server/server_error.hpp>
+
+#include <stats/stats.hpp>
+#include <stats/trace.hpp>
+
+#include <fmt/core.h>
+
+#include <pthread.h>
+#include <signal.h>
+
+#include <string_view>
+#include <filesystem>
+#include <thread>
+#include <optional>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+
+namespace fs = std::filesystem;
+
+struct Options {
+  driver::BuildOptions build;
+  std::vector<std::string> build_args;
+
+  // --serve: become a compile server; --server: ask one to compile
+  fs::path serve;
+  fs::path server;
+
+  bool time_report = false;
+  bool json_report = false;
+  bool tracing = false;
+};
+
+static void PrintUsage() {
+  fmt::print(stderr,
+             "Usage: etudec [options] <file.et>...\n"
+             "       etudec --serve=<socket>\n"
+             "  -o <file>          output executable (a.out)\n"
+             "  -B <dir>           where .eti/.ssa/.s/.o go (.)\n"
+             "  -I <dir>           search path for imported interfaces\n"
+             "  -j <n>             parallel jobs (all cores)\n"
+             "  -MF <file>         write a Makefile-style depfile\n"
+             "  --interface-only   stop after writing interfaces\n"
+             "  --generics=specialize|dictionary\n"
+             "                     code per type argument, or one shared\n"
+             "                     copy taking type descriptors\n"
+             "  --generics-for=<fun>=specialize|dictionary\n"
+             "                     the same for one function, over\n"
+             "                     --generics\n"
+             "  --alloc=malloc|bump\n"
+             "                     heap for `new`: libc, or the runtime's\n"
+             "                     thread-local bump allocator\n"
+             "  --instrument       count function calls and branches,\n"
+             "                     dumped to $ETUDE_PROFILE at exit\n"
+             "  --profile-use=<file>\n"
+             "                     inline, order functions and lay out\n"
+             "                     branches by an instrumented run\n"
+             "  --runtime=<lib>    libetude_rt.a to link for --alloc=bump\n"
+             "                     and --instrument ($ETUDE_RUNTIME, else\n"
+             "                     the one from the build tree)\n"
+             "  --serve=<socket>   run as a compile server keeping loaded\n"
+             "                     interfaces between compilations\n"
+             "  --server=<socket>  compile through that server, locally if\n"
+             "                     none is running\n"
+             "  --time-report[=json]\n"
+             "  --trace=<file.json>\n");
+}
+
+static bool ParseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg{argv[i]};
+
+    if (arg == "--time-report") {
+      options.time_report = true;
+    } else if (arg == "--time-report=json") {
+      options.time_report = options.json_report = true;
+    } else if (arg.starts_with("--trace=")) {
+      stats::EnableTracing(std::string{arg.substr(8)});
+      stats::SetThreadName("etudec");
+      options.tracing = true;
+    } else if (arg.starts_with("--serve=")) {
+      options.serve = arg.substr(8);
+    } else if (arg.starts_with("--server=")) {
+      options.server = arg.substr(9);
+    } else {
+      options.build_args.emplace_back(arg);
+    }
+  }
+
+  if (!options.serve.empty()) {
+    return options.build_args.empty();
+  }
+
+  return driver::ParseBuildOptions(options.build_args, options.build);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static int Serve(const fs::path& socket) {
+  // SIGINT/SIGTERM: finish the compilations in flight and exit.
+  // Blocked before any thread starts, so only `sigwait` sees them.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  driver::BuildCache cache;
+
+  server::CompileServer compile_server{
+      socket, [&](const server::CompileRequest& request) {
+        server::CompileResponse response;
+
+        driver::BuildOptions options;
+        if (!driver::ParseBuildOptions(request.args, options)) {
+          response.status = 2;
+          response.output = "etudec: bad arguments\n";
+          return response;
+        }
+
+        options.MakeAbsolute(request.cwd);
+
+        try {
+          driver::Build(options, &cache);
+        } catch (std::exception& error) {
+          response.status = 1;
+          response.output = fmt::format("etudec: {}", error.what());
+        }
+
+        return response;
+      }};
+
+  std::thread{[&compile_server, signals] {
+    int signal = 0;
+    sigwait(&signals, &signal);
+    compile_server.Stop();
+  }}.detach();
+
+  compile_server.Serve();
+  return 0;
+}
+
+// The response, or nothing if no server is running
+static std::optional<server::CompileResponse> CompileRemotely(
+    const Options& options) {
+  server::CompileRequest request;
+  request.cwd = fs::current_path();
+  request.args = options.build_args;
+
+  try {
+    return server::SendCompileRequest(options.server, request);
+  } catch (server::errors::SocketError&) {
+    return std::nullopt;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+  Options options;
+
+  if (!ParseOptions(argc, argv, options)) {
+    PrintUsage();
+    return 2;
+  }
+
+  if (!options.serve.empty()) {
+    try {
+      return Serve(options.serve);
+    } catch (std::exception& error) {
+      fmt::print(stderr, "etudec: {}", error.what());
+      return 1;
+    }
+  }
+
+  // Reports and traces describe this process: those builds stay local
+  if (!options.server.empty() && !options.time_report && !options.tracing) {
+    if (auto response = CompileRemotely(options)) {
+      fmt::print(stderr, "{}", response->output);
+      return response->status;
+    }
+  }
+
+  int status = 0;
+
+  try {
+    driver::Build(options.build);
+  } catch (std::exception& error) {
+    fmt::print(stderr, "etudec: {}", error.what());
+    status = 1;
+  }
+
+  if (options.time_report) {
+    fmt::print(stderr, "{}",
+               options.json_report ? stats::FormatJson() : stats::FormatTable());
+  }
+
+  return status;
+}
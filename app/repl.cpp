@@ -1,7 +1,33 @@
+#include <stats/stats.hpp>
+#include <stats/trace.hpp>
+
 #include <fmt/color.h>
 
 #include <iostream>
+#include <string_view>
+#include <string>
+
+int main(int argc, char** argv) {
+  bool time_report = false;
+  bool json_report = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg{argv[i]};
+
+    if (arg == "--time-report") {
+      time_report = true;
+    } else if (arg == "--time-report=json") {
+      time_report = json_report = true;
+    } else if (arg.starts_with("--trace=")) {
+      stats::EnableTracing(std::string{arg.substr(8)});
+      stats::SetThreadName("main");
+    }
+  }
+
+  if (time_report) {
+    fmt::print(stderr, "{}",
+               json_report ? stats::FormatJson() : stats::FormatTable());
+  }
 
-int main() {
   return 0;
 }
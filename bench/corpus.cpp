@@ -0,0 +1,247 @@
+#include <corpus.hpp>
+
+#include <fmt/format.h>
+
+namespace bench {
+
+//////////////////////////////////////////////////////////////////////
+
+const char* FormatShape(Shape shape) {
+  switch (shape) {
+    case Shape::DEEP_NESTING:
+      return "deep";
+    case Shape::MANY_FUNCTIONS:
+      return "functions";
+    case Shape::LONG_STRINGS:
+      return "strings";
+    case Shape::COMMENT_HEAVY:
+      return "comments";
+    case Shape::MIXED:
+      return "mixed";
+  }
+  return "?";
+}
+
+std::optional<Shape> ParseShape(std::string_view name) {
+  for (auto shape : {Shape::DEEP_NESTING, Shape::MANY_FUNCTIONS,
+                     Shape::LONG_STRINGS, Shape::COMMENT_HEAVY,
+                     Shape::MIXED}) {
+    if (name == FormatShape(shape)) {
+      return shape;
+    }
+  }
+  return std::nullopt;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// splitmix64: tiny, and unlike std::*_distribution
+// gives the same sequence everywhere
+
+class Rng {
+ public:
+  explicit Rng(uint64_t seed) : state_{seed} {
+  }
+
+  uint64_t Next() {
+    uint64_t z = (state_ += 0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+  }
+
+  size_t Below(size_t bound) {
+    return Next() % bound;
+  }
+
+  bool Chance(size_t percent) {
+    return Below(100) < percent;
+  }
+
+ private:
+  uint64_t state_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+class Generator {
+ public:
+  explicit Generator(const CorpusOptions& options)
+      : options_{options}, rng_{options.seed} {
+  }
+
+  std::string Run() {
+    while (out_.size() < options_.bytes) {
+      switch (PickShape()) {
+        case Shape::DEEP_NESTING:
+          DeepFunction();
+          break;
+        case Shape::MANY_FUNCTIONS:
+          SmallFunction();
+          break;
+        case Shape::LONG_STRINGS:
+          StringVariable();
+          break;
+        case Shape::COMMENT_HEAVY:
+          Comments(1 + rng_.Below(6));
+          SmallFunction();
+          break;
+        case Shape::MIXED:
+          break;
+      }
+    }
+    return fmt::to_string(out_);
+  }
+
+ private:
+  Shape PickShape() {
+    if (options_.shape != Shape::MIXED) {
+      return options_.shape;
+    }
+    return static_cast<Shape>(rng_.Below(4));
+  }
+
+  template <typename... Args>
+  void Put(fmt::format_string<Args...> format, Args&&... args) {
+    fmt::format_to(std::back_inserter(out_), format,
+                   std::forward<Args>(args)...);
+  }
+
+  ////////////////////////////////////////////////////////////////////
+
+  void Comments(size_t lines) {
+    for (size_t i = 0; i < lines; i++) {
+      Put("# {} {} lorem ipsum var fun if {{ ( \" \n", i, rng_.Next());
+    }
+  }
+
+  void StringVariable() {
+    Put("var s{} = \"", functions_++);
+    size_t length = 1024 + rng_.Below(4096);
+    for (size_t i = 0; i < length; i++) {
+      Put("{}", static_cast<char>('a' + rng_.Below(26)));
+    }
+    Put("\";\n");
+  }
+
+  void SmallFunction() {
+    Put("fun f{} a b = {{\n", functions_);
+
+    size_t locals = rng_.Below(4);
+    for (size_t i = 0; i < locals; i++) {
+      Put("  var x{} = ", i);
+      Expression(3, i);
+      Put(";\n");
+      if (options_.shape == Shape::COMMENT_HEAVY) {
+        Comments(2);
+      }
+    }
+
+    Put("  ");
+    Expression(3, locals);
+    Put("\n}};\n\n");
+
+    functions_++;
+  }
+
+  void DeepFunction() {
+    Put("fun f{} a b = ", functions_++);
+    Nested(options_.depth);
+    Put(";\n\n");
+  }
+
+  // Right-leaning chain of parenthesized binary expressions;
+  // iterative so the generator survives any depth
+  void Nested(size_t depth) {
+    static const char* ops[] = {"+", "-", "*", "/", "==", "<", ">"};
+
+    for (size_t i = 0; i < depth; i++) {
+      Put("({} {} ", rng_.Below(1000), ops[rng_.Below(7)]);
+    }
+    Put("a");
+    for (size_t i = 0; i < depth; i++) {
+      Put(")");
+    }
+  }
+
+  void Expression(size_t depth, size_t locals) {
+    if (depth == 0) {
+      return Leaf(locals);
+    }
+
+    switch (rng_.Below(6)) {
+      case 0:
+        return Leaf(locals);
+
+      case 1:
+        Put("-");
+        return Expression(depth - 1, locals);
+
+      case 2:
+        if (functions_ > 0) {
+          Put("f{}(", rng_.Below(functions_));
+          Expression(depth - 1, locals);
+          Put(", ");
+          Expression(depth - 1, locals);
+          Put(")");
+          return;
+        }
+        [[fallthrough]];
+
+      case 3:
+        // Parenthesized: `if` is greedy and would swallow
+        // the rest of an enclosing binary expression
+        Put("(if (");
+        Expression(depth - 1, locals);
+        Put(") < 10 {{ ");
+        Expression(depth - 1, locals);
+        Put(" }} else {{ ");
+        Expression(depth - 1, locals);
+        Put(" }})");
+        return;
+
+      default:
+        static const char* ops[] = {"+", "-", "*", "/", "==", "!="};
+        Put("(");
+        Expression(depth - 1, locals);
+        Put(" {} ", ops[rng_.Below(6)]);
+        Expression(depth - 1, locals);
+        Put(")");
+        return;
+    }
+  }
+
+  void Leaf(size_t locals) {
+    switch (rng_.Below(locals > 0 ? 4 : 3)) {
+      case 0:
+        return Put("{}", rng_.Below(100000));
+      case 1:
+        return Put("a");
+      case 2:
+        return Put("b");
+      default:
+        return Put("x{}", rng_.Below(locals));
+    }
+  }
+
+ private:
+  const CorpusOptions& options_;
+  Rng rng_;
+
+  size_t functions_ = 0;
+  fmt::memory_buffer out_;
+};
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+std::string GenerateCorpus(const CorpusOptions& options) {
+  return Generator{options}.Run();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace bench
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string_view>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace bench {
+
+//////////////////////////////////////////////////////////////////////
+
+// Synthetic Etude programs for benchmarking the front end.
+//
+// Same options => same bytes, on every platform and standard library:
+// the generator uses its own PRNG, so numbers from different commits
+// are measured on identical input.
+
+enum class Shape {
+  DEEP_NESTING,    // few functions, very deep expressions
+  MANY_FUNCTIONS,  // lots of small functions calling each other
+  LONG_STRINGS,    // string literals of a few kilobytes
+  COMMENT_HEAVY,   // more comments than code
+  MIXED,           // all of the above
+};
+
+const char* FormatShape(Shape shape);
+std::optional<Shape> ParseShape(std::string_view name);
+
+struct CorpusOptions {
+  Shape shape = Shape::MIXED;
+
+  // Generate at least this much text
+  size_t bytes = 1 << 20;
+
+  // Nesting depth of expressions in DEEP_NESTING
+  size_t depth = 200;
+
+  uint64_t seed = 1;
+};
+
+std::string GenerateCorpus(const CorpusOptions& options);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace bench
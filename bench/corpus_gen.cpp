@@ -0,0 +1,33 @@
+#include <corpus.hpp>
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <string>
+
+int main(int argc, char** argv) {
+  bench::CorpusOptions options;
+
+  if (argc > 1) {
+    if (auto shape = bench::ParseShape(argv[1])) {
+      options.shape = *shape;
+    } else {
+      fmt::print(stderr,
+                 "Usage: {} [deep|functions|strings|comments|mixed] "
+                 "[bytes] [seed]\n",
+                 argv[0]);
+      return 1;
+    }
+  }
+
+  if (argc > 2) {
+    options.bytes = std::stoull(argv[2]);
+  }
+
+  if (argc > 3) {
+    options.seed = std::stoull(argv[3]);
+  }
+
+  fmt::print("{}", bench::GenerateCorpus(options));
+  return 0;
+}
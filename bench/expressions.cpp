@@ -0,0 +1,484 @@
+#include <parse/operator_precedence.hpp>
+
+#include <ast/visitors/return_visitor.hpp>
+#include <ast/visitors/post_order.hpp>
+#include <ast/flat_fold.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <string_view>
+#include <optional>
+#include <cstdint>
+#include <string>
+
+//////////////////////////////////////////////////////////////////////
+
+// The explicit-stack expression parser and the iterative traversals
+// against their recursive counterparts, on ordinary (shallow) input:
+// stack safety must not cost anything on everyday code. For the
+// parser that is BM_HybridExpressions, the recursive one with a depth
+// count; BM_StackExpressions is what input past the limit costs.
+
+namespace {
+
+// Digits, `-` prefix, `+ - * /`, parens; `;` ends an expression
+std::string ShallowExpressions(size_t bytes) {
+  static const char* ops = "+-*/";
+
+  std::string text;
+  uint64_t state = 1;
+  auto next = [&] {
+    state = state * 6364136223846793005 + 1442695040888963407;
+    return state >> 33;
+  };
+
+  while (text.size() < bytes) {
+    size_t open = 0;
+    for (size_t terms = 2 + next() % 8; terms > 0; terms--) {
+      if (next() % 4 == 0) {
+        text += '(';
+        open += 1;
+      }
+      if (next() % 8 == 0) {
+        text += '-';
+      }
+      text += static_cast<char>('1' + next() % 9);
+      if (open > 0 && next() % 3 == 0) {
+        text += ')';
+        open -= 1;
+      }
+      if (terms > 1) {
+        text += ops[next() % 4];
+      }
+    }
+    text.append(open, ')');
+    text += ';';
+  }
+
+  return text;
+}
+
+class Cursor {
+ public:
+  explicit Cursor(std::string_view text) : text_{text} {
+  }
+
+  char Peek() const {
+    return pos_ < text_.size() ? text_[pos_] : '\0';
+  }
+
+  bool Match(char ch) {
+    if (Peek() == ch) {
+      pos_ += 1;
+      return true;
+    }
+    return false;
+  }
+
+  char Take() {
+    return text_[pos_++];
+  }
+
+ private:
+  std::string_view text_;
+  size_t pos_ = 0;
+};
+
+int Precedence(char op) {
+  return op == '+' || op == '-' ? 1 : op == '*' || op == '/' ? 2 : 0;
+}
+
+int64_t Apply(char op, int64_t lhs, int64_t rhs) {
+  switch (op) {
+    case '+':
+      return lhs + rhs;
+    case '-':
+      return lhs - rhs;
+    case '*':
+      return lhs * rhs;
+    default:
+      return rhs == 0 ? 0 : lhs / rhs;
+  }
+}
+
+// What the course parser does: one function per precedence level
+class RecursiveParser {
+ public:
+  explicit RecursiveParser(Cursor& cursor) : cursor_{cursor} {
+  }
+
+  int64_t Additive() {
+    auto value = Multiplicative();
+    while (Precedence(cursor_.Peek()) == 1) {
+      auto op = cursor_.Take();
+      value = Apply(op, value, Multiplicative());
+    }
+    return value;
+  }
+
+ private:
+  int64_t Multiplicative() {
+    auto value = Unary();
+    while (Precedence(cursor_.Peek()) == 2) {
+      auto op = cursor_.Take();
+      value = Apply(op, value, Unary());
+    }
+    return value;
+  }
+
+  int64_t Unary() {
+    if (cursor_.Match('-')) {
+      return -Unary();
+    }
+    if (cursor_.Match('(')) {
+      auto value = Additive();
+      cursor_.Match(')');
+      return value;
+    }
+    return cursor_.Take() - '0';
+  }
+
+ private:
+  Cursor& cursor_;
+};
+
+class StackSource {
+ public:
+  explicit StackSource(Cursor& cursor) : cursor_{cursor} {
+  }
+
+  std::optional<int> MatchPrefix() {
+    return cursor_.Match('-') ? std::optional{'-'} : std::nullopt;
+  }
+
+  bool MatchOpenParen() {
+    return cursor_.Match('(');
+  }
+
+  bool MatchCloseParen() {
+    return cursor_.Match(')');
+  }
+
+  std::optional<parse::BinaryOperator> PeekBinary() {
+    if (auto precedence = Precedence(cursor_.Peek())) {
+      return parse::BinaryOperator{cursor_.Peek(), precedence, false};
+    }
+    return std::nullopt;
+  }
+
+  void ConsumeBinary() {
+    cursor_.Take();
+  }
+
+  int64_t ParseOperand() {
+    return cursor_.Take() - '0';
+  }
+
+  int64_t ParsePostfix(int64_t value) {
+    return value;
+  }
+
+  int64_t MakeUnary(int, int64_t value) {
+    return -value;
+  }
+
+  int64_t MakeBinary(const parse::BinaryOperator& op, int64_t lhs,
+                     int64_t rhs) {
+    return Apply(static_cast<char>(op.token), lhs, rhs);
+  }
+
+  [[noreturn]] void MissingCloseParen() {
+    std::abort();
+  }
+
+ private:
+  Cursor& cursor_;
+};
+
+// The recursive one with the fallback: what the course parser does
+// past parse::kRecursionDepth
+class HybridParser {
+ public:
+  HybridParser(Cursor& cursor, StackSource& source,
+               parse::ExpressionStacks<int64_t>& stacks)
+      : cursor_{cursor}, source_{source}, stacks_{stacks} {
+  }
+
+  int64_t Additive(size_t depth = 0) {
+    auto value = Multiplicative(depth);
+    while (Precedence(cursor_.Peek()) == 1) {
+      auto op = cursor_.Take();
+      value = Apply(op, value, Multiplicative(depth));
+    }
+    return value;
+  }
+
+ private:
+  int64_t Multiplicative(size_t depth) {
+    auto value = Unary(depth);
+    while (Precedence(cursor_.Peek()) == 2) {
+      auto op = cursor_.Take();
+      value = Apply(op, value, Unary(depth));
+    }
+    return value;
+  }
+
+  int64_t Unary(size_t depth) {
+    if (cursor_.Match('-')) {
+      if (depth >= parse::kRecursionDepth) [[unlikely]] {
+        return -Fallback(parse::kNoOperators);
+      }
+      return -Unary(depth + 1);
+    }
+    if (cursor_.Match('(')) {
+      int64_t value;
+      if (depth >= parse::kRecursionDepth) [[unlikely]] {
+        value = Fallback(parse::kAllOperators);
+      } else {
+        value = Additive(depth + 1);
+      }
+      cursor_.Match(')');
+      return value;
+    }
+    return cursor_.Take() - '0';
+  }
+
+  // Out of line, so that it does not weigh on the inlining above
+  [[gnu::noinline, gnu::cold]] int64_t Fallback(int min_precedence) {
+    return parse::ParseOperatorExpression(source_, stacks_, min_precedence);
+  }
+
+ private:
+  Cursor& cursor_;
+  StackSource& source_;
+  parse::ExpressionStacks<int64_t>& stacks_;
+};
+
+const std::string& Expressions() {
+  static const auto text = ShallowExpressions(256 * 1024);
+  return text;
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+static void BM_RecursiveExpressions(benchmark::State& state) {
+  auto& text = Expressions();
+
+  for (auto _ : state) {
+    Cursor cursor{text};
+    RecursiveParser parser{cursor};
+    int64_t sum = 0;
+    while (cursor.Peek()) {
+      sum += parser.Additive();
+      cursor.Match(';');
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+BENCHMARK(BM_RecursiveExpressions)->Unit(benchmark::kMillisecond);
+
+static void BM_StackExpressions(benchmark::State& state) {
+  auto& text = Expressions();
+
+  for (auto _ : state) {
+    Cursor cursor{text};
+    StackSource source{cursor};
+    parse::ExpressionStacks<int64_t> stacks;
+    int64_t sum = 0;
+    while (cursor.Peek()) {
+      sum += parse::ParseOperatorExpression(source, stacks);
+      cursor.Match(';');
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+BENCHMARK(BM_StackExpressions)->Unit(benchmark::kMillisecond);
+
+static void BM_HybridExpressions(benchmark::State& state) {
+  auto& text = Expressions();
+
+  for (auto _ : state) {
+    Cursor cursor{text};
+    StackSource source{cursor};
+    parse::ExpressionStacks<int64_t> stacks;
+    HybridParser parser{cursor, source, stacks};
+    int64_t sum = 0;
+    while (cursor.Peek()) {
+      sum += parser.Additive();
+      cursor.Match(';');
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+BENCHMARK(BM_HybridExpressions)->Unit(benchmark::kMillisecond);
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+class SumVisitor;
+
+struct Leaf : TreeNode {
+  void Accept(Visitor* visitor) override;
+
+  lex::Location GetLocation() override {
+    return {};
+  }
+};
+
+struct Pair : TreeNode {
+  Pair(TreeNode* lhs, TreeNode* rhs) : lhs{lhs}, rhs{rhs} {
+  }
+
+  void Accept(Visitor* visitor) override;
+
+  lex::Location GetLocation() override {
+    return {};
+  }
+
+  void AppendChildren(std::vector<TreeNode*>& children) override {
+    children.push_back(lhs);
+    children.push_back(rhs);
+  }
+
+  TreeNode* lhs;
+  TreeNode* rhs;
+};
+
+class SumVisitor : public ReturnVisitor<int64_t> {
+ public:
+  void VisitLeaf(Leaf*) {
+    return_value = 1;
+  }
+
+  void VisitPair(Pair* pair) {
+    return_value = Eval(pair->lhs) + Eval(pair->rhs) + 1;
+  }
+};
+
+void Leaf::Accept(Visitor* visitor) {
+  static_cast<SumVisitor*>(visitor)->VisitLeaf(this);
+}
+
+void Pair::Accept(Visitor* visitor) {
+  static_cast<SumVisitor*>(visitor)->VisitPair(this);
+}
+
+// Balanced: as deep as ordinary code gets
+TreeNode* Balanced(size_t depth) {
+  if (depth == 0) {
+    return new Leaf;
+  }
+  return new Pair{Balanced(depth - 1), Balanced(depth - 1)};
+}
+
+TreeNode* Tree() {
+  static auto tree = Balanced(16);
+  return tree;
+}
+
+}  // namespace
+
+static void BM_RecursiveEval(benchmark::State& state) {
+  SumVisitor visitor;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(visitor.Eval(Tree()));
+  }
+  state.SetItemsProcessed(state.iterations() * ((2 << 16) - 1));
+}
+
+BENCHMARK(BM_RecursiveEval)->Unit(benchmark::kMicrosecond);
+
+static void BM_PostOrderWalk(benchmark::State& state) {
+  for (auto _ : state) {
+    size_t nodes = 0;
+    ForEachPostOrder(Tree(), [&](TreeNode*) {
+      nodes += 1;
+    });
+    benchmark::DoNotOptimize(nodes);
+  }
+  state.SetItemsProcessed(state.iterations() * ((2 << 16) - 1));
+}
+
+BENCHMARK(BM_PostOrderWalk)->Unit(benchmark::kMicrosecond);
+
+// Pays for the explicit stack and the result window: meant for trees
+// that are too deep for `Eval`, not as its replacement
+static void BM_IterativeEval(benchmark::State& state) {
+  SumVisitor visitor;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(visitor.EvalIteratively(Tree()));
+  }
+  state.SetItemsProcessed(state.iterations() * ((2 << 16) - 1));
+}
+
+BENCHMARK(BM_IterativeEval)->Unit(benchmark::kMicrosecond);
+
+//////////////////////////////////////////////////////////////////////
+
+// The same tree in a FlatTree: a full pass is a forward sweep over
+// a few arrays instead of a pointer chase through the heap
+
+namespace {
+
+const FlatTree& Flat() {
+  static auto tree = [] {
+    FlatTree tree;
+    Flatten(Tree(), tree,
+            [](FlatTree& tree, TreeNode* node,
+               std::span<const FlatIndex> children) {
+              if (dynamic_cast<Leaf*>(node)) {
+                return tree.AddInt(1);
+              }
+              return tree.AddBinary(FlatOp::ADD, children[0], children[1]);
+            });
+    return tree;
+  }();
+  return tree;
+}
+
+}  // namespace
+
+// Full constant folding: every kind and operator, and values that may
+// be unknown. More work per node than the sums above, so this is the
+// cost of the real pass, not a race against BM_RecursiveEval;
+// BM_FlatSweep is the like-for-like one.
+static void BM_FlatFold(benchmark::State& state) {
+  auto& tree = Flat();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FoldConstants(tree)[tree.Size() - 1]);
+  }
+  state.SetItemsProcessed(state.iterations() * ((2 << 16) - 1));
+}
+
+BENCHMARK(BM_FlatFold)->Unit(benchmark::kMicrosecond);
+
+static void BM_FlatSweep(benchmark::State& state) {
+  auto& tree = Flat();
+  for (auto _ : state) {
+    auto data = tree.AllData();
+    std::vector<int64_t> values(data.size());
+    for (FlatIndex i = 0; i < data.size(); i++) {
+      values[i] = tree.Kind(i) == FlatKind::INT_LITERAL
+                      ? 1
+                      : values[data[i].lhs] + values[data[i].rhs];
+    }
+    benchmark::DoNotOptimize(values.back());
+  }
+  state.SetItemsProcessed(state.iterations() * ((2 << 16) - 1));
+}
+
+BENCHMARK(BM_FlatSweep)->Unit(benchmark::kMicrosecond);
+
+//////////////////////////////////////////////////////////////////////
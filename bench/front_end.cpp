@@ -0,0 +1,116 @@
+#include <corpus.hpp>
+
+#include <parse/parser.hpp>
+
+#include <stats/stats.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+#include <map>
+
+//////////////////////////////////////////////////////////////////////
+
+// The AST does not own its children, so parsed trees are leaked;
+// keep the corpus moderate so that repeated iterations stay cheap
+
+static constexpr size_t kCorpusBytes = 256 * 1024;
+
+static const std::string& Corpus(bench::Shape shape) {
+  static std::map<bench::Shape, std::string> cache;
+
+  auto [it, inserted] = cache.try_emplace(shape);
+  if (inserted) {
+    it->second = bench::GenerateCorpus({
+        .shape = shape,
+        .bytes = kCorpusBytes,
+    });
+  }
+
+  return it->second;
+}
+
+static void ShapeArgs(benchmark::internal::Benchmark* bench) {
+  for (int shape = 0; shape <= static_cast<int>(bench::Shape::MIXED);
+       shape++) {
+    bench->Arg(shape);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static void BM_Lexer(benchmark::State& state) {
+  auto shape = static_cast<bench::Shape>(state.range(0));
+  auto& source = Corpus(shape);
+
+  size_t tokens = 0;
+
+  for (auto _ : state) {
+    std::stringstream stream{source};
+    lex::Lexer lexer{stream};
+
+    while (!lexer.Matches(lex::TokenType::TOKEN_EOF)) {
+      lexer.Advance();
+      tokens += 1;
+    }
+  }
+
+  state.SetLabel(bench::FormatShape(shape));
+  state.SetBytesProcessed(state.iterations() * source.size());
+  state.counters["tokens/s"] =
+      benchmark::Counter(tokens, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_Lexer)->Apply(ShapeArgs)->Unit(benchmark::kMillisecond);
+
+//////////////////////////////////////////////////////////////////////
+
+// Source text to AST: the whole front end as it stands,
+// later phases belong here as they land
+
+static void BM_Parser(benchmark::State& state) {
+  auto shape = static_cast<bench::Shape>(state.range(0));
+  auto& source = Corpus(shape);
+
+  size_t declarations = 0;
+  auto nodes_before = stats::Value(stats::Counter::AST_NODES);
+
+  for (auto _ : state) {
+    std::stringstream stream{source};
+    lex::Lexer lexer{stream};
+    Parser parser{lexer};
+
+    while (auto declaration = parser.ParseDeclaration()) {
+      benchmark::DoNotOptimize(declaration);
+      declarations += 1;
+    }
+  }
+
+  auto nodes = stats::Value(stats::Counter::AST_NODES) - nodes_before;
+
+  state.SetLabel(bench::FormatShape(shape));
+  state.SetBytesProcessed(state.iterations() * source.size());
+  state.counters["decls/s"] =
+      benchmark::Counter(declarations, benchmark::Counter::kIsRate);
+
+  // Counted by the TreeNode constructor, needs COMPILER_STATS
+  if (stats::kEnabled) {
+    state.counters["nodes/s"] =
+        benchmark::Counter(nodes, benchmark::Counter::kIsRate);
+  }
+}
+
+BENCHMARK(BM_Parser)->Apply(ShapeArgs)->Unit(benchmark::kMillisecond);
+
+//////////////////////////////////////////////////////////////////////
+
+static void BM_GenerateCorpus(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(bench::GenerateCorpus({.bytes = kCorpusBytes}));
+  }
+  state.SetBytesProcessed(state.iterations() * kCorpusBytes);
+}
+
+BENCHMARK(BM_GenerateCorpus)->Unit(benchmark::kMillisecond);
+
+//////////////////////////////////////////////////////////////////////
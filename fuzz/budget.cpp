@@ -0,0 +1,216 @@
+#include <budget.hpp>
+
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include <new>
+#include <cerrno>
+#include <cstdint>
+#include <exception>
+#include <system_error>
+
+namespace fuzz {
+
+//////////////////////////////////////////////////////////////////////
+
+const char* FormatVerdict(Verdict verdict) {
+  switch (verdict) {
+    case Verdict::OK:
+      return "ok";
+    case Verdict::FAILED:
+      return "failed";
+    case Verdict::CRASHED:
+      return "crashed";
+    case Verdict::STACK_OVERFLOW:
+      return "stack overflow";
+    case Verdict::OUT_OF_MEMORY:
+      return "out of memory";
+    case Verdict::TIMEOUT:
+      return "timeout";
+  }
+  return "?";
+}
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Exit codes of the child
+enum : int {
+  kExitOk = 0,
+  kExitFailed = 70,
+  kExitOutOfMemory = 71,
+  kExitStackOverflow = 72,
+};
+
+// The guard page below the worker's stack, for the SIGSEGV handler
+uintptr_t guard_begin = 0;
+uintptr_t guard_end = 0;
+
+void OnSegv(int signal, siginfo_t* info, void*) {
+  auto address = reinterpret_cast<uintptr_t>(info->si_addr);
+  if (address >= guard_begin && address < guard_end) {
+    _exit(kExitStackOverflow);
+  }
+
+  // Anything else is a real crash: die of it
+  ::signal(signal, SIG_DFL);
+  ::raise(signal);
+}
+
+struct Job {
+  const std::function<void()>* work = nullptr;
+  int result = kExitOk;
+  std::chrono::nanoseconds elapsed{0};
+};
+
+void* RunJob(void* arg) {
+  auto& job = *static_cast<Job*>(arg);
+
+  // The handler cannot run on the stack that just overflowed
+  static char alternate[64 * 1024];
+  stack_t stack{};
+  stack.ss_sp = alternate;
+  stack.ss_size = sizeof(alternate);
+  sigaltstack(&stack, nullptr);
+
+  auto start = std::chrono::steady_clock::now();
+
+  try {
+    (*job.work)();
+  } catch (std::bad_alloc&) {
+    job.result = kExitOutOfMemory;
+  } catch (...) {
+    job.result = kExitFailed;
+  }
+
+  job.elapsed = std::chrono::steady_clock::now() - start;
+  return nullptr;
+}
+
+[[noreturn]] void RunChild(const Budget& budget,
+                           const std::function<void()>& work, int report) {
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t stack_size = (budget.stack + page - 1) / page * page;
+
+  // Stack first: it must not count against a tiny memory budget
+  auto base = static_cast<char*>(mmap(nullptr, stack_size + page,
+                                      PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (base == MAP_FAILED) {
+    _exit(kExitOutOfMemory);
+  }
+  mprotect(base, page, PROT_NONE);
+
+  guard_begin = reinterpret_cast<uintptr_t>(base);
+  guard_end = guard_begin + page;
+
+  struct sigaction action{};
+  action.sa_sigaction = OnSegv;
+  action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+  sigaction(SIGSEGV, &action, nullptr);
+
+  rlimit limit{budget.memory, budget.memory};
+  setrlimit(RLIMIT_AS, &limit);
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstack(&attr, base + page, stack_size);
+
+  Job job;
+  job.work = &work;
+
+  pthread_t thread;
+  if (pthread_create(&thread, &attr, RunJob, &job) != 0) {
+    _exit(kExitOutOfMemory);
+  }
+  pthread_join(thread, nullptr);
+
+  int64_t elapsed = job.elapsed.count();
+  [[maybe_unused]] auto written = ::write(report, &elapsed, sizeof(elapsed));
+
+  _exit(job.result);
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+Outcome RunWithBudget(const Budget& budget,
+                      const std::function<void()>& work) {
+  int fds[2];
+  if (::pipe(fds) < 0) {
+    throw std::system_error{errno, std::generic_category(), "pipe"};
+  }
+
+  pid_t pid = ::fork();
+  if (pid < 0) {
+    throw std::system_error{errno, std::generic_category(), "fork"};
+  }
+
+  if (pid == 0) {
+    ::close(fds[0]);
+    RunChild(budget, work, fds[1]);
+  }
+
+  ::close(fds[1]);
+
+  Outcome outcome;
+  int status = 0;
+
+  auto deadline = std::chrono::steady_clock::now() + budget.time;
+  while (true) {
+    if (::waitpid(pid, &status, WNOHANG) == pid) {
+      break;
+    }
+
+    if (std::chrono::steady_clock::now() > deadline) {
+      ::kill(pid, SIGKILL);
+      ::waitpid(pid, &status, 0);
+      ::close(fds[0]);
+
+      outcome.verdict = Verdict::TIMEOUT;
+      outcome.elapsed = budget.time;
+      return outcome;
+    }
+
+    ::usleep(200);
+  }
+
+  int64_t elapsed = 0;
+  if (::read(fds[0], &elapsed, sizeof(elapsed)) == sizeof(elapsed)) {
+    outcome.elapsed = std::chrono::nanoseconds{elapsed};
+  }
+  ::close(fds[0]);
+
+  if (WIFSIGNALED(status)) {
+    outcome.verdict = Verdict::CRASHED;
+    outcome.signal = WTERMSIG(status);
+    return outcome;
+  }
+
+  switch (WEXITSTATUS(status)) {
+    case kExitOk:
+      outcome.verdict = Verdict::OK;
+      break;
+    case kExitOutOfMemory:
+      outcome.verdict = Verdict::OUT_OF_MEMORY;
+      break;
+    case kExitStackOverflow:
+      outcome.verdict = Verdict::STACK_OVERFLOW;
+      break;
+    default:
+      outcome.verdict = Verdict::FAILED;
+      break;
+  }
+
+  return outcome;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace fuzz
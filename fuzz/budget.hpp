@@ -0,0 +1,54 @@
+#pragma once
+
+#include <functional>
+#include <cstddef>
+#include <chrono>
+
+namespace fuzz {
+
+//////////////////////////////////////////////////////////////////////
+
+// Runs one input through the front end in a child process with hard
+// limits, so that a performance cliff is reported as a failure of
+// that input instead of hanging or killing the harness.
+//
+//   auto outcome = RunWithBudget({}, [&] { ParseAll(source); });
+//   if (outcome.verdict == Verdict::STACK_OVERFLOW) ...
+//
+// The work runs on a thread with a stack of exactly `stack` bytes:
+// recursion depth is a property of the input, not of `ulimit -s`.
+// Not for sanitizer builds: ASan reserves far more address space
+// than any sensible `memory` limit.
+
+struct Budget {
+  std::chrono::milliseconds time{2000};
+  size_t memory = size_t{1} << 30;  // address space, bytes
+  size_t stack = size_t{8} << 20;
+};
+
+enum class Verdict {
+  OK,
+  FAILED,  // threw an exception
+  CRASHED,
+  STACK_OVERFLOW,
+  OUT_OF_MEMORY,
+  TIMEOUT,
+};
+
+const char* FormatVerdict(Verdict verdict);
+
+struct Outcome {
+  Verdict verdict = Verdict::OK;
+
+  // Of `work` alone, measured in the child; the time budget when
+  // it timed out
+  std::chrono::nanoseconds elapsed{0};
+
+  int signal = 0;  // CRASHED: the signal that killed the child
+};
+
+Outcome RunWithBudget(const Budget& budget, const std::function<void()>& work);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace fuzz
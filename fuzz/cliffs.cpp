@@ -0,0 +1,188 @@
+#include <front_end.hpp>
+#include <budget.hpp>
+
+#include <fmt/core.h>
+
+#include <string_view>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Performance cliffs of the front end.
+//
+// Each family below grows one dimension of an otherwise trivial
+// program: nesting depth, chain length, declaration count. Every size
+// must parse within the budget (no stack overflow at any depth), and
+// doubling the size must roughly double the time:
+//
+//   front-end-cliffs                  all families
+//   front-end-cliffs parens blocks    just those
+//   front-end-cliffs --max-exponent=1.3 --max-size=1000000
+
+//////////////////////////////////////////////////////////////////////
+
+struct Family {
+  const char* name;
+  std::string (*make)(size_t n);
+};
+
+static std::string Repeat(std::string_view text, size_t n) {
+  std::string result;
+  result.reserve(text.size() * n);
+  for (size_t i = 0; i < n; i++) {
+    result.append(text);
+  }
+  return result;
+}
+
+static const Family kFamilies[] = {
+    {"parens",
+     [](size_t n) {
+       return "fun f = " + Repeat("(", n) + "1" + Repeat(")", n) + ";\n";
+     }},
+    {"blocks",
+     [](size_t n) {
+       return "fun f = " + Repeat("{ ", n) + "1" + Repeat(" }", n) + ";\n";
+     }},
+    {"unary",
+     [](size_t n) {
+       return "fun f = " + Repeat("-", n) + "1;\n";
+     }},
+    {"calls",
+     [](size_t n) {
+       return "fun f x = " + Repeat("f(", n) + "1" + Repeat(")", n) + ";\n";
+     }},
+    {"if-chain",
+     [](size_t n) {
+       return "fun f x = " + Repeat("if x < 1 { 1 } else ", n) + "0;\n";
+     }},
+    {"binary-chain",
+     [](size_t n) {
+       return "fun f x = " + Repeat("x + ", n) + "1;\n";
+     }},
+    {"declarations",
+     [](size_t n) {
+       std::string text;
+       for (size_t i = 0; i < n; i++) {
+         text += fmt::format("fun f{} x = x + {};\n", i, i);
+       }
+       return text;
+     }},
+    {"comment",
+     [](size_t n) {
+       return "# " + Repeat("lorem ", n) + "\nfun f = 1;\n";
+     }},
+    {"identifier",
+     [](size_t n) {
+       return "fun " + Repeat("x", n) + " = 1;\n";
+     }},
+};
+
+//////////////////////////////////////////////////////////////////////
+
+struct Options {
+  std::vector<std::string> families;
+
+  size_t min_size = 1024;
+  size_t max_size = 1 << 18;
+
+  // Time ratio of the two largest sizes, as a power of their ratio
+  double max_exponent = 1.5;
+
+  fuzz::Budget budget;
+};
+
+// Below this the timer and fork noise swamp the ratio
+static constexpr auto kMeasurable = std::chrono::milliseconds{2};
+
+static bool CheckFamily(const Family& family, const Options& options) {
+  std::vector<std::pair<size_t, std::chrono::nanoseconds>> times;
+
+  for (size_t n = options.min_size; n <= options.max_size; n *= 2) {
+    auto source = family.make(n);
+
+    // Best of three: the ratio is what matters, not the noise
+    std::chrono::nanoseconds best = std::chrono::nanoseconds::max();
+
+    for (int run = 0; run < 3; run++) {
+      auto outcome = fuzz::RunWithBudget(options.budget, [&] {
+        fuzz::ParseAll(source);
+      });
+
+      if (outcome.verdict != fuzz::Verdict::OK) {
+        fmt::print("{}: {} at size {}\n", family.name,
+                   FormatVerdict(outcome.verdict), n);
+        return false;
+      }
+
+      best = std::min(best, outcome.elapsed);
+    }
+
+    times.emplace_back(n, best);
+  }
+
+  // Compare the two largest measurable sizes
+  auto last = times.size();
+  if (last < 2 || times[last - 2].second < kMeasurable) {
+    fmt::print("{}: ok (too fast to measure growth)\n", family.name);
+    return true;
+  }
+
+  auto [small_n, small_t] = times[last - 2];
+  auto [large_n, large_t] = times[last - 1];
+
+  auto exponent =
+      std::log(static_cast<double>(large_t.count()) / small_t.count()) /
+      std::log(static_cast<double>(large_n) / small_n);
+
+  bool ok = exponent <= options.max_exponent;
+  fmt::print("{}: {} (n = {}: {:.1f} ms, growth ~ n^{:.2f})\n", family.name,
+             ok ? "ok" : "SUPER-LINEAR", large_n, large_t.count() / 1e6,
+             exponent);
+
+  return ok;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+  Options options;
+
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg{argv[i]};
+
+    if (arg.starts_with("--max-exponent=")) {
+      options.max_exponent = std::stod(argv[i] + 15);
+    } else if (arg.starts_with("--max-size=")) {
+      options.max_size = std::stoull(argv[i] + 11);
+    } else if (arg.starts_with("--time-ms=")) {
+      options.budget.time = std::chrono::milliseconds{std::stoul(argv[i] + 10)};
+    } else if (arg.starts_with("--stack-kb=")) {
+      options.budget.stack = std::stoull(argv[i] + 11) << 10;
+    } else if (arg.starts_with("-")) {
+      fmt::print(stderr,
+                 "Usage: {} [--max-exponent=X] [--max-size=N] "
+                 "[--time-ms=N] [--stack-kb=N] [family...]\n",
+                 argv[0]);
+      return 2;
+    } else {
+      options.families.emplace_back(arg);
+    }
+  }
+
+  size_t failures = 0;
+
+  for (auto& family : kFamilies) {
+    bool selected =
+        options.families.empty() ||
+        std::find(options.families.begin(), options.families.end(),
+                  family.name) != options.families.end();
+
+    if (selected && !CheckFamily(family, options)) {
+      failures += 1;
+    }
+  }
+
+  return failures == 0 ? 0 : 1;
+}
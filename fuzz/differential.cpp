@@ -0,0 +1,126 @@
+#include <program_gen.hpp>
+
+#include <driver/process.hpp>
+
+#include <fmt/core.h>
+
+#include <string_view>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Differential testing of the whole compiler: generate a program,
+// compile it with etudec (through QBE), run it and compare the exit
+// status with what the generator's reference interpreter computed.
+//
+//   etude-difftest --etudec=build/app/etudec --count=1000 --seed=7
+//
+// A mismatching program is kept as <dir>/fail-<seed>.et; it can be
+// regenerated with --count=1 --seed=<seed>.
+//
+// Until the IR generator lands (driver::RunCodegen throws
+// NotImplementedError), etudec compiles nothing and every program is
+// counted as failed to compile: the harness is ready, its target is
+// not.
+
+namespace fs = std::filesystem;
+
+struct Options {
+  fs::path etudec;
+  fs::path dir = fs::temp_directory_path() / "etude-difftest";
+
+  size_t count = 100;
+  uint64_t seed = 1;
+
+  fuzz::GeneratorOptions generator;
+};
+
+int main(int argc, char** argv) {
+  Options options;
+
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg{argv[i]};
+
+    if (arg.starts_with("--etudec=")) {
+      options.etudec = arg.substr(9);
+    } else if (arg.starts_with("--dir=")) {
+      options.dir = arg.substr(6);
+    } else if (arg.starts_with("--count=")) {
+      options.count = std::stoull(argv[i] + 8);
+    } else if (arg.starts_with("--seed=")) {
+      options.seed = std::stoull(argv[i] + 7);
+    } else if (arg.starts_with("--functions=")) {
+      options.generator.functions = std::stoull(argv[i] + 12);
+    } else if (arg.starts_with("--depth=")) {
+      options.generator.depth = std::stoull(argv[i] + 8);
+    } else {
+      options.etudec.clear();
+      break;
+    }
+  }
+
+  if (options.etudec.empty()) {
+    fmt::print(stderr,
+               "Usage: {} --etudec=<path> [--dir=<scratch>] [--count=N] "
+               "[--seed=S] [--functions=N] [--depth=N]\n"
+               "Needs an etudec with the IR generator: without it every "
+               "program fails to compile.\n",
+               argv[0]);
+    return 2;
+  }
+
+  fs::create_directories(options.dir);
+
+  auto source = options.dir / "program.et";
+  auto binary = options.dir / "program";
+
+  size_t mismatches = 0;
+  size_t compile_failures = 0;
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < options.count; i++) {
+    auto generator = options.generator;
+    generator.seed = options.seed + i;
+
+    auto program = fuzz::GenerateProgram(generator);
+    std::ofstream{source} << program.source;
+
+    int status = driver::RunProcess(
+        {options.etudec, "-B", options.dir, "-o", binary, source});
+
+    if (status != 0) {
+      compile_failures += 1;
+    } else {
+      // The exit status is the low byte of what `main` returns
+      int expected = static_cast<uint8_t>(program.result);
+      int actual = driver::RunProcess({binary});
+
+      if (actual == expected) {
+        continue;
+      }
+
+      fmt::print("seed {}: expected {}, got {}\n", generator.seed, expected,
+                 actual);
+      mismatches += 1;
+    }
+
+    fs::copy_file(source, options.dir / fmt::format("fail-{}.et",
+                                                    generator.seed),
+                  fs::copy_options::overwrite_existing);
+  }
+
+  auto seconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+  fmt::print("{} programs, {} mismatches, {} failed to compile "
+             "({:.1f} programs/s)\n",
+             options.count, mismatches, compile_failures,
+             options.count / seconds);
+
+  return mismatches + compile_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#include <front_end.hpp>
+
+#include <parse/parse_error.hpp>
+#include <parse/parser.hpp>
+
+#include <sstream>
+#include <string>
+
+namespace fuzz {
+
+//////////////////////////////////////////////////////////////////////
+
+size_t LexAll(std::string_view source) {
+  std::stringstream stream{std::string{source}};
+  lex::Lexer lexer{stream};
+
+  size_t tokens = 0;
+  while (!lexer.Matches(lex::TokenType::TOKEN_EOF)) {
+    lexer.Advance();
+    tokens += 1;
+  }
+
+  return tokens;
+}
+
+size_t ParseAll(std::string_view source) {
+  std::stringstream stream{std::string{source}};
+  lex::Lexer lexer{stream};
+  Parser parser{lexer};
+
+  size_t declarations = 0;
+
+  try {
+    while (parser.ParseDeclaration()) {
+      declarations += 1;
+    }
+  } catch (parse::errors::ParseError&) {
+    // A rejected input is a fine outcome
+  }
+
+  return declarations;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace fuzz
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string_view>
+#include <cstddef>
+
+namespace fuzz {
+
+//////////////////////////////////////////////////////////////////////
+
+// What the fuzz targets and the cliff checks run on an input.
+// Diagnostics are expected and swallowed; crashes, hangs and
+// overflows are what is being looked for.
+
+// Tokens produced
+size_t LexAll(std::string_view source);
+
+// Declarations parsed before the end or the first parse error.
+// The AST does not own its nodes: they are leaked.
+size_t ParseAll(std::string_view source);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace fuzz
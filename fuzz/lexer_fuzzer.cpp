@@ -0,0 +1,11 @@
+#include <front_end.hpp>
+
+#include <cstdint>
+#include <cstddef>
+
+// libFuzzer entry point; see fuzz/CMakeLists.txt for how to run it
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  fuzz::LexAll({reinterpret_cast<const char*>(data), size});
+  return 0;
+}
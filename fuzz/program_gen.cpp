@@ -0,0 +1,284 @@
+#include <program_gen.hpp>
+
+#include <fmt/format.h>
+
+#include <memory>
+#include <vector>
+
+namespace fuzz {
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// splitmix64, as in bench/corpus.cpp: the same seed gives the same
+// program everywhere, so a failure can be replayed from its seed
+
+class Rng {
+ public:
+  explicit Rng(uint64_t seed) : state_{seed} {
+  }
+
+  uint64_t Next() {
+    uint64_t z = (state_ += 0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+  }
+
+  size_t Below(size_t bound) {
+    return Next() % bound;
+  }
+
+ private:
+  uint64_t state_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+struct Expr {
+  enum Kind {
+    LITERAL,
+    PARAM,  // value: index
+    NEG,
+    ADD,
+    SUB,
+    MUL,
+    DIV,  // rhs is a positive LITERAL
+    IF_LESS,  // if a < b { c } else { d }
+    CALL,  // value: function index
+  };
+
+  Kind kind = LITERAL;
+  int32_t value = 0;
+  std::vector<std::unique_ptr<Expr>> children;
+};
+
+int32_t Wrap(int64_t value) {
+  return static_cast<int32_t>(static_cast<uint32_t>(value));
+}
+
+struct Function {
+  size_t params = 0;
+  std::unique_ptr<Expr> body;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+class Generator {
+ public:
+  explicit Generator(const GeneratorOptions& options)
+      : options_{options}, rng_{options.seed} {
+  }
+
+  GeneratedProgram Run() {
+    for (size_t i = 0; i < options_.functions; i++) {
+      Function function;
+      function.params = rng_.Below(3);
+      function.body = Make(options_.depth, function.params);
+      functions_.push_back(std::move(function));
+    }
+
+    GeneratedProgram program;
+
+    for (size_t i = 0; i < functions_.size(); i++) {
+      auto& function = functions_[i];
+
+      Put("fun f{}", i);
+      for (size_t p = 0; p < function.params; p++) {
+        Put(" p{}", p);
+      }
+      Put(" = ");
+      Print(*function.body);
+      Put(";\n\n");
+    }
+
+    // `main` is the last one, called without arguments
+    auto main = Make(options_.depth, 0);
+    Put("fun main = ");
+    Print(*main);
+    Put(";\n");
+
+    program.source = fmt::to_string(out_);
+    program.result = Eval(*main, {});
+    return program;
+  }
+
+ private:
+  std::unique_ptr<Expr> Leaf(size_t params) {
+    auto leaf = std::make_unique<Expr>();
+    if (params > 0 && rng_.Below(2) == 0) {
+      leaf->kind = Expr::PARAM;
+      leaf->value = static_cast<int32_t>(rng_.Below(params));
+    } else {
+      leaf->value = static_cast<int32_t>(rng_.Below(2000)) - 1000;
+    }
+    return leaf;
+  }
+
+  std::unique_ptr<Expr> Make(size_t depth, size_t params) {
+    if (depth == 0) {
+      return Leaf(params);
+    }
+
+    auto expr = std::make_unique<Expr>();
+
+    switch (rng_.Below(8)) {
+      case 0:
+        return Leaf(params);
+
+      case 1:
+        expr->kind = Expr::NEG;
+        expr->children.push_back(Make(depth - 1, params));
+        return expr;
+
+      case 2:
+        if (!functions_.empty()) {
+          expr->kind = Expr::CALL;
+          expr->value = static_cast<int32_t>(rng_.Below(functions_.size()));
+          for (size_t p = 0; p < functions_[expr->value].params; p++) {
+            expr->children.push_back(Make(depth - 1, params));
+          }
+          return expr;
+        }
+        [[fallthrough]];
+
+      case 3:
+        expr->kind = Expr::IF_LESS;
+        for (int i = 0; i < 4; i++) {
+          expr->children.push_back(Make(depth - 1, params));
+        }
+        return expr;
+
+      case 4: {
+        expr->kind = Expr::DIV;
+        expr->children.push_back(Make(depth - 1, params));
+        auto divisor = std::make_unique<Expr>();
+        divisor->value = static_cast<int32_t>(1 + rng_.Below(100));
+        expr->children.push_back(std::move(divisor));
+        return expr;
+      }
+
+      default:
+        static const Expr::Kind binary[] = {Expr::ADD, Expr::SUB,
+                                            Expr::MUL};
+        expr->kind = binary[rng_.Below(3)];
+        expr->children.push_back(Make(depth - 1, params));
+        expr->children.push_back(Make(depth - 1, params));
+        return expr;
+    }
+  }
+
+  ////////////////////////////////////////////////////////////////////
+
+  template <typename... Args>
+  void Put(fmt::format_string<Args...> format, Args&&... args) {
+    fmt::format_to(std::back_inserter(out_), format,
+                   std::forward<Args>(args)...);
+  }
+
+  // Fully parenthesized: precedence is not what is being tested
+  void Print(const Expr& expr) {
+    auto& c = expr.children;
+
+    switch (expr.kind) {
+      case Expr::LITERAL:
+        // Negative literals as unary minus on a positive one
+        if (expr.value < 0) {
+          return Put("(-{})", -static_cast<int64_t>(expr.value));
+        }
+        return Put("{}", expr.value);
+
+      case Expr::PARAM:
+        return Put("p{}", expr.value);
+
+      case Expr::NEG:
+        Put("(-");
+        Print(*c[0]);
+        return Put(")");
+
+      case Expr::CALL:
+        Put("f{}(", expr.value);
+        for (size_t i = 0; i < c.size(); i++) {
+          if (i > 0) {
+            Put(", ");
+          }
+          Print(*c[i]);
+        }
+        return Put(")");
+
+      case Expr::IF_LESS:
+        Put("(if ");
+        Print(*c[0]);
+        Put(" < ");
+        Print(*c[1]);
+        Put(" {{ ");
+        Print(*c[2]);
+        Put(" }} else {{ ");
+        Print(*c[3]);
+        return Put(" }})");
+
+      default:
+        static const char* ops[] = {"", "", "", "+", "-", "*", "/"};
+        Put("(");
+        Print(*c[0]);
+        Put(" {} ", ops[expr.kind]);
+        Print(*c[1]);
+        return Put(")");
+    }
+  }
+
+  ////////////////////////////////////////////////////////////////////
+
+  // The reference interpreter
+  int32_t Eval(const Expr& expr, const std::vector<int32_t>& args) {
+    auto& c = expr.children;
+
+    switch (expr.kind) {
+      case Expr::LITERAL:
+        return expr.value;
+      case Expr::PARAM:
+        return args[expr.value];
+      case Expr::NEG:
+        return Wrap(-int64_t{Eval(*c[0], args)});
+      case Expr::ADD:
+        return Wrap(int64_t{Eval(*c[0], args)} + Eval(*c[1], args));
+      case Expr::SUB:
+        return Wrap(int64_t{Eval(*c[0], args)} - Eval(*c[1], args));
+      case Expr::MUL:
+        return Wrap(int64_t{Eval(*c[0], args)} * Eval(*c[1], args));
+      case Expr::DIV:
+        return Eval(*c[0], args) / Eval(*c[1], args);
+      case Expr::IF_LESS:
+        return Eval(*c[0], args) < Eval(*c[1], args) ? Eval(*c[2], args)
+                                                     : Eval(*c[3], args);
+      case Expr::CALL: {
+        std::vector<int32_t> values;
+        for (auto& arg : c) {
+          values.push_back(Eval(*arg, args));
+        }
+        return Eval(*functions_[expr.value].body, values);
+      }
+    }
+    return 0;
+  }
+
+ private:
+  const GeneratorOptions& options_;
+  Rng rng_;
+
+  std::vector<Function> functions_;
+  fmt::memory_buffer out_;
+};
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+GeneratedProgram GenerateProgram(const GeneratorOptions& options) {
+  return Generator{options}.Run();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace fuzz
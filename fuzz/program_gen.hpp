@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace fuzz {
+
+//////////////////////////////////////////////////////////////////////
+
+// Random, always well-defined Etude programs together with the value
+// `main` must return, for differential testing of the compiler.
+//
+// The generator keeps its own reference interpreter over the tree it
+// prints: Int is 32-bit two's complement with wrap-around, `/`
+// truncates and only ever divides by a positive literal. Functions
+// only call earlier ones, so every program terminates.
+
+struct GeneratedProgram {
+  std::string source;
+  int32_t result = 0;  // of `main`
+};
+
+struct GeneratorOptions {
+  uint64_t seed = 1;
+
+  size_t functions = 4;
+  size_t depth = 4;  // of each expression
+};
+
+GeneratedProgram GenerateProgram(const GeneratorOptions& options);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace fuzz
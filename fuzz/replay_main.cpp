@@ -0,0 +1,85 @@
+#include <budget.hpp>
+
+#include <fmt/core.h>
+
+#include <string_view>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Without libFuzzer (gcc, or a release build) a fuzz target becomes a
+// regression runner: every file given, or found in a directory given,
+// goes through the target under a budget.
+//
+//   parser-fuzzer --time-ms=500 --stack-kb=1024 crashes/ corpus/
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace fs = std::filesystem;
+
+static std::string ReadFile(const fs::path& path) {
+  std::ifstream file{path, std::ios::binary};
+  std::stringstream text;
+  text << file.rdbuf();
+  return text.str();
+}
+
+int main(int argc, char** argv) {
+  fuzz::Budget budget;
+  std::vector<fs::path> inputs;
+
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg{argv[i]};
+
+    if (arg.starts_with("--time-ms=")) {
+      budget.time = std::chrono::milliseconds{std::stoul(argv[i] + 10)};
+    } else if (arg.starts_with("--memory-mb=")) {
+      budget.memory = std::stoull(argv[i] + 12) << 20;
+    } else if (arg.starts_with("--stack-kb=")) {
+      budget.stack = std::stoull(argv[i] + 11) << 10;
+    } else if (fs::is_directory(arg)) {
+      for (auto& entry : fs::recursive_directory_iterator{arg}) {
+        if (entry.is_regular_file()) {
+          inputs.push_back(entry.path());
+        }
+      }
+    } else {
+      inputs.emplace_back(arg);
+    }
+  }
+
+  if (inputs.empty()) {
+    fmt::print(stderr,
+               "Usage: {} [--time-ms=N] [--memory-mb=N] [--stack-kb=N] "
+               "<file or dir>...\n",
+               argv[0]);
+    return 2;
+  }
+
+  size_t failures = 0;
+
+  for (auto& input : inputs) {
+    auto bytes = ReadFile(input);
+
+    auto outcome = fuzz::RunWithBudget(budget, [&] {
+      LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(bytes.data()),
+                             bytes.size());
+    });
+
+    // The target swallows diagnostics, so an exception is a bug too
+    if (outcome.verdict != fuzz::Verdict::OK) {
+      fmt::print("{}: {}", input.string(), FormatVerdict(outcome.verdict));
+      if (outcome.signal) {
+        fmt::print(" (signal {})", outcome.signal);
+      }
+      fmt::print("\n");
+      failures += 1;
+    }
+  }
+
+  fmt::print("{} inputs, {} failed\n", inputs.size(), failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+#include "etude_rt.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+//////////////////////////////////////////////////////////////////////
+
+enum {
+  kChunkSize = 1 << 20,
+
+  // Bigger objects get a chunk of their own, so they do not waste
+  // the rest of the current one
+  kLargeObject = kChunkSize / 4,
+};
+
+typedef struct Chunk {
+  struct Chunk* prev;
+  char* end;
+  // Objects follow, ETUDE_ALLOC_ALIGN aligned
+} Chunk;
+
+// Saved allocator position, itself allocated in the arena
+typedef struct Mark {
+  struct Mark* prev;
+  Chunk* chunk;
+  char* cursor;
+  size_t in_use;
+} Mark;
+
+typedef struct Arena {
+  Chunk* chunk;
+  char* cursor;
+  char* limit;
+
+  Mark* regions;
+
+  // One released chunk kept around: loops entering and leaving a
+  // region do not malloc and free a chunk every iteration
+  Chunk* spare;
+
+  size_t in_use;
+} Arena;
+
+static _Thread_local Arena arena;
+
+// Frees the spare chunk (which holds no objects) when a thread exits
+static pthread_key_t spare_key;
+static pthread_once_t spare_once = PTHREAD_ONCE_INIT;
+
+static void CreateSpareKey(void) {
+  pthread_key_create(&spare_key, free);
+}
+
+static void SetSpare(Chunk* chunk) {
+  pthread_once(&spare_once, CreateSpareKey);
+  pthread_setspecific(spare_key, chunk);
+  arena.spare = chunk;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static _Noreturn void OutOfMemory(size_t size) {
+  fprintf(stderr, "etude: out of memory (%zu bytes)\n", size);
+  abort();
+}
+
+// Callers keep `size` at most SIZE_MAX - kChunkSize, so neither this
+// nor adding the chunk header can wrap around
+static size_t AlignUp(size_t size) {
+  return (size + ETUDE_ALLOC_ALIGN - 1) & ~(size_t)(ETUDE_ALLOC_ALIGN - 1);
+}
+
+static char* ChunkStart(Chunk* chunk) {
+  return (char*)chunk + AlignUp(sizeof(Chunk));
+}
+
+static Chunk* NewChunk(size_t capacity) {
+  if (capacity == kChunkSize && arena.spare) {
+    Chunk* chunk = arena.spare;
+    SetSpare(NULL);
+    return chunk;
+  }
+
+  Chunk* chunk = aligned_alloc(ETUDE_ALLOC_ALIGN,
+                               AlignUp(sizeof(Chunk)) + capacity);
+  if (!chunk) {
+    OutOfMemory(capacity);
+  }
+
+  chunk->end = ChunkStart(chunk) + capacity;
+  return chunk;
+}
+
+static void FreeChunk(Chunk* chunk) {
+  if (!arena.spare && chunk->end - ChunkStart(chunk) == kChunkSize) {
+    SetSpare(chunk);
+  } else {
+    free(chunk);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Slow path: the current chunk is full (or there is none yet)
+static void* AllocSlow(size_t size) {
+  size_t capacity = size > kLargeObject ? size : kChunkSize;
+
+  Chunk* chunk = NewChunk(capacity);
+  chunk->prev = arena.chunk;
+  arena.chunk = chunk;
+
+  char* object = ChunkStart(chunk);
+
+  if (size > kLargeObject) {
+    // Nothing else fits; the next small object starts a new chunk
+    arena.cursor = arena.limit = chunk->end;
+  } else {
+    arena.cursor = object + size;
+    arena.limit = chunk->end;
+  }
+
+  arena.in_use += size;
+  return object;
+}
+
+void* etude_alloc(size_t size) {
+  if (size > SIZE_MAX - kChunkSize) {
+    OutOfMemory(size);
+  }
+
+  size = AlignUp(size ? size : 1);
+
+  if ((size_t)(arena.limit - arena.cursor) >= size) {
+    void* object = arena.cursor;
+    arena.cursor += size;
+    arena.in_use += size;
+    return object;
+  }
+
+  return AllocSlow(size);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void etude_region_enter(void) {
+  Chunk* chunk = arena.chunk;
+  char* cursor = arena.cursor;
+  size_t in_use = arena.in_use;
+
+  Mark* mark = etude_alloc(sizeof(Mark));
+
+  // The position from before the mark, so exit releases it as well
+  mark->prev = arena.regions;
+  mark->chunk = chunk;
+  mark->cursor = cursor;
+  mark->in_use = in_use;
+
+  arena.regions = mark;
+}
+
+void etude_region_exit(void) {
+  Mark* mark = arena.regions;
+  if (!mark) {
+    fprintf(stderr, "etude: region exit without a matching enter\n");
+    abort();
+  }
+
+  // Copy out first: the mark lives in memory about to be released
+  Mark saved = *mark;
+
+  while (arena.chunk != saved.chunk) {
+    Chunk* prev = arena.chunk->prev;
+    FreeChunk(arena.chunk);
+    arena.chunk = prev;
+  }
+
+  arena.cursor = saved.cursor;
+  arena.limit = saved.chunk ? saved.chunk->end : NULL;
+  arena.in_use = saved.in_use;
+  arena.regions = saved.prev;
+}
+
+size_t etude_alloc_in_use(void) {
+  return arena.in_use;
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+
+// Runtime support for programs compiled by etudec.
+//
+// etude_alloc is the target of `new` with `etudec --alloc=bump`:
+// every thread carves objects out of its own big chunks, so an
+// allocation is a pointer increment and a bounds check. There is no
+// individual free; memory is returned in bulk when a region ends:
+//
+//   etude_region_enter();
+//   ... millions of short-lived `new` ...
+//   etude_region_exit();   // all of it is gone
+//
+// Regions nest and belong to the thread that entered them. Objects
+// allocated outside of any region live until the program exits, even
+// if the thread that allocated them is gone.
+
+#define ETUDE_ALLOC_ALIGN 16
+
+// Never returns NULL: aborts when out of memory
+void* etude_alloc(size_t size);
+
+void etude_region_enter(void);
+void etude_region_exit(void);
+
+// Bytes handed out by this thread's allocator and not yet released
+size_t etude_alloc_in_use(void);
+
+//////////////////////////////////////////////////////////////////////
+
+// Profiling support for `etudec --instrument`.
+//
+// Each instrumented function owns a block of counters: how many times
+// it was entered, then how many times each arm of each branch site
+// (`if`, `match`) was taken. The generated code bumps them with plain
+// loads and stores, so counts from racing threads are approximate.
+//
+// The blocks of a module form a NULL-terminated array, and the arrays
+// of all the modules another one, `etude_prof_modules`, generated at
+// link time. At exit the counters are appended to the file named by
+// $ETUDE_PROFILE (default: etude.profile), one line per counter:
+//
+//   <module> <function> entry <count>
+//   <module> <function> <site>.<arm> <count>
+//
+// Appending lets several runs add up: `etudec --profile-use` sums
+// repeated lines.
+
+typedef struct EtudeProfFunction {
+  const char* module;
+  const char* name;
+  uint64_t* counters;     // entry, then the arms of site 0, site 1, ...
+  const uint32_t* arms;   // of each site
+  uint64_t sites;
+} EtudeProfFunction;
+
+// Appends the counters of `modules` (NULL-terminated arrays of
+// NULL-terminated arrays) to `path`. Returns 0 on success.
+int etude_prof_write(const char* path,
+                     const EtudeProfFunction* const* const* modules);
+
+// Installs the dump at exit; runs as a constructor. The generated
+// module list references it so that a static link pulls it in.
+void etude_prof_init(void);
+
+//////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+}
+#endif
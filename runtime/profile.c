@@ -0,0 +1,68 @@
+#include "etude_rt.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+//////////////////////////////////////////////////////////////////////
+
+// Defined by the module list etudec links into instrumented programs;
+// absent (NULL) everywhere else
+extern const EtudeProfFunction* const* const etude_prof_modules[]
+    __attribute__((weak));
+
+static void WriteFunction(FILE* file, const EtudeProfFunction* fun) {
+  const uint64_t* counter = fun->counters;
+
+  fprintf(file, "%s %s entry %" PRIu64 "\n", fun->module, fun->name,
+          *counter++);
+
+  for (uint64_t site = 0; site < fun->sites; site++) {
+    for (uint32_t arm = 0; arm < fun->arms[site]; arm++) {
+      fprintf(file, "%s %s %" PRIu64 ".%" PRIu32 " %" PRIu64 "\n",
+              fun->module, fun->name, site, arm, *counter++);
+    }
+  }
+}
+
+int etude_prof_write(const char* path,
+                     const EtudeProfFunction* const* const* modules) {
+  FILE* file = fopen(path, "a");
+  if (!file) {
+    return -1;
+  }
+
+  for (; *modules; modules++) {
+    for (const EtudeProfFunction* const* fun = *modules; *fun; fun++) {
+      // Never called in this run: nothing to say about its branches
+      if ((*fun)->counters[0] != 0) {
+        WriteFunction(file, *fun);
+      }
+    }
+  }
+
+  return fclose(file) == 0 ? 0 : -1;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static void DumpAtExit(void) {
+  const char* path = getenv("ETUDE_PROFILE");
+  if (!path || !*path) {
+    path = "etude.profile";
+  }
+
+  if (etude_prof_write(path, etude_prof_modules) != 0) {
+    fprintf(stderr, "etude: could not write profile to %s\n", path);
+  }
+}
+
+// Not static: the module list refers to it, which is what makes the
+// linker take this file out of libetude_rt.a at all
+__attribute__((constructor)) void etude_prof_init(void) {
+  if (etude_prof_modules) {
+    atexit(DumpAtExit);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
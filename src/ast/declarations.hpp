@@ -13,6 +13,9 @@ class Declaration : public Statement {
   virtual void Accept(Visitor*){};
 
   virtual std::string_view GetName() = 0;
+
+  // `export fun ...`: goes to the module interface
+  bool exported_ = false;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -28,3 +31,31 @@ class FunDeclStatement : public Declaration {
 };
 
 //////////////////////////////////////////////////////////////////////
+
+// import <module> ;
+
+class ImportDeclaration : public Declaration {
+ public:
+  ImportDeclaration(std::string_view module, lex::Location location)
+      : module_{module}, location_{location} {
+  }
+
+  virtual void Accept(Visitor*) override {
+    // visitor->VisitImportDecl(this);
+    std::abort();
+  }
+
+  virtual lex::Location GetLocation() override {
+    return location_;
+  }
+
+  virtual std::string_view GetName() override {
+    return module_;
+  }
+
+  // Owned: the declarations outlive the lexer that spelled the name
+  std::string module_;
+  lex::Location location_;
+};
+
+//////////////////////////////////////////////////////////////////////
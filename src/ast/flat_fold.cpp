@@ -0,0 +1,150 @@
+#include <ast/flat_fold.hpp>
+
+//////////////////////////////////////////////////////////////////////
+
+// Each returns whether the result is known and stores it in `out`
+
+static bool FoldUnary(FlatOp op, int64_t value, int64_t& out) {
+  switch (op) {
+    case FlatOp::NEG:
+      out = -static_cast<uint64_t>(value);
+      return true;
+    case FlatOp::NOT:
+      out = value == 0;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool FoldBinary(FlatOp op, int64_t lhs, int64_t rhs, int64_t& out) {
+  // Wrapping, like the generated code
+  auto ulhs = static_cast<uint64_t>(lhs);
+  auto urhs = static_cast<uint64_t>(rhs);
+
+  switch (op) {
+    case FlatOp::ADD:
+      out = ulhs + urhs;
+      return true;
+    case FlatOp::SUB:
+      out = ulhs - urhs;
+      return true;
+    case FlatOp::MUL:
+      out = ulhs * urhs;
+      return true;
+    case FlatOp::DIV:
+      if (rhs == 0 || (lhs == INT64_MIN && rhs == -1)) {
+        return false;
+      }
+      out = lhs / rhs;
+      return true;
+    case FlatOp::AND:
+      out = lhs != 0 && rhs != 0;
+      return true;
+    case FlatOp::OR:
+      out = lhs != 0 || rhs != 0;
+      return true;
+    case FlatOp::EQ:
+      out = lhs == rhs;
+      return true;
+    case FlatOp::NE:
+      out = lhs != rhs;
+      return true;
+    case FlatOp::LT:
+      out = lhs < rhs;
+      return true;
+    case FlatOp::LE:
+      out = lhs <= rhs;
+      return true;
+    case FlatOp::GT:
+      out = lhs > rhs;
+      return true;
+    case FlatOp::GE:
+      out = lhs >= rhs;
+      return true;
+    default:
+      return false;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+FoldedValues FoldConstants(const FlatTree& tree) {
+  auto kinds = tree.Kinds();
+  auto ops = tree.Ops();
+  auto data = tree.AllData();
+
+  FoldedValues result;
+  result.values_.resize(kinds.size());
+  result.known_.resize(kinds.size());
+
+  auto* values = result.values_.data();
+  auto* known = result.known_.data();
+
+  // Children precede their parents, so theirs are already final
+  for (FlatIndex i = 0; i < kinds.size(); i++) {
+    auto [lhs, rhs] = data[i];
+
+    switch (kinds[i]) {
+      case FlatKind::INT_LITERAL:
+        values[i] = tree.Int(i);
+        known[i] = true;
+        break;
+
+      case FlatKind::BOOL_LITERAL:
+        values[i] = lhs;
+        known[i] = true;
+        break;
+
+      case FlatKind::UNARY:
+        if (known[lhs]) {
+          known[i] = FoldUnary(ops[i], values[lhs], values[i]);
+        }
+        break;
+
+      case FlatKind::BINARY:
+      case FlatKind::COMPARISON:
+        if (known[lhs] && known[rhs]) {
+          known[i] = FoldBinary(ops[i], values[lhs], values[rhs], values[i]);
+        } else if (known[lhs]) {
+          // `false && x` and `true || x` do not need x
+          if (ops[i] == FlatOp::AND && values[lhs] == 0) {
+            values[i] = 0;
+            known[i] = true;
+          } else if (ops[i] == FlatOp::OR && values[lhs] != 0) {
+            values[i] = 1;
+            known[i] = true;
+          }
+        }
+        break;
+
+      case FlatKind::IF:
+        if (known[lhs]) {
+          auto branch = values[lhs] != 0 ? tree.Then(i) : tree.Else(i);
+          if (branch != kNoNode) {
+            values[i] = values[branch];
+            known[i] = known[branch];
+          }
+        }
+        break;
+
+      case FlatKind::BLOCK: {
+        // Only a block of nothing but its value: earlier items may
+        // have effects
+        auto items = tree.List(i);
+        if (items.size() == 1) {
+          values[i] = values[items[0]];
+          known[i] = known[items[0]];
+        }
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////
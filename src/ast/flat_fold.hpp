@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ast/flat_tree.hpp>
+
+#include <optional>
+#include <cstdint>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+
+// The values FoldConstants found, indexed like the tree. Kept as a
+// value array and a flag array rather than optionals: half the bytes
+// per node, and the sweep tests one byte per operand.
+class FoldedValues {
+ public:
+  size_t Size() const {
+    return values_.size();
+  }
+
+  bool Known(FlatIndex node) const {
+    return known_[node] != 0;
+  }
+
+  std::optional<int64_t> operator[](FlatIndex node) const {
+    if (!Known(node)) {
+      return std::nullopt;
+    }
+    return values_[node];
+  }
+
+ private:
+  friend FoldedValues FoldConstants(const FlatTree& tree);
+
+  std::vector<int64_t> values_;
+  std::vector<uint8_t> known_;
+};
+
+// Constant folding over a FlatTree: the value of every node whose
+// value is known at compile time. Booleans fold to 0 and 1. One
+// forward sweep, no recursion, no pointers.
+//
+// Variables are unknown, and so is anything that depends on one;
+// so are divisions by zero, which are left for the runtime to report.
+FoldedValues FoldConstants(const FlatTree& tree);
+
+//////////////////////////////////////////////////////////////////////
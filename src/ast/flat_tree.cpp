@@ -0,0 +1,273 @@
+#include <ast/flat_tree.hpp>
+
+#include <array>
+
+//////////////////////////////////////////////////////////////////////
+
+const char* FormatFlatKind(FlatKind kind) {
+  switch (kind) {
+    case FlatKind::INT_LITERAL:
+      return "INT_LITERAL";
+    case FlatKind::BOOL_LITERAL:
+      return "BOOL_LITERAL";
+    case FlatKind::STRING_LITERAL:
+      return "STRING_LITERAL";
+    case FlatKind::UNIT_LITERAL:
+      return "UNIT_LITERAL";
+    case FlatKind::VAR_ACCESS:
+      return "VAR_ACCESS";
+    case FlatKind::UNARY:
+      return "UNARY";
+    case FlatKind::BINARY:
+      return "BINARY";
+    case FlatKind::COMPARISON:
+      return "COMPARISON";
+    case FlatKind::FN_CALL:
+      return "FN_CALL";
+    case FlatKind::BLOCK:
+      return "BLOCK";
+    case FlatKind::IF:
+      return "IF";
+    case FlatKind::RETURN:
+      return "RETURN";
+    case FlatKind::EXPR_STATEMENT:
+      return "EXPR_STATEMENT";
+    case FlatKind::ASSIGNMENT:
+      return "ASSIGNMENT";
+    case FlatKind::VAR_DECL:
+      return "VAR_DECL";
+    case FlatKind::FUN_DECL:
+      return "FUN_DECL";
+    case FlatKind::IMPORT:
+      return "IMPORT";
+  }
+  return "?";
+}
+
+//////////////////////////////////////////////////////////////////////
+
+FlatIndex FlatTree::Add(FlatKind kind, FlatOp op, Data data,
+                        lex::Location location) {
+  FMT_ASSERT(kinds_.size() < kNoNode, "Flat tree is full");
+
+  kinds_.push_back(kind);
+  ops_.push_back(op);
+  data_.push_back(data);
+  locations_.push_back(location);
+
+  return static_cast<FlatIndex>(kinds_.size() - 1);
+}
+
+FlatIndex FlatTree::AddName(std::string_view name) {
+  names_.emplace_back(name);
+  return static_cast<FlatIndex>(names_.size() - 1);
+}
+
+FlatIndex FlatTree::AddExtra(std::span<const FlatIndex> items) {
+  auto slot = static_cast<FlatIndex>(extra_.size());
+  extra_.insert(extra_.end(), items.begin(), items.end());
+  return slot;
+}
+
+void FlatTree::Reserve(size_t nodes) {
+  kinds_.reserve(nodes);
+  ops_.reserve(nodes);
+  data_.reserve(nodes);
+  locations_.reserve(nodes);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+FlatIndex FlatTree::AddInt(int64_t value, lex::Location location) {
+  auto bits = static_cast<uint64_t>(value);
+  return Add(FlatKind::INT_LITERAL, FlatOp::NONE,
+             {static_cast<FlatIndex>(bits), static_cast<FlatIndex>(bits >> 32)},
+             location);
+}
+
+FlatIndex FlatTree::AddBool(bool value, lex::Location location) {
+  return Add(FlatKind::BOOL_LITERAL, FlatOp::NONE, {value, 0}, location);
+}
+
+FlatIndex FlatTree::AddString(std::string_view value,
+                              lex::Location location) {
+  return Add(FlatKind::STRING_LITERAL, FlatOp::NONE, {AddName(value), 0},
+             location);
+}
+
+FlatIndex FlatTree::AddUnit(lex::Location location) {
+  return Add(FlatKind::UNIT_LITERAL, FlatOp::NONE, {}, location);
+}
+
+FlatIndex FlatTree::AddVar(std::string_view name, lex::Location location) {
+  return Add(FlatKind::VAR_ACCESS, FlatOp::NONE, {AddName(name), 0},
+             location);
+}
+
+FlatIndex FlatTree::AddUnary(FlatOp op, FlatIndex operand,
+                             lex::Location location) {
+  CheckChild(operand);
+  return Add(FlatKind::UNARY, op, {operand, 0}, location);
+}
+
+FlatIndex FlatTree::AddBinary(FlatOp op, FlatIndex lhs, FlatIndex rhs,
+                              lex::Location location) {
+  CheckChild(lhs);
+  CheckChild(rhs);
+
+  auto kind = op >= FlatOp::EQ ? FlatKind::COMPARISON : FlatKind::BINARY;
+  return Add(kind, op, {lhs, rhs}, location);
+}
+
+FlatIndex FlatTree::AddCall(FlatIndex callee, std::span<const FlatIndex> args,
+                            lex::Location location) {
+  CheckChild(callee);
+  for (auto arg : args) {
+    CheckChild(arg);
+  }
+
+  auto slot = AddExtra(std::array{static_cast<FlatIndex>(args.size())});
+  AddExtra(args);
+  return Add(FlatKind::FN_CALL, FlatOp::NONE, {callee, slot}, location);
+}
+
+FlatIndex FlatTree::AddBlock(std::span<const FlatIndex> items,
+                             lex::Location location) {
+  for (auto item : items) {
+    CheckChild(item);
+  }
+
+  auto slot = AddExtra(std::array{static_cast<FlatIndex>(items.size())});
+  AddExtra(items);
+  return Add(FlatKind::BLOCK, FlatOp::NONE, {slot, 0}, location);
+}
+
+FlatIndex FlatTree::AddIf(FlatIndex condition, FlatIndex then,
+                          FlatIndex otherwise, lex::Location location) {
+  CheckChild(condition);
+  CheckChild(then);
+  if (otherwise != kNoNode) {
+    CheckChild(otherwise);
+  }
+
+  auto slot = AddExtra(std::array{then, otherwise});
+  return Add(FlatKind::IF, FlatOp::NONE, {condition, slot}, location);
+}
+
+FlatIndex FlatTree::AddReturn(FlatIndex value, lex::Location location) {
+  if (value != kNoNode) {
+    CheckChild(value);
+  }
+  return Add(FlatKind::RETURN, FlatOp::NONE, {value, 0}, location);
+}
+
+FlatIndex FlatTree::AddExprStatement(FlatIndex expr, lex::Location location) {
+  CheckChild(expr);
+  return Add(FlatKind::EXPR_STATEMENT, FlatOp::NONE, {expr, 0}, location);
+}
+
+FlatIndex FlatTree::AddAssignment(FlatIndex target, FlatIndex value,
+                                  lex::Location location) {
+  CheckChild(target);
+  CheckChild(value);
+  return Add(FlatKind::ASSIGNMENT, FlatOp::NONE, {target, value}, location);
+}
+
+FlatIndex FlatTree::AddVarDecl(std::string_view name, FlatIndex value,
+                               lex::Location location) {
+  CheckChild(value);
+  return Add(FlatKind::VAR_DECL, FlatOp::NONE, {AddName(name), value},
+             location);
+}
+
+FlatIndex FlatTree::AddFunDecl(std::string_view name,
+                               std::span<const std::string_view> params,
+                               FlatIndex body, lex::Location location) {
+  CheckChild(body);
+
+  auto slot = AddExtra(std::array{static_cast<FlatIndex>(params.size())});
+  for (auto param : params) {
+    AddExtra(std::array{AddName(param)});
+  }
+  AddExtra(std::array{body});
+
+  return Add(FlatKind::FUN_DECL, FlatOp::NONE, {AddName(name), slot},
+             location);
+}
+
+FlatIndex FlatTree::AddImport(std::string_view module,
+                              lex::Location location) {
+  return Add(FlatKind::IMPORT, FlatOp::NONE, {AddName(module), 0}, location);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::string_view FlatTree::Name(FlatIndex node) const {
+  switch (kinds_[node]) {
+    case FlatKind::STRING_LITERAL:
+    case FlatKind::VAR_ACCESS:
+    case FlatKind::VAR_DECL:
+    case FlatKind::FUN_DECL:
+    case FlatKind::IMPORT:
+      return names_[data_[node].lhs];
+    default:
+      break;
+  }
+
+  FMT_ASSERT(false, "Node has no name");
+  return {};
+}
+
+std::span<const FlatIndex> FlatTree::List(FlatIndex node) const {
+  FlatIndex slot = 0;
+  switch (kinds_[node]) {
+    case FlatKind::FN_CALL:
+      slot = data_[node].rhs;
+      break;
+    case FlatKind::BLOCK:
+      slot = data_[node].lhs;
+      break;
+    default:
+      FMT_ASSERT(false, "Node has no list");
+      return {};
+  }
+  return {extra_.data() + slot + 1, extra_[slot]};
+}
+
+FlatIndex FlatTree::Then(FlatIndex node) const {
+  FMT_ASSERT(kinds_[node] == FlatKind::IF, "Not an if");
+  return extra_[data_[node].rhs];
+}
+
+FlatIndex FlatTree::Else(FlatIndex node) const {
+  FMT_ASSERT(kinds_[node] == FlatKind::IF, "Not an if");
+  return extra_[data_[node].rhs + 1];
+}
+
+std::vector<std::string_view> FlatTree::Params(FlatIndex node) const {
+  FMT_ASSERT(kinds_[node] == FlatKind::FUN_DECL, "Not a function");
+
+  auto slot = data_[node].rhs;
+  std::vector<std::string_view> params;
+  for (FlatIndex i = 0; i < extra_[slot]; i++) {
+    params.push_back(names_[extra_[slot + 1 + i]]);
+  }
+  return params;
+}
+
+FlatIndex FlatTree::Body(FlatIndex node) const {
+  FMT_ASSERT(kinds_[node] == FlatKind::FUN_DECL, "Not a function");
+
+  auto slot = data_[node].rhs;
+  return extra_[slot + 1 + extra_[slot]];
+}
+
+size_t FlatTree::CountChildren(FlatIndex node) const {
+  size_t count = 0;
+  ForEachChild(node, [&](FlatIndex) {
+    count += 1;
+  });
+  return count;
+}
+
+//////////////////////////////////////////////////////////////////////
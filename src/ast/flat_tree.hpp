@@ -0,0 +1,333 @@
+#pragma once
+
+#include <ast/visitors/post_order.hpp>
+#include <ast/syntax_tree.hpp>
+
+#include <lex/location.hpp>
+
+#include <fmt/core.h>
+
+#include <string_view>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <span>
+
+//////////////////////////////////////////////////////////////////////
+
+// The same program as the TreeNode classes, laid out for passes that
+// touch every node: one entry per node in a few parallel arrays, and
+// 32-bit indices instead of pointers. A node is always added after its
+// children, so index order is a post-order and a bottom-up pass is a
+// single forward sweep over the arrays.
+
+using FlatIndex = uint32_t;
+
+inline constexpr FlatIndex kNoNode = UINT32_MAX;
+
+enum class FlatKind : uint8_t {
+  INT_LITERAL,     // lhs, rhs: low and high half of the value
+  BOOL_LITERAL,    // lhs: 0 or 1
+  STRING_LITERAL,  // lhs: `names` slot
+  UNIT_LITERAL,
+  VAR_ACCESS,      // lhs: `names` slot
+  UNARY,           // op, lhs: operand
+  BINARY,          // op, lhs, rhs
+  COMPARISON,      // op, lhs, rhs
+  FN_CALL,         // lhs: callee, rhs: `extra` slot of [count, args...]
+  BLOCK,           // lhs: `extra` slot of [count, items...]
+  IF,              // lhs: condition, rhs: `extra` slot of [then, else]
+  RETURN,          // lhs: value or kNoNode
+  EXPR_STATEMENT,  // lhs: expression
+  ASSIGNMENT,      // lhs: target, rhs: value
+  VAR_DECL,        // lhs: `names` slot, rhs: value
+  FUN_DECL,        // lhs: `names` slot, rhs: `extra` slot of
+                   //   [params, param names..., body]
+  IMPORT,          // lhs: `names` slot
+};
+
+enum class FlatOp : uint8_t {
+  NONE,
+
+  // Arithmetic and logic
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  NEG,
+  NOT,
+  AND,
+  OR,
+
+  // Comparison
+  EQ,
+  NE,
+  LT,
+  LE,
+  GT,
+  GE,
+};
+
+const char* FormatFlatKind(FlatKind kind);
+
+//////////////////////////////////////////////////////////////////////
+
+class FlatTree {
+ public:
+  // Two words per node; what does not fit goes to the side tables
+  struct Data {
+    FlatIndex lhs = 0;
+    FlatIndex rhs = 0;
+  };
+
+  // Building: children first. Each returns the new node's index.
+
+  FlatIndex AddInt(int64_t value, lex::Location location = {});
+  FlatIndex AddBool(bool value, lex::Location location = {});
+  FlatIndex AddString(std::string_view value, lex::Location location = {});
+  FlatIndex AddUnit(lex::Location location = {});
+  FlatIndex AddVar(std::string_view name, lex::Location location = {});
+
+  FlatIndex AddUnary(FlatOp op, FlatIndex operand,
+                     lex::Location location = {});
+  FlatIndex AddBinary(FlatOp op, FlatIndex lhs, FlatIndex rhs,
+                      lex::Location location = {});
+
+  FlatIndex AddCall(FlatIndex callee, std::span<const FlatIndex> args,
+                    lex::Location location = {});
+  FlatIndex AddBlock(std::span<const FlatIndex> items,
+                     lex::Location location = {});
+  FlatIndex AddIf(FlatIndex condition, FlatIndex then, FlatIndex otherwise,
+                  lex::Location location = {});
+  FlatIndex AddReturn(FlatIndex value, lex::Location location = {});
+
+  FlatIndex AddExprStatement(FlatIndex expr, lex::Location location = {});
+  FlatIndex AddAssignment(FlatIndex target, FlatIndex value,
+                          lex::Location location = {});
+  FlatIndex AddVarDecl(std::string_view name, FlatIndex value,
+                       lex::Location location = {});
+  FlatIndex AddFunDecl(std::string_view name,
+                       std::span<const std::string_view> params,
+                       FlatIndex body, lex::Location location = {});
+  FlatIndex AddImport(std::string_view module, lex::Location location = {});
+
+  void Reserve(size_t nodes);
+
+  // Reading
+
+  size_t Size() const {
+    return kinds_.size();
+  }
+
+  FlatKind Kind(FlatIndex node) const {
+    return kinds_[node];
+  }
+
+  FlatOp Op(FlatIndex node) const {
+    return ops_[node];
+  }
+
+  Data At(FlatIndex node) const {
+    return data_[node];
+  }
+
+  lex::Location GetLocation(FlatIndex node) const {
+    return locations_[node];
+  }
+
+  // Whole arrays, for passes that sweep them
+  std::span<const FlatKind> Kinds() const {
+    return kinds_;
+  }
+
+  std::span<const FlatOp> Ops() const {
+    return ops_;
+  }
+
+  std::span<const Data> AllData() const {
+    return data_;
+  }
+
+  int64_t Int(FlatIndex node) const {
+    FMT_ASSERT(kinds_[node] == FlatKind::INT_LITERAL, "Not an integer");
+    auto [low, high] = data_[node];
+    return static_cast<int64_t>(uint64_t{high} << 32 | low);
+  }
+
+  bool Bool(FlatIndex node) const {
+    FMT_ASSERT(kinds_[node] == FlatKind::BOOL_LITERAL, "Not a bool");
+    return data_[node].lhs != 0;
+  }
+
+  // STRING_LITERAL, VAR_ACCESS, VAR_DECL, FUN_DECL, IMPORT
+  std::string_view Name(FlatIndex node) const;
+
+  // FN_CALL arguments, BLOCK items
+  std::span<const FlatIndex> List(FlatIndex node) const;
+
+  // IF
+  FlatIndex Then(FlatIndex node) const;
+  FlatIndex Else(FlatIndex node) const;
+
+  // FUN_DECL
+  std::vector<std::string_view> Params(FlatIndex node) const;
+  FlatIndex Body(FlatIndex node) const;
+
+  // Sub-trees, left to right; absent ones (kNoNode) are skipped
+  template <typename Fn>
+  void ForEachChild(FlatIndex node, Fn&& fn) const;
+
+  size_t CountChildren(FlatIndex node) const;
+
+ private:
+  FlatIndex Add(FlatKind kind, FlatOp op, Data data, lex::Location location);
+
+  FlatIndex AddName(std::string_view name);
+  FlatIndex AddExtra(std::span<const FlatIndex> items);
+
+  void CheckChild(FlatIndex child) const {
+    FMT_ASSERT(child < kinds_.size(), "Flat tree child added after parent");
+  }
+
+ private:
+  // One entry per node. Locations are only for diagnostics, so they
+  // stay out of the arrays the passes sweep.
+  std::vector<FlatKind> kinds_;
+  std::vector<FlatOp> ops_;
+  std::vector<Data> data_;
+  std::vector<lex::Location> locations_;
+
+  // Side tables. Names are copied in: the tree outlives the source
+  // and the TreeNodes it was made from. A deque never moves them, so
+  // the views Name() hands out stay valid as the tree grows.
+  std::deque<std::string> names_;
+  std::vector<FlatIndex> extra_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+template <typename Fn>
+void FlatTree::ForEachChild(FlatIndex node, Fn&& fn) const {
+  auto [lhs, rhs] = data_[node];
+
+  auto child = [&](FlatIndex index) {
+    if (index != kNoNode) {
+      fn(index);
+    }
+  };
+
+  switch (kinds_[node]) {
+    case FlatKind::INT_LITERAL:
+    case FlatKind::BOOL_LITERAL:
+    case FlatKind::STRING_LITERAL:
+    case FlatKind::UNIT_LITERAL:
+    case FlatKind::VAR_ACCESS:
+    case FlatKind::IMPORT:
+      break;
+
+    case FlatKind::UNARY:
+    case FlatKind::RETURN:
+    case FlatKind::EXPR_STATEMENT:
+      child(lhs);
+      break;
+
+    case FlatKind::BINARY:
+    case FlatKind::COMPARISON:
+    case FlatKind::ASSIGNMENT:
+      child(lhs);
+      child(rhs);
+      break;
+
+    case FlatKind::VAR_DECL:
+      child(rhs);
+      break;
+
+    case FlatKind::FN_CALL:
+      child(lhs);
+      for (auto arg : List(node)) {
+        child(arg);
+      }
+      break;
+
+    case FlatKind::BLOCK:
+      for (auto item : List(node)) {
+        child(item);
+      }
+      break;
+
+    case FlatKind::IF:
+      child(lhs);
+      child(extra_[rhs]);
+      child(extra_[rhs + 1]);
+      break;
+
+    case FlatKind::FUN_DECL:
+      child(Body(node));
+      break;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Conversion from and to the TreeNode classes. The mapping of one
+// class to one flat node lives with the classes; these do the walk.
+
+// `lower(tree, node, children)` adds `node` to `tree` given the flat
+// indices of its children (as AppendChildren lists them) and returns
+// its index. Works on trees of any depth.
+template <typename Lower>
+FlatIndex Flatten(TreeNode* root, FlatTree& tree, Lower&& lower) {
+  FMT_ASSERT(root, "Flattening a null tree");
+
+  std::vector<FlatIndex> done;
+
+  ForEachPostOrder(root, [&](TreeNode* node, size_t children) {
+    auto first = done.end() - children;
+    auto index = lower(tree, node, std::span<const FlatIndex>{first, done.end()});
+    done.erase(first, done.end());
+    done.push_back(index);
+  });
+
+  return done.back();
+}
+
+// `build(tree, index, children)` makes the TreeNode for flat node
+// `index` from the TreeNodes of its children (as ForEachChild lists
+// them). Only the nodes under `root` are built, each once.
+template <typename Build>
+TreeNode* Inflate(const FlatTree& tree, FlatIndex root, Build&& build) {
+  FMT_ASSERT(root < tree.Size(), "Inflating a node that does not exist");
+
+  // Children come before their parents: one backward sweep marks the
+  // sub-tree, one forward sweep builds it
+  std::vector<bool> wanted(root + 1, false);
+  wanted[root] = true;
+  for (size_t i = root + 1; i-- > 0;) {
+    if (wanted[i]) {
+      tree.ForEachChild(i, [&](FlatIndex child) {
+        wanted[child] = true;
+      });
+    }
+  }
+
+  std::vector<TreeNode*> built(root + 1, nullptr);
+  std::vector<TreeNode*> children;
+
+  for (FlatIndex i = 0; i <= root; i++) {
+    if (!wanted[i]) {
+      continue;
+    }
+
+    children.clear();
+    tree.ForEachChild(i, [&](FlatIndex child) {
+      children.push_back(built[child]);
+    });
+
+    built[i] = build(tree, i, std::span<TreeNode* const>{children});
+  }
+
+  return built[root];
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -4,14 +4,28 @@
 
 #include <lex/location.hpp>
 
+#include <stats/stats.hpp>
+
+#include <vector>
+
 //////////////////////////////////////////////////////////////////////
 
 class TreeNode {
  public:
+  TreeNode() {
+    stats::Count(stats::Counter::AST_NODES);
+  }
+
   virtual void Accept(Visitor* visitor) = 0;
 
   virtual lex::Location GetLocation() = 0;
 
+  // Direct sub-trees, left to right, for the iterative traversals in
+  // ast/visitors/post_order.hpp; leaves keep the default
+  virtual void AppendChildren(std::vector<TreeNode*>& /*children*/) {
+  }
+
+  // Does not delete the children: see DestroyTree
   virtual ~TreeNode() = default;
 
   template <typename T>
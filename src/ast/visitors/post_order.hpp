@@ -0,0 +1,73 @@
+#pragma once
+
+#include <ast/syntax_tree.hpp>
+
+#include <type_traits>
+#include <cstddef>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+
+// Traversals that keep their stack on the heap: a 100k-deep
+// expression costs memory, not a stack overflow. Children come from
+// TreeNode::AppendChildren.
+
+// Calls `visit(node)` for every node, children before their parent,
+// siblings left to right. `visit(node, children)` also gets the number
+// of (non-null) children visited just before it.
+template <typename Visit>
+void ForEachPostOrder(TreeNode* root, Visit&& visit) {
+  if (!root) {
+    return;
+  }
+
+  struct Entry {
+    TreeNode* node;
+    size_t children;  // SIZE_MAX until expanded
+  };
+
+  std::vector<Entry> stack{{root, SIZE_MAX}};
+  std::vector<TreeNode*> children;
+
+  while (!stack.empty()) {
+    auto& top = stack.back();
+
+    if (top.children != SIZE_MAX) {
+      auto [node, count] = top;
+      stack.pop_back();
+
+      if constexpr (std::is_invocable_v<Visit, TreeNode*, size_t>) {
+        visit(node, count);
+      } else {
+        visit(node);
+      }
+      continue;
+    }
+
+    children.clear();
+    top.node->AppendChildren(children);
+
+    size_t count = 0;
+    for (auto child : children) {
+      count += child != nullptr;
+    }
+    top.children = count;  // `top` dangles after the pushes
+
+    // Reversed, so that the leftmost child is on top
+    for (auto it = children.rbegin(); it != children.rend(); ++it) {
+      if (*it) {
+        stack.push_back({*it, SIZE_MAX});
+      }
+    }
+  }
+}
+
+// Deletes a tree of any depth. Nodes do not delete their children,
+// so each one goes exactly once, after its children.
+inline void DestroyTree(TreeNode* root) {
+  ForEachPostOrder(root, [](TreeNode* node) {
+    delete node;
+  });
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -1,10 +1,14 @@
 #pragma once
 
 #include <ast/visitors/abort_visitor.hpp>
+#include <ast/visitors/post_order.hpp>
 #include <ast/syntax_tree.hpp>
 
 #include <fmt/core.h>
 
+#include <utility>
+#include <vector>
+
 //////////////////////////////////////////////////////////////////////
 
 template <typename T>
@@ -12,13 +16,56 @@ class ReturnVisitor : public AbortVisitor {
  public:
   T Eval(TreeNode* expr) {
     FMT_ASSERT(expr, "Error: evaluating null expression");
+
+    // Inside EvalIteratively: the children are already done
+    if (window_ > 0) [[unlikely]] {
+      for (size_t i = results_.size() - window_; i < results_.size(); i++) {
+        if (results_[i].first == expr) {
+          return results_[i].second;
+        }
+      }
+    }
+
     expr->Accept(this);
     return return_value;
   }
 
+  // Same result as `Eval` on trees of any depth. Sub-trees are
+  // evaluated bottom-up first, so by the time a Visit method calls
+  // `Eval(child)` the answer is a lookup, not a recursive call.
+  // Only for passes where a node's result depends on nothing but
+  // its children's (each node is visited exactly once).
+  T EvalIteratively(TreeNode* root) {
+    FMT_ASSERT(root, "Error: evaluating null expression");
+
+    struct Reset {
+      ReturnVisitor& visitor;
+      ~Reset() {
+        visitor.results_.clear();
+        visitor.window_ = 0;
+      }
+    } reset{*this};
+
+    ForEachPostOrder(root, [this](TreeNode* node, size_t children) {
+      window_ = children;
+      node->Accept(this);
+      window_ = 0;
+
+      results_.resize(results_.size() - children);
+      results_.emplace_back(node, std::move(return_value));
+    });
+
+    return std::move(results_.back().second);
+  }
+
  protected:
   T return_value;
+
+ private:
+  // Results of the nodes whose parent is not visited yet; the last
+  // `window_` are the children of the node being visited
+  std::vector<std::pair<TreeNode*, T>> results_;
+  size_t window_ = 0;
 };
 
 //////////////////////////////////////////////////////////////////////
-
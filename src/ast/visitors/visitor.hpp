@@ -35,6 +35,7 @@ class FunDeclaration;
 class TypeDeclaration;
 class ImplDeclaration;
 class TraitDeclaration;
+class ImportDeclaration;
 
 //////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,339 @@
+#include <coro/coroutine.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace coro {
+
+//////////////////////////////////////////////////////////////////////
+
+// Scalars are 1, 2, 4 or 8 bytes; aggregates are bytes of any size
+static std::string SlotType(size_t size, bool aggregate = false) {
+  if (aggregate) {
+    return fmt::format("b {}", size);
+  }
+
+  switch (size) {
+    case 1:
+      return "b";
+    case 2:
+      return "h";
+    case 4:
+      return "w";
+    case 8:
+      return "l";
+    default:
+      FMT_ASSERT(false, "No scalar of this size");
+      return {};
+  }
+}
+
+static std::string_view ScalarClass(size_t size) {
+  return size <= 4 ? "w" : "l";
+}
+
+//////////////////////////////////////////////////////////////////////
+
+FrameLayout ComputeFrame(std::span<const Local> locals,
+                         std::span<const size_t> params,
+                         std::span<const SuspendPoint> suspends,
+                         size_t value_size, size_t value_align,
+                         bool value_aggregate) {
+  // Entry counts as a suspension: the parameters wait in the frame
+  // until the first resume
+  std::vector<std::span<const size_t>> points{params};
+  for (auto& suspend : suspends) {
+    points.emplace_back(suspend.live);
+  }
+
+  // Locals live at the same point interfere
+  std::vector<std::vector<bool>> interferes(
+      locals.size(), std::vector<bool>(locals.size()));
+  std::vector<bool> saved(locals.size());
+
+  for (auto live : points) {
+    for (auto a : live) {
+      saved[a] = true;
+      for (auto b : live) {
+        interferes[a][b] = true;
+      }
+    }
+  }
+
+  // An aggregate is in its slot from the start of the body to the
+  // end, not just at the yields: it shares with nothing
+  for (size_t a = 0; a < locals.size(); a++) {
+    if (saved[a] && locals[a].aggregate) {
+      for (size_t b = 0; b < locals.size(); b++) {
+        interferes[a][b] = interferes[b][a] = true;
+      }
+    }
+  }
+
+  // Greedy coloring, biggest first so that slots are shared by
+  // scalars of similar size
+  std::vector<size_t> order(locals.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return locals[a].size > locals[b].size;
+  });
+
+  std::vector<std::vector<size_t>> slots;  // locals in each slot
+  std::vector<size_t> slot_of(locals.size(), FrameLayout::kNoSlot);
+
+  for (auto local : order) {
+    if (!saved[local]) {
+      continue;
+    }
+
+    auto fits = [&](const std::vector<size_t>& members) {
+      return std::none_of(members.begin(), members.end(), [&](size_t m) {
+        return interferes[local][m];
+      });
+    };
+
+    auto slot = std::find_if(slots.begin(), slots.end(), fits);
+    if (slot == slots.end()) {
+      slot = slots.emplace(slots.end());
+    }
+
+    slot->push_back(local);
+    slot_of[local] = slot - slots.begin();
+  }
+
+  // The frame is a struct: state, value, slots
+  std::vector<layout::FieldSpec> fields;
+  fields.push_back({"state", 4, 4, "w"});
+  if (value_size > 0) {
+    fields.push_back({"value", value_size, value_align,
+                      SlotType(value_size, value_aggregate)});
+  }
+
+  for (size_t i = 0; i < slots.size(); i++) {
+    size_t size = 0;
+    size_t align = 1;
+    for (auto local : slots[i]) {
+      size = std::max(size, locals[local].size);
+      align = std::max(align, locals[local].align);
+    }
+    // An aggregate is alone in its slot
+    bool aggregate = locals[slots[i].front()].aggregate;
+    fields.push_back({fmt::format("slot.{}", i), size, align,
+                      SlotType(size, aggregate)});
+  }
+
+  FrameLayout result;
+  result.done = static_cast<uint32_t>(suspends.size() + 1);
+  result.frame = layout::ComputeLayout(fields);
+  result.state_offset = result.frame.Find("state")->offset;
+
+  if (auto* value = result.frame.Find("value")) {
+    result.value_offset = value->offset;
+    result.value_size = value_size;
+    result.value_aggregate = value_aggregate;
+  }
+
+  result.slot_offsets.resize(locals.size(), FrameLayout::kNoSlot);
+  for (size_t local = 0; local < locals.size(); local++) {
+    if (slot_of[local] != FrameLayout::kNoSlot) {
+      auto slot = fmt::format("slot.{}", slot_of[local]);
+      result.slot_offsets[local] = result.frame.Find(slot)->offset;
+    }
+  }
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+CoroutineLowering::CoroutineLowering(std::string_view name,
+                                     const FrameLayout& frame,
+                                     std::span<const Local> locals,
+                                     std::span<const size_t> params,
+                                     std::span<const SuspendPoint> suspends,
+                                     qbe::IrEmitter& out, FreshTemp fresh)
+    : name_{name},
+      frame_{frame},
+      locals_{locals},
+      params_{params},
+      suspends_{suspends},
+      out_{out},
+      fresh_{std::move(fresh)} {
+}
+
+//////////////////////////////////////////////////////////////////////
+
+qbe::QbeValue CoroutineLowering::Address(size_t offset) {
+  if (offset == 0) {
+    return frame_ptr_;
+  }
+
+  auto address = fresh_();
+  out_.EmitInstr("{} =l add {}, {}", address, frame_ptr_, offset);
+  return address;
+}
+
+void CoroutineLowering::Store(qbe::QbeValue value, size_t size,
+                              size_t offset) {
+  auto address = Address(offset);
+  out_.EmitInstr("store{} {}, {}", SlotType(size), value, address);
+}
+
+void CoroutineLowering::Copy(qbe::QbeValue value, size_t size,
+                             size_t offset) {
+  auto address = Address(offset);
+  out_.EmitInstr("blit {}, {}, {}", value, address, size);
+}
+
+void CoroutineLowering::Load(qbe::QbeValue dst, size_t size,
+                             size_t offset) {
+  auto address = Address(offset);
+
+  switch (size) {
+    case 1:
+      out_.EmitInstr("{} =w loadub {}", dst, address);
+      break;
+    case 2:
+      out_.EmitInstr("{} =w loaduh {}", dst, address);
+      break;
+    case 4:
+    case 8:
+      out_.EmitInstr("{} ={} load{} {}", dst, ScalarClass(size),
+                     ScalarClass(size), address);
+      break;
+    default:
+      FMT_ASSERT(false, "No scalar of this size");
+  }
+}
+
+void CoroutineLowering::SlotAddress(qbe::QbeValue dst, size_t local) {
+  auto offset = frame_.slot_offsets[local];
+  FMT_ASSERT(offset != FrameLayout::kNoSlot, "Local has no frame slot");
+  out_.EmitInstr("{} =l add {}, {}", dst, frame_ptr_, offset);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void CoroutineLowering::Save(std::span<const size_t> live,
+                             std::span<const qbe::QbeValue> temps) {
+  for (auto local : live) {
+    if (!locals_[local].aggregate) {
+      Store(temps[local], locals_[local].size, frame_.slot_offsets[local]);
+    }
+  }
+}
+
+void CoroutineLowering::Restore(std::span<const size_t> live,
+                                std::span<const qbe::QbeValue> temps) {
+  for (auto local : live) {
+    if (!locals_[local].aggregate) {
+      Load(temps[local], locals_[local].size, frame_.slot_offsets[local]);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void CoroutineLowering::EmitInit() {
+  frame_ptr_ = fresh_();
+
+  std::vector<qbe::QbeValue> temps(locals_.size());
+
+  std::string signature = fmt::format("l {}", frame_ptr_);
+  for (auto param : params_) {
+    temps[param] = fresh_();
+    auto param_class = locals_[param].aggregate
+                           ? "l"
+                           : ScalarClass(locals_[param].size);
+    signature += fmt::format(", {} {}", param_class, temps[param]);
+  }
+
+  out_.Emit("function ${}.init({}) {{", name_, signature);
+  out_.Emit("@start");
+
+  Store(qbe::QbeValue::Const(FrameLayout::kInitial), 4, frame_.state_offset);
+
+  // Aggregates are passed by address and copied in
+  for (auto param : params_) {
+    auto& local = locals_[param];
+    if (local.aggregate) {
+      Copy(temps[param], local.size, frame_.slot_offsets[param]);
+    } else {
+      Store(temps[param], local.size, frame_.slot_offsets[param]);
+    }
+  }
+
+  out_.EmitInstr("ret");
+  out_.Emit("}}");
+}
+
+void CoroutineLowering::EmitResumeHeader(
+    std::span<const qbe::QbeValue> temps) {
+  frame_ptr_ = fresh_();
+
+  out_.Emit("function w ${}.resume(l {}) {{", name_, frame_ptr_);
+  out_.Emit("@start");
+
+  auto state = fresh_();
+  Load(state, 4, frame_.state_offset);
+
+  // A chain of compares: there are few yields per coroutine.
+  // Any other state means the body has finished.
+  for (uint32_t target = 0; target < frame_.done; target++) {
+    auto label = target == FrameLayout::kInitial
+                     ? std::string{"@body"}
+                     : fmt::format("@resume.{}", target - 1);
+
+    auto is_target = fresh_();
+    out_.EmitInstr("{} =w ceqw {}, {}", is_target, state, target);
+    out_.EmitInstr("jnz {}, {}, @dispatch.{}", is_target, label, target);
+    out_.Emit("@dispatch.{}", target);
+  }
+
+  out_.EmitInstr("ret 0");
+
+  out_.Emit("@body");
+  Restore(params_, temps);
+}
+
+void CoroutineLowering::EmitSuspend(size_t index, qbe::QbeValue value,
+                                    std::span<const qbe::QbeValue> temps) {
+  if (frame_.value_aggregate) {
+    Copy(value, frame_.value_size, frame_.value_offset);
+  } else if (frame_.value_size > 0) {
+    Store(value, frame_.value_size, frame_.value_offset);
+  }
+
+  Save(suspends_[index].live, temps);
+
+  Store(qbe::QbeValue::Const(index + 1), 4, frame_.state_offset);
+  out_.EmitInstr("ret 1");
+}
+
+void CoroutineLowering::EmitResumePoint(
+    size_t index, std::span<const qbe::QbeValue> temps) {
+  out_.Emit("@resume.{}", index);
+  Restore(suspends_[index].live, temps);
+}
+
+void CoroutineLowering::EmitFinish() {
+  out_.Emit("@finish");
+  Store(qbe::QbeValue::Const(frame_.done), 4, frame_.state_offset);
+  out_.EmitInstr("ret 0");
+  out_.Emit("}}");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void EmitCreate(qbe::IrEmitter& out, qbe::QbeValue dst,
+                const FrameLayout& frame, bool on_stack,
+                opt::Allocator allocator) {
+  opt::EmitNew(out, dst, frame.frame.size, frame.frame.align, on_stack,
+               allocator);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace coro
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <layout/struct_layout.hpp>
+
+#include <opt/escape_analysis.hpp>
+
+#include <qbe/ir_emitter.hpp>
+#include <qbe/qbe_value.hpp>
+
+#include <string_view>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <span>
+
+namespace coro {
+
+//////////////////////////////////////////////////////////////////////
+
+// Stackless coroutines (tasks/async.md): a function containing
+// `yield` is split, LLVM style, into
+//
+//   $gen.init    saves the arguments into a frame the caller
+//                allocated, without running the body
+//   $gen.resume  runs the body from where it last stopped; returns 1
+//                with the yielded value stored in the frame, or 0
+//                once the body has finished
+//
+// The caller allocates the frame with EmitCreate: on its own stack
+// when escape analysis shows the coroutine object stays local (a
+// generator consumed by a loop), on the heap otherwise.
+//
+// The frame holds the state (which yield to continue after), the
+// yielded value and the locals that are live across some yield;
+// nothing else survives a suspension, so nothing else is saved.
+
+struct Local {
+  std::string name;
+
+  size_t size = 8;
+  size_t align = 8;
+
+  // A struct or array: held by address, kept in its frame slot. An
+  // 8-byte struct is still an aggregate, so this is not a size test.
+  bool aggregate = false;
+};
+
+struct SuspendPoint {
+  // Indices into the locals, live across this `yield`
+  std::vector<size_t> live;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+struct FrameLayout {
+  static constexpr uint32_t kInitial = 0;
+
+  // State after the body returned
+  uint32_t done = 1;
+
+  layout::StructLayout frame;
+
+  size_t state_offset = 0;
+
+  // Where `yield` leaves its value for the consumer
+  size_t value_offset = 0;
+  size_t value_size = 0;
+  bool value_aggregate = false;
+
+  // Frame slot of each local, kNoSlot if it is never live across a
+  // yield. Scalars never live at the same yield share a slot; each
+  // aggregate has one of its own, since it stays in the frame between
+  // yields too.
+  static constexpr size_t kNoSlot = SIZE_MAX;
+  std::vector<size_t> slot_offsets;
+};
+
+// `params` (indices into the locals) are live at the very start: the
+// body only begins at the first resume
+FrameLayout ComputeFrame(std::span<const Local> locals,
+                         std::span<const size_t> params,
+                         std::span<const SuspendPoint> suspends,
+                         size_t value_size, size_t value_align,
+                         bool value_aggregate = false);
+
+//////////////////////////////////////////////////////////////////////
+
+// Writes the resume function around the body the caller lowers:
+//
+//   lowering.EmitInit();
+//   lowering.EmitResumeHeader(temps);    // dispatch, reload params
+//   ... body; at a `yield v`:
+//   lowering.EmitSuspend(i, v, temps);   // save, set state, ret 1
+//   lowering.EmitResumePoint(i, temps);  // reload and continue
+//   ...
+//   lowering.EmitFinish();               // @finish: state = done, ret 0
+//
+// `temps[i]` is the temporary holding local i. Scalars (1, 2, 4 or 8
+// bytes) are saved and reloaded around each yield; aggregates must
+// live in their frame slot for the whole body (see SlotAddress), and
+// their temporary holds an address.
+
+class CoroutineLowering {
+ public:
+  using FreshTemp = std::function<qbe::QbeValue()>;
+
+  CoroutineLowering(std::string_view name, const FrameLayout& frame,
+                    std::span<const Local> locals,
+                    std::span<const size_t> params,
+                    std::span<const SuspendPoint> suspends,
+                    qbe::IrEmitter& out, FreshTemp fresh);
+
+  // `function $<name>.init(l %frame, <params>)`
+  void EmitInit();
+
+  // `function w $<name>.resume(l %frame)`, the state dispatch and
+  // the reload of the parameters
+  void EmitResumeHeader(std::span<const qbe::QbeValue> temps);
+
+  void EmitSuspend(size_t index, qbe::QbeValue value,
+                   std::span<const qbe::QbeValue> temps);
+
+  void EmitResumePoint(size_t index, std::span<const qbe::QbeValue> temps);
+
+  // Opens block @finish: a `return` in the body jumps there, and the
+  // last block falls through into it
+  void EmitFinish();
+
+  // Address of a local's frame slot
+  void SlotAddress(qbe::QbeValue dst, size_t local);
+
+  qbe::QbeValue Frame() const {
+    return frame_ptr_;
+  }
+
+ private:
+  void Save(std::span<const size_t> live,
+            std::span<const qbe::QbeValue> temps);
+  void Restore(std::span<const size_t> live,
+               std::span<const qbe::QbeValue> temps);
+
+  void Store(qbe::QbeValue value, size_t size, size_t offset);
+  // Copies the aggregate at address `value` into the frame
+  void Copy(qbe::QbeValue value, size_t size, size_t offset);
+  void Load(qbe::QbeValue dst, size_t size, size_t offset);
+  qbe::QbeValue Address(size_t offset);
+
+ private:
+  std::string name_;
+  const FrameLayout& frame_;
+  std::span<const Local> locals_;
+  std::span<const size_t> params_;
+  std::span<const SuspendPoint> suspends_;
+
+  qbe::IrEmitter& out_;
+  FreshTemp fresh_;
+
+  qbe::QbeValue frame_ptr_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Allocate a frame for a call of the coroutine
+void EmitCreate(qbe::IrEmitter& out, qbe::QbeValue dst,
+                const FrameLayout& frame, bool on_stack,
+                opt::Allocator allocator = opt::Allocator::MALLOC);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace coro
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <cstddef>
+#include <string>
+
+namespace diag::errors {
+
+struct DiagError : std::exception {
+  std::string message;
+
+  const char* what() const noexcept override {
+    return message.c_str();
+  }
+};
+
+struct TooManyFilesError : DiagError {
+  TooManyFilesError(const std::string& path, size_t limit) {
+    message = fmt::format(
+        "Cannot compile {}: more than {} files in one compilation\n", path,
+        limit);
+  }
+};
+
+}  // namespace diag::errors
@@ -0,0 +1,37 @@
+#include <diag/diagnostic.hpp>
+
+#include <fmt/format.h>
+
+namespace diag {
+
+//////////////////////////////////////////////////////////////////////
+
+std::string FormatMessage(const Diagnostic& diagnostic) {
+  switch (diagnostic.kind) {
+    case DiagKind::PARSE_PRIMARY:
+      return "Could not match primary expression";
+    case DiagKind::PARSE_TRUE_BLOCK:
+      return "Could not parse true block";
+    case DiagKind::PARSE_NON_LVALUE:
+      return "Expected lvalue";
+    case DiagKind::PARSE_TYPE:
+      return "Could not parse the type";
+    case DiagKind::PARSE_EXPORT:
+      return "Expected declaration after export";
+    case DiagKind::PARSE_IMPORT_ORDER:
+      return "Imports must come before all other declarations";
+    case DiagKind::PARSE_NESTING:
+      return "Expression nested too deeply";
+    case DiagKind::PARSE_TOKEN:
+      return fmt::format(
+          "Expected token {}",
+          lex::FormatTokenType(static_cast<lex::TokenType>(diagnostic.arg)));
+  }
+
+  FMT_ASSERT(false, "Unknown diagnostic kind");
+  return {};
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace diag
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <lex/token_type.hpp>
+#include <lex/location.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace diag {
+
+//////////////////////////////////////////////////////////////////////
+
+enum class DiagKind : uint16_t {
+  PARSE_PRIMARY,
+  PARSE_TRUE_BLOCK,
+  PARSE_NON_LVALUE,
+  PARSE_TYPE,
+  PARSE_EXPORT,
+  PARSE_IMPORT_ORDER,
+  PARSE_NESTING,
+  PARSE_TOKEN,  // arg: the expected lex::TokenType
+};
+
+using FileId = uint16_t;
+
+// What was wrong and where, without any text: 16 bytes that are cheap
+// to record and to drop when a speculative parse backtracks. The
+// message is only built by `FormatMessage`, when it is printed.
+struct Diagnostic {
+  DiagKind kind = DiagKind::PARSE_PRIMARY;
+  FileId file = 0;
+  uint32_t lineno = 0;
+  uint32_t columnno = 0;
+  uint32_t arg = 0;
+
+  lex::Location GetLocation() const {
+    return {lineno, columnno};
+  }
+
+  static Diagnostic At(DiagKind kind, lex::Location location,
+                       uint32_t arg = 0) {
+    Diagnostic diagnostic;
+    diagnostic.kind = kind;
+    diagnostic.lineno = static_cast<uint32_t>(location.lineno);
+    diagnostic.columnno = static_cast<uint32_t>(location.columnno);
+    diagnostic.arg = arg;
+    return diagnostic;
+  }
+
+  static Diagnostic ExpectedToken(lex::TokenType type,
+                                  lex::Location location) {
+    return At(DiagKind::PARSE_TOKEN, location, static_cast<uint32_t>(type));
+  }
+};
+
+static_assert(sizeof(Diagnostic) == 16);
+
+// "Expected token ;", without the location
+std::string FormatMessage(const Diagnostic& diagnostic);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace diag
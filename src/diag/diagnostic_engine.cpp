@@ -0,0 +1,161 @@
+#include <diag/diagnostic_engine.hpp>
+#include <diag/diag_error.hpp>
+
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <ostream>
+#include <tuple>
+
+namespace diag {
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+std::atomic<uint64_t> next_engine_id{1};
+
+// The buffer of the engine this thread reported to last. One slot is
+// enough: a thread works for one compilation at a time.
+struct CachedBuffer {
+  uint64_t engine = 0;
+  void* buffer = nullptr;
+};
+
+thread_local CachedBuffer cached;
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+DiagnosticEngine::DiagnosticEngine()
+    : id_{next_engine_id.fetch_add(1, std::memory_order_relaxed)} {
+}
+
+DiagnosticEngine::~DiagnosticEngine() = default;
+
+FileId DiagnosticEngine::AddFile(std::string path) {
+  std::lock_guard guard{mutex_};
+
+  // FileId is small to keep a Diagnostic at 16 bytes
+  constexpr size_t kMaxFiles = std::numeric_limits<FileId>::max() + 1;
+  if (files_.size() == kMaxFiles) {
+    throw errors::TooManyFilesError{path, kMaxFiles};
+  }
+
+  files_.push_back(std::move(path));
+  return static_cast<FileId>(files_.size() - 1);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+auto DiagnosticEngine::ThreadBuffer() -> Buffer& {
+  if (cached.engine == id_) [[likely]] {
+    return *static_cast<Buffer*>(cached.buffer);
+  }
+
+  // Slow path: the first report from this thread, or the thread went
+  // on to another engine and came back. Buffers are never shared, so a
+  // returning thread looks its old one up rather than adding another.
+  // The engine keeps that index, so nothing outlives it.
+  std::lock_guard guard{mutex_};
+
+  auto& buffer = by_thread_[std::this_thread::get_id()];
+  if (!buffer) {
+    buffers_.push_back(std::make_unique<Buffer>());
+    buffer = buffers_.back().get();
+    buffer->thread_index = buffers_.size() - 1;
+  }
+
+  cached = {id_, buffer};
+  return *buffer;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void DiagnosticEngine::Report(const Diagnostic& diagnostic) {
+  ThreadBuffer().diagnostics.push_back(diagnostic);
+}
+
+size_t DiagnosticEngine::Mark() {
+  return ThreadBuffer().diagnostics.size();
+}
+
+void DiagnosticEngine::Rollback(size_t mark) {
+  auto& diagnostics = ThreadBuffer().diagnostics;
+  FMT_ASSERT(mark <= diagnostics.size(), "Rollback past the end");
+  diagnostics.resize(mark);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+auto DiagnosticEngine::Collect() const -> std::vector<Diagnostic> {
+  std::lock_guard guard{mutex_};
+
+  struct Entry {
+    Diagnostic diagnostic;
+    size_t thread_index;
+    size_t sequence;
+  };
+
+  std::vector<Entry> entries;
+  for (auto& buffer : buffers_) {
+    for (size_t i = 0; i < buffer->diagnostics.size(); i++) {
+      entries.push_back({buffer->diagnostics[i], buffer->thread_index, i});
+    }
+  }
+
+  std::sort(entries.begin(), entries.end(), [](auto& a, auto& b) {
+    auto key = [](const Entry& e) {
+      return std::tie(e.diagnostic.file, e.diagnostic.lineno,
+                      e.diagnostic.columnno, e.thread_index, e.sequence);
+    };
+    return key(a) < key(b);
+  });
+
+  std::vector<Diagnostic> result;
+  result.reserve(entries.size());
+  for (auto& entry : entries) {
+    result.push_back(entry.diagnostic);
+  }
+
+  return result;
+}
+
+size_t DiagnosticEngine::Count() const {
+  std::lock_guard guard{mutex_};
+
+  size_t count = 0;
+  for (auto& buffer : buffers_) {
+    count += buffer->diagnostics.size();
+  }
+  return count;
+}
+
+void DiagnosticEngine::Print(std::ostream& out) const {
+  auto diagnostics = Collect();
+
+  for (auto& diagnostic : diagnostics) {
+    std::string_view file = "<unknown>";
+    {
+      std::lock_guard guard{mutex_};
+      if (diagnostic.file < files_.size()) {
+        file = files_[diagnostic.file];
+      }
+    }
+
+    fmt::print(out, "{}:{}:{}: error: {}\n", file, diagnostic.lineno + 1,
+               diagnostic.columnno + 1, FormatMessage(diagnostic));
+  }
+
+  if (!diagnostics.empty()) {
+    fmt::print(out, "{} error{} generated.\n", diagnostics.size(),
+               diagnostics.size() == 1 ? "" : "s");
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace diag
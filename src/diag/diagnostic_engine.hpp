@@ -0,0 +1,91 @@
+#pragma once
+
+#include <diag/diagnostic.hpp>
+
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <iosfwd>
+
+namespace diag {
+
+//////////////////////////////////////////////////////////////////////
+
+// Collects diagnostics from any number of threads.
+//
+// Every thread appends to its own buffer, so reporting takes no lock
+// and shares no cache lines; the lock is taken once per thread, when
+// its buffer is created. Nothing is formatted until `Print`.
+//
+// Speculative code brackets an attempt with a checkpoint and drops
+// whatever it reported if the attempt is abandoned:
+//
+//   auto mark = engine.Mark();
+//   if (!TryParseVarDecl()) {
+//     engine.Rollback(mark);  // just moves the end of the buffer
+//     TryParseFunDecl();
+//   }
+//
+// `Collect` and `Print` must only run once the reporting threads
+// have finished.
+
+class DiagnosticEngine {
+ public:
+  DiagnosticEngine();
+  ~DiagnosticEngine();
+
+  DiagnosticEngine(const DiagnosticEngine&) = delete;
+  DiagnosticEngine& operator=(const DiagnosticEngine&) = delete;
+
+  // Name diagnostics with this file id are printed with. Throws
+  // errors::TooManyFilesError past the range of FileId.
+  FileId AddFile(std::string path);
+
+  ////////////////////////////////////////////////////////////////////
+
+  void Report(const Diagnostic& diagnostic);
+
+  // Position in the calling thread's buffer
+  size_t Mark();
+  void Rollback(size_t mark);
+
+  ////////////////////////////////////////////////////////////////////
+
+  // Everything reported so far, ordered by file and location; ties
+  // keep the order of reporting within one thread
+  auto Collect() const -> std::vector<Diagnostic>;
+
+  size_t Count() const;
+
+  // "path:line:column: error: message", one per line; the count
+  void Print(std::ostream& out) const;
+
+ private:
+  struct Buffer {
+    std::deque<Diagnostic> diagnostics;
+    size_t thread_index = 0;
+  };
+
+  Buffer& ThreadBuffer();
+
+ private:
+  // Distinguishes engines in the thread-local cache, even one
+  // allocated where a destroyed engine used to be
+  const uint64_t id_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+  std::unordered_map<std::thread::id, Buffer*> by_thread_;
+  std::vector<std::string> files_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace diag
@@ -0,0 +1,354 @@
+#include <driver/build.hpp>
+#include <driver/import_scan.hpp>
+#include <driver/build_graph.hpp>
+#include <driver/task_graph.hpp>
+#include <driver/depfile.hpp>
+#include <driver/driver_error.hpp>
+
+#include <diag/diagnostic_engine.hpp>
+
+#include <pgo/counters.hpp>
+
+#include <string_view>
+#include <optional>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+// Only the default: see BuildOptions::runtime
+#ifndef ETUDE_RUNTIME
+#define ETUDE_RUNTIME "libetude_rt.a"
+#endif
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+void BuildOptions::MakeAbsolute(const fs::path& cwd) {
+  auto fix = [&](fs::path& path) {
+    if (!path.empty() && path.is_relative()) {
+      path = (cwd / path).lexically_normal();
+    }
+  };
+
+  for (auto& input : inputs) {
+    fix(input);
+  }
+  for (auto& dir : include_dirs) {
+    fix(dir);
+  }
+
+  fix(output);
+  fix(build_dir);
+  fix(depfile);
+  fix(runtime);
+  fix(codegen.profile_use);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+bool ParseBuildOptions(std::span<const std::string> args,
+                       BuildOptions& options) {
+  for (size_t i = 0; i < args.size(); i++) {
+    std::string_view arg{args[i]};
+
+    auto value = [&]() -> const std::string* {
+      return i + 1 < args.size() ? &args[++i] : nullptr;
+    };
+
+    if (arg == "-o" || arg == "-B" || arg == "-I" || arg == "-j" ||
+        arg == "-MF") {
+      auto param = value();
+      if (!param) {
+        return false;
+      }
+
+      if (arg == "-o") {
+        options.output = *param;
+      } else if (arg == "-B") {
+        options.build_dir = *param;
+      } else if (arg == "-I") {
+        options.include_dirs.emplace_back(*param);
+      } else if (arg == "-j") {
+        auto [end, error] = std::from_chars(
+            param->data(), param->data() + param->size(), options.jobs);
+        if (error != std::errc{} || end != param->data() + param->size()) {
+          return false;
+        }
+      } else {
+        options.depfile = *param;
+      }
+    } else if (arg == "--interface-only") {
+      options.interface_only = true;
+    } else if (arg == "--instrument") {
+      options.codegen.instrument = true;
+    } else if (arg.starts_with("--profile-use=")) {
+      options.codegen.profile_use = arg.substr(14);
+      if (options.codegen.profile_use.empty()) {
+        return false;
+      }
+    } else if (arg.starts_with("--generics=")) {
+      auto strategy = mono::ParseStrategy(arg.substr(11));
+      if (!strategy) {
+        return false;
+      }
+      options.codegen.generics.SetDefault(*strategy);
+    } else if (arg.starts_with("--generics-for=")) {
+      auto spec = arg.substr(15);
+      auto eq = spec.find('=');
+      if (eq == 0 || eq == spec.npos) {
+        return false;
+      }
+      auto strategy = mono::ParseStrategy(spec.substr(eq + 1));
+      if (!strategy) {
+        return false;
+      }
+      options.codegen.generics.Override(std::string{spec.substr(0, eq)},
+                                        *strategy);
+    } else if (arg.starts_with("--runtime=")) {
+      options.runtime = arg.substr(10);
+      if (options.runtime.empty()) {
+        return false;
+      }
+    } else if (arg.starts_with("--alloc=")) {
+      auto allocator = opt::ParseAllocator(arg.substr(8));
+      if (!allocator) {
+        return false;
+      }
+      options.codegen.allocator = *allocator;
+    } else if (arg.starts_with("-")) {
+      return false;
+    } else {
+      options.inputs.emplace_back(arg);
+    }
+  }
+
+  return !options.inputs.empty();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static std::string RuntimeLibrary(const BuildOptions& options) {
+  if (!options.runtime.empty()) {
+    return options.runtime.string();
+  }
+
+  if (auto* path = std::getenv("ETUDE_RUNTIME"); path && *path) {
+    return path;
+  }
+
+  return ETUDE_RUNTIME;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+modules::InterfaceLoader& BuildCache::LoaderFor(
+    const std::vector<fs::path>& search_path) {
+  std::lock_guard guard{mutex_};
+
+  auto& loader = loaders_[search_path];
+  if (!loader) {
+    loader = std::make_unique<modules::InterfaceLoader>(search_path,
+                                                        /*revalidate=*/true);
+  }
+
+  return *loader;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static std::string ReadFile(const fs::path& path) {
+  std::ifstream file{path};
+  std::stringstream text;
+  text << file.rdbuf();
+  return text.str();
+}
+
+void Build(const BuildOptions& options, BuildCache* cache) {
+  BuildGraph graph;
+
+  for (auto& input : options.inputs) {
+    graph.AddModule(input, ScanImports(ReadFile(input)));
+  }
+
+  graph.Resolve();
+
+  auto& modules = graph.Modules();
+
+  // Interfaces of local modules are written to the build directory
+  std::vector<fs::path> search_path{options.build_dir};
+  search_path.insert(search_path.end(), options.include_dirs.begin(),
+                     options.include_dirs.end());
+
+  std::optional<modules::InterfaceLoader> own_loader;
+  if (!cache) {
+    own_loader.emplace(search_path);
+  }
+  auto& loader = cache ? cache->LoaderFor(search_path) : *own_loader;
+
+  fs::create_directories(options.build_dir);
+
+  // Read before anything runs: a bad profile fails the build early
+  std::optional<pgo::Profile> profile;
+  if (!options.codegen.profile_use.empty() && !options.interface_only) {
+    profile = pgo::ReadProfile(options.codegen.profile_use);
+  }
+
+  ////////////////////////////////////////////////////////////////////
+
+  TaskGraph tasks;
+
+  std::vector<ModuleOutputs> outputs;
+  for (auto& module : modules) {
+    outputs.push_back(OutputsFor(module, options.build_dir));
+  }
+
+  // Shared by the front ends, which report from their worker threads
+  diag::DiagnosticEngine diagnostics;
+  std::vector<diag::FileId> files;
+  for (auto& module : modules) {
+    files.push_back(diagnostics.AddFile(module.source.string()));
+  }
+
+  std::vector<std::vector<Declaration*>> parsed(modules.size());
+  std::vector<TaskGraph::TaskId> front_ends(modules.size());
+  std::vector<TaskGraph::TaskId> objects;
+
+  // Importers wait for the front end (the interface) of what they
+  // import, and nothing else: independent modules go in parallel
+
+  for (auto index : graph.TopologicalOrder()) {
+    auto& module = modules[index];
+
+    std::vector<TaskGraph::TaskId> deps;
+    for (auto dep : module.local_deps) {
+      deps.push_back(front_ends[dep]);
+    }
+
+    front_ends[index] = tasks.Add(
+        [&, index] {
+          parsed[index] = RunFrontEnd(modules[index], outputs[index], loader,
+                                      diagnostics, files[index]);
+        },
+        deps);
+  }
+
+  if (!options.interface_only) {
+    for (size_t index = 0; index < modules.size(); index++) {
+      auto& out = outputs[index];
+
+      auto codegen = tasks.Add(
+          [&, index] {
+            RunCodegen(modules[index], out, parsed[index], options.codegen,
+                       profile ? &*profile : nullptr);
+          },
+          {front_ends[index]});
+
+      auto assemble = tasks.Add(
+          [&] {
+            RunTool({"qbe", "-o", out.assembly, out.ir});
+          },
+          {codegen});
+
+      objects.push_back(tasks.Add(
+          [&] {
+            RunTool({"cc", "-c", out.assembly, "-o", out.object});
+          },
+          {assemble}));
+    }
+
+    // The list of counter tables the runtime dumps at exit
+    auto profiling = options.build_dir / "etude_prof";
+    if (options.codegen.instrument) {
+      auto list = tasks.Add([&] {
+        std::vector<std::string> names;
+        for (auto& module : modules) {
+          names.push_back(module.name);
+        }
+
+        qbe::IrEmitter ir;
+        pgo::EmitModuleList(ir, names);
+
+        std::ofstream file{profiling.string() + ".ssa"};
+        file << ir.Contents();
+        if (!file) {
+          throw errors::OutputError{profiling.string() + ".ssa"};
+        }
+      });
+
+      auto assemble = tasks.Add(
+          [&] {
+            RunTool({"qbe", "-o", profiling.string() + ".s",
+                     profiling.string() + ".ssa"});
+          },
+          {list});
+
+      objects.push_back(tasks.Add(
+          [&] {
+            RunTool({"cc", "-c", profiling.string() + ".s", "-o",
+                     profiling.string() + ".o"});
+          },
+          {assemble}));
+    }
+
+    tasks.Add(
+        [&] {
+          std::vector<std::string> link{"cc"};
+          for (auto& out : outputs) {
+            link.push_back(out.object);
+          }
+          if (options.codegen.instrument) {
+            link.push_back(profiling.string() + ".o");
+          }
+          if (options.codegen.allocator == opt::Allocator::BUMP ||
+              options.codegen.instrument) {
+            link.push_back(RuntimeLibrary(options));
+          }
+          link.push_back("-o");
+          link.push_back(options.output);
+          RunTool(std::move(link));
+        },
+        objects);
+  }
+
+  try {
+    tasks.Run(options.jobs ? options.jobs
+                           : std::thread::hardware_concurrency());
+  } catch (errors::SyntaxError&) {
+    // Every module that got parsed has reported by now, in any order
+    std::ostringstream printed;
+    diagnostics.Print(printed);
+    throw errors::DiagnosticsError{printed.str()};
+  }
+
+  ////////////////////////////////////////////////////////////////////
+
+  if (!options.depfile.empty()) {
+    std::vector<fs::path> deps;
+
+    for (auto& module : modules) {
+      deps.push_back(module.source);
+      for (auto& external : module.external_deps) {
+        deps.push_back(loader.Locate(external));
+      }
+    }
+
+    std::vector<fs::path> targets{options.output};
+    if (options.interface_only) {
+      targets.clear();
+      for (auto& out : outputs) {
+        targets.push_back(out.interface);
+      }
+    }
+
+    WriteDepfile(options.depfile, targets, deps);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <driver/compile_module.hpp>
+
+#include <modules/interface.hpp>
+
+#include <filesystem>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <span>
+#include <map>
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+// One `etudec` invocation: what to build, where, and how
+
+struct BuildOptions {
+  std::vector<std::filesystem::path> inputs;
+  std::vector<std::filesystem::path> include_dirs;
+
+  std::filesystem::path output = "a.out";
+  std::filesystem::path build_dir = ".";
+  std::filesystem::path depfile;
+
+  // libetude_rt.a for --alloc=bump and --instrument. Empty: the one
+  // in $ETUDE_RUNTIME, else the one built next to this compiler.
+  std::filesystem::path runtime;
+
+  size_t jobs = 0;  // all cores
+
+  // Stop after writing the interfaces
+  bool interface_only = false;
+
+  CodegenOptions codegen;
+
+  // Relative paths are relative to `cwd` (the client's, in the server)
+  void MakeAbsolute(const std::filesystem::path& cwd);
+};
+
+// The compilation flags of `etudec`; false on anything else, the
+// caller handles its own process-wide flags before
+bool ParseBuildOptions(std::span<const std::string> args,
+                       BuildOptions& options);
+
+//////////////////////////////////////////////////////////////////////
+
+// What is worth keeping between builds: a compile server serves many
+// small compilations that import the same interfaces.
+// Safe to share between threads.
+
+class BuildCache {
+ public:
+  // One loader per search path, revalidating its files on each use
+  modules::InterfaceLoader& LoaderFor(
+      const std::vector<std::filesystem::path>& search_path);
+
+ private:
+  std::mutex mutex_;
+  std::map<std::vector<std::filesystem::path>,
+           std::unique_ptr<modules::InterfaceLoader>>
+      loaders_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Scan, order and compile the inputs, link them, write the depfile.
+// Throws on the first failure. Without a cache everything is loaded
+// afresh.
+void Build(const BuildOptions& options, BuildCache* cache = nullptr);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
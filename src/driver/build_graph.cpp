@@ -0,0 +1,102 @@
+#include <driver/build_graph.hpp>
+#include <driver/driver_error.hpp>
+
+#include <algorithm>
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+void BuildGraph::AddModule(std::filesystem::path source,
+                           std::vector<std::string> imports) {
+  auto name = source.stem().string();
+
+  if (!index_.emplace(name, modules_.size()).second) {
+    throw errors::DuplicateModuleError{name};
+  }
+
+  modules_.push_back(ModuleNode{
+      .name = std::move(name),
+      .source = std::move(source),
+      .imports = std::move(imports),
+      .local_deps = {},
+      .external_deps = {},
+  });
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void BuildGraph::Resolve() {
+  for (auto& module : modules_) {
+    module.local_deps.clear();
+    module.external_deps.clear();
+
+    for (auto& import : module.imports) {
+      if (auto it = index_.find(import); it != index_.end()) {
+        module.local_deps.push_back(it->second);
+      } else {
+        module.external_deps.push_back(import);
+      }
+    }
+  }
+
+  // Fails on a cycle
+  TopologicalOrder();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::vector<size_t> BuildGraph::TopologicalOrder() const {
+  enum class Mark { NONE, IN_PROGRESS, DONE };
+
+  std::vector<Mark> marks(modules_.size(), Mark::NONE);
+  std::vector<size_t> order;
+
+  // Iterative DFS: (module, next dependency to visit)
+  std::vector<std::pair<size_t, size_t>> stack;
+
+  for (size_t root = 0; root < modules_.size(); root++) {
+    if (marks[root] != Mark::NONE) {
+      continue;
+    }
+
+    stack.emplace_back(root, 0);
+    marks[root] = Mark::IN_PROGRESS;
+
+    while (!stack.empty()) {
+      auto& [node, next] = stack.back();
+      auto& deps = modules_[node].local_deps;
+
+      if (next == deps.size()) {
+        marks[node] = Mark::DONE;
+        order.push_back(node);
+        stack.pop_back();
+        continue;
+      }
+
+      size_t dep = deps[next++];
+
+      if (marks[dep] == Mark::IN_PROGRESS) {
+        std::string cycle;
+        auto start = std::find_if(stack.begin(), stack.end(), [&](auto& f) {
+          return f.first == dep;
+        });
+        for (auto it = start; it != stack.end(); ++it) {
+          cycle += modules_[it->first].name + " -> ";
+        }
+        throw errors::ImportCycleError{cycle + modules_[dep].name};
+      }
+
+      if (marks[dep] == Mark::NONE) {
+        marks[dep] = Mark::IN_PROGRESS;
+        stack.emplace_back(dep, 0);
+      }
+    }
+  }
+
+  return order;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+// Modules given on the command line and the imports between them.
+// A module is named after its file: `src/vec.et` is module `vec`.
+
+struct ModuleNode {
+  std::string name;
+  std::filesystem::path source;
+
+  std::vector<std::string> imports;
+
+  // Indices of imported modules that are being built too
+  std::vector<size_t> local_deps;
+
+  // Imports satisfied by prebuilt interfaces (search path)
+  std::vector<std::string> external_deps;
+};
+
+class BuildGraph {
+ public:
+  void AddModule(std::filesystem::path source,
+                 std::vector<std::string> imports);
+
+  // Link the imports; throws on duplicate modules and import cycles
+  void Resolve();
+
+  // Every module comes after all of the modules it imports
+  std::vector<size_t> TopologicalOrder() const;
+
+  const std::vector<ModuleNode>& Modules() const {
+    return modules_;
+  }
+
+ private:
+  std::vector<ModuleNode> modules_;
+  std::map<std::string, size_t, std::less<>> index_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
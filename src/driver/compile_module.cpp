@@ -0,0 +1,102 @@
+#include <driver/compile_module.hpp>
+#include <driver/driver_error.hpp>
+#include <driver/process.hpp>
+
+#include <parse/parser.hpp>
+
+#include <stats/stats.hpp>
+#include <stats/trace.hpp>
+
+#include <fstream>
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+ModuleOutputs OutputsFor(const ModuleNode& module,
+                         const std::filesystem::path& build_dir) {
+  auto base = build_dir / module.name;
+
+  return ModuleOutputs{
+      .interface = base.string() + ".eti",
+      .ir = base.string() + ".ssa",
+      .assembly = base.string() + ".s",
+      .object = base.string() + ".o",
+  };
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::vector<Declaration*> RunFrontEnd(const ModuleNode& module,
+                                      const ModuleOutputs& outputs,
+                                      modules::InterfaceLoader& loader,
+                                      diag::DiagnosticEngine& diagnostics,
+                                      diag::FileId file) {
+  stats::TraceScope trace{"front end", module.name};
+
+  for (auto& import : module.imports) {
+    loader.Load(import);
+  }
+
+  std::vector<Declaration*> declarations;
+
+  {
+    // With the lexing the parser asks for
+    stats::ScopedPhase phase{stats::Phase::PARSE};
+
+    std::ifstream source{module.source};
+    lex::Lexer lexer{source};
+    Parser parser{lexer, diagnostics, file};
+
+    // This thread's own buffer: only this module's errors move it
+    auto mark = diagnostics.Mark();
+
+    declarations = parser.ParseModule();
+
+    if (diagnostics.Mark() != mark) {
+      throw errors::SyntaxError{module.name};
+    }
+  }
+
+  auto interface = modules::ExtractInterface(module.name, declarations);
+  modules::WriteInterface(interface, outputs.interface);
+
+  return declarations;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void RunCodegen(const ModuleNode& module, const ModuleOutputs&,
+                const std::vector<Declaration*>&, const CodegenOptions&,
+                const pgo::Profile*) {
+  stats::TraceScope trace{"codegen", module.name};
+  stats::ScopedPhase phase{stats::Phase::CODEGEN};
+
+  // Once the IR generator from tasks/06-qbe-ir.md lands:
+  // flatten the declarations (ast/flat_tree.hpp), keep only those
+  // opt::RemoveDeadDeclarations finds reachable from `main` and the
+  // exports, lower them with ParallelCodegen into `outputs.ir`,
+  // generic ones through a mono::InstantiationCache built on
+  // `options.generics`, `new` through opt::EmitNew.
+  // With `options.instrument`, a pgo::CounterTable for the module;
+  // with a profile, arms placed by pgo::ArmLayout, calls inlined per
+  // pgo::InlineAdvisor and functions written by pgo::HotFirstOrder
+  throw errors::NotImplementedError{"QBE IR generation"};
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void RunTool(std::vector<std::string> argv) {
+  stats::TraceScope trace{"backend", argv.front()};
+  stats::ScopedPhase phase{stats::Phase::BACKEND};
+
+  auto tool = argv.front();
+
+  if (int status = RunProcess(std::move(argv)); status != 0) {
+    throw errors::ToolError{tool, status};
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
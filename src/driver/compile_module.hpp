@@ -0,0 +1,75 @@
+#pragma once
+
+#include <driver/build_graph.hpp>
+
+#include <diag/diagnostic_engine.hpp>
+
+#include <modules/interface.hpp>
+
+#include <mono/strategy.hpp>
+
+#include <opt/escape_analysis.hpp>
+
+#include <pgo/profile.hpp>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+class Declaration;
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+// The per-module steps `etudec` schedules, and where their results go
+
+struct ModuleOutputs {
+  std::filesystem::path interface;  // <build>/<module>.eti
+  std::filesystem::path ir;         // <build>/<module>.ssa
+  std::filesystem::path assembly;   // <build>/<module>.s
+  std::filesystem::path object;     // <build>/<module>.o
+};
+
+ModuleOutputs OutputsFor(const ModuleNode& module,
+                         const std::filesystem::path& build_dir);
+
+//////////////////////////////////////////////////////////////////////
+
+// Parse the module, load the interfaces of what it imports (never
+// their sources) and write its own interface for the importers.
+// The interfaces of local imports must have been written already.
+// Parse errors go to `diagnostics` under `file`; if there were any,
+// throws errors::SyntaxError once the whole module has been read.
+std::vector<Declaration*> RunFrontEnd(const ModuleNode& module,
+                                      const ModuleOutputs& outputs,
+                                      modules::InterfaceLoader& loader,
+                                      diag::DiagnosticEngine& diagnostics,
+                                      diag::FileId file);
+
+// Code generation choices made on the command line
+
+struct CodegenOptions {
+  mono::StrategyPolicy generics;
+  opt::Allocator allocator = opt::Allocator::MALLOC;
+
+  // --instrument: count function entries and branch arms at runtime
+  bool instrument = false;
+
+  // --profile-use=<file>: what an instrumented build counted
+  std::filesystem::path profile_use;
+};
+
+// Lower the parsed module to QBE IR. `profile` is the one read from
+// `options.profile_use`, loaded once for all the modules.
+void RunCodegen(const ModuleNode& module, const ModuleOutputs& outputs,
+                const std::vector<Declaration*>& declarations,
+                const CodegenOptions& options,
+                const pgo::Profile* profile = nullptr);
+
+// Run an external tool (qbe, cc) to completion, throws if it fails
+void RunTool(std::vector<std::string> argv);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
@@ -0,0 +1,56 @@
+#include <driver/depfile.hpp>
+#include <driver/driver_error.hpp>
+
+#include <fstream>
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+static void AppendEscaped(std::string& out, const std::string& path) {
+  for (char ch : path) {
+    if (ch == ' ' || ch == '#') {
+      out += '\\';
+    } else if (ch == '$') {
+      out += '$';
+    }
+    out += ch;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::string FormatDepfile(const Paths& targets, const Paths& deps) {
+  std::string out;
+
+  for (auto& target : targets) {
+    AppendEscaped(out, target.string());
+    out += &target == &targets.back() ? ":" : " ";
+  }
+
+  for (auto& dep : deps) {
+    out += " \\\n  ";
+    AppendEscaped(out, dep.string());
+  }
+
+  out += "\n";
+  return out;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void WriteDepfile(const std::filesystem::path& path, const Paths& targets,
+                  const Paths& deps) {
+  auto text = FormatDepfile(targets, deps);
+
+  std::ofstream file{path};
+  file << text;
+
+  if (!file) {
+    throw errors::OutputError{path.string()};
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
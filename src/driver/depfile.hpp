@@ -0,0 +1,28 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+// Makefile-style dependency file (as `cc -MD -MF` writes) for the
+// outer build system:
+//
+//   app: main.et vec.et /usr/lib/etude/io.eti
+//
+// Several targets share the list: `main.eti vec.eti: ...`
+//
+
+using Paths = std::vector<std::filesystem::path>;
+
+std::string FormatDepfile(const Paths& targets, const Paths& deps);
+
+void WriteDepfile(const std::filesystem::path& path, const Paths& targets,
+                  const Paths& deps);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace driver::errors {
+
+struct DriverError : std::exception {
+  std::string message;
+
+  const char* what() const noexcept override {
+    return message.c_str();
+  }
+};
+
+struct DuplicateModuleError : DriverError {
+  DuplicateModuleError(const std::string& module) {
+    message = fmt::format("Module {} is given more than once\n", module);
+  }
+};
+
+struct ImportCycleError : DriverError {
+  ImportCycleError(const std::string& cycle) {
+    message = fmt::format("Import cycle: {}\n", cycle);
+  }
+};
+
+struct SpawnError : DriverError {
+  SpawnError(const std::string& program, int err) {
+    message = fmt::format("Could not start {}: {}\n", program,
+                          std::strerror(err));
+  }
+};
+
+struct ToolError : DriverError {
+  ToolError(const std::string& tool, int status) {
+    message = fmt::format("{} failed with exit code {}\n", tool, status);
+  }
+};
+
+struct OutputError : DriverError {
+  OutputError(const std::string& path) {
+    message = fmt::format("Could not write {}\n", path);
+  }
+};
+
+struct SyntaxError : DriverError {
+  SyntaxError(const std::string& module) {
+    message = fmt::format("Module {} has syntax errors\n", module);
+  }
+};
+
+// The diagnostics of a failed build, as diag::DiagnosticEngine prints
+struct DiagnosticsError : DriverError {
+  DiagnosticsError(std::string printed) {
+    message = std::move(printed);
+  }
+};
+
+struct NotImplementedError : DriverError {
+  NotImplementedError(const std::string& what) {
+    message = fmt::format("{} is not implemented yet\n", what);
+  }
+};
+
+}  // namespace driver::errors
@@ -0,0 +1,90 @@
+#include <driver/import_scan.hpp>
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+bool IsIdentStart(char ch) {
+  return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_';
+}
+
+bool IsIdentChar(char ch) {
+  return IsIdentStart(ch) || (ch >= '0' && ch <= '9');
+}
+
+class Scanner {
+ public:
+  explicit Scanner(std::string_view source) : source_{source} {
+  }
+
+  void SkipWhitespaceAndComments() {
+    while (pos_ < source_.size()) {
+      char ch = source_[pos_];
+
+      if (ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r') {
+        pos_ += 1;
+      } else if (ch == '#') {
+        auto eol = source_.find('\n', pos_);
+        pos_ = eol == source_.npos ? source_.size() : eol + 1;
+      } else {
+        return;
+      }
+    }
+  }
+
+  std::string_view Word() {
+    size_t begin = pos_;
+    if (pos_ < source_.size() && IsIdentStart(source_[pos_])) {
+      while (pos_ < source_.size() && IsIdentChar(source_[pos_])) {
+        pos_ += 1;
+      }
+    }
+    return source_.substr(begin, pos_ - begin);
+  }
+
+  bool Char(char expected) {
+    if (pos_ < source_.size() && source_[pos_] == expected) {
+      pos_ += 1;
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  std::string_view source_;
+  size_t pos_ = 0;
+};
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+std::vector<std::string> ScanImports(std::string_view source) {
+  std::vector<std::string> imports;
+  Scanner scanner{source};
+
+  while (true) {
+    scanner.SkipWhitespaceAndComments();
+    if (scanner.Word() != "import") {
+      break;
+    }
+
+    scanner.SkipWhitespaceAndComments();
+    auto module = scanner.Word();
+
+    scanner.SkipWhitespaceAndComments();
+    if (module.empty() || !scanner.Char(';')) {
+      break;
+    }
+
+    imports.emplace_back(module);
+  }
+
+  return imports;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string_view>
+#include <string>
+#include <vector>
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+// Cheap dependency discovery for the build graph: imports have to
+// come first in a file, so the scan reads `import <name>;` lines
+// (skipping whitespace and comments) and stops at the first thing
+// that is not one. No lexer, no parser, the body is never looked at.
+//
+// Anything malformed simply ends the scan, the front end will
+// report it properly later.
+
+std::vector<std::string> ScanImports(std::string_view source);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
@@ -0,0 +1,163 @@
+#include <driver/parallel_codegen.hpp>
+
+#include <stats/trace.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <exception>
+#include <atomic>
+#include <thread>
+#include <mutex>
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+ParallelCodegen::ParallelCodegen(size_t workers) {
+  for (size_t i = 0; i < std::max<size_t>(workers, 1); i++) {
+    buffers_.push_back(std::make_unique<qbe::IrEmitter>());
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void ParallelCodegen::LowerAll(size_t count, LowerFn lower) {
+  stats::TraceScope trace{"codegen", "lower all"};
+
+  chunks_.assign(count, Chunk{});
+
+  for (auto& buffer : buffers_) {
+    buffer->Clear();
+  }
+
+  std::atomic<size_t> next{0};
+  std::atomic<bool> failed{false};
+
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  auto work = [&](size_t worker) {
+    auto& out = *buffers_[worker];
+
+    // Hand out functions one by one: bodies vary wildly in size,
+    // static partitioning would leave workers idle
+    while (!failed.load(std::memory_order_relaxed)) {
+      size_t index = next.fetch_add(1, std::memory_order_relaxed);
+      if (index >= count) {
+        return;
+      }
+
+      stats::TraceScope trace{"codegen"};
+      if (stats::TracingEnabled()) {
+        char name[32];
+        auto result = fmt::format_to_n(name, sizeof(name), "function #{}",
+                                       index);
+        trace.SetName({name, result.out});
+      }
+
+      auto& chunk = chunks_[index];
+      chunk.worker = worker;
+      chunk.begin = out.Contents().size();
+
+      try {
+        lower(index, out);
+      } catch (...) {
+        std::lock_guard guard{error_mutex};
+        if (!error) {
+          error = std::current_exception();
+        }
+        failed.store(true);
+        return;
+      }
+
+      chunk.end = out.Contents().size();
+    }
+  };
+
+  size_t workers = std::min(buffers_.size(), count);
+
+  if (workers <= 1) {
+    // The serial path, no threads involved
+    work(0);
+  } else {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workers; i++) {
+      threads.emplace_back([&, i] {
+        if (stats::TracingEnabled()) {
+          stats::SetThreadName(fmt::format("codegen worker {}", i));
+        }
+        work(i);
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::string_view ParallelCodegen::TextOf(size_t index) const {
+  auto& chunk = chunks_[index];
+  return buffers_[chunk.worker]->Contents().substr(chunk.begin,
+                                                   chunk.end - chunk.begin);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void ParallelCodegen::Write(qbe::IrEmitter& out, Range range) const {
+  for (size_t i = range.begin; i < range.end; i++) {
+    out.Append(TextOf(i));
+  }
+}
+
+void ParallelCodegen::WriteInOrder(qbe::IrEmitter& out,
+                                   std::span<const size_t> order) const {
+  FMT_ASSERT(order.size() == chunks_.size(), "Order misses functions");
+
+  for (auto i : order) {
+    out.Append(TextOf(i));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+auto ParallelCodegen::Partition(size_t parts) const -> std::vector<Range> {
+  size_t total = 0;
+  for (auto& chunk : chunks_) {
+    total += chunk.end - chunk.begin;
+  }
+
+  parts = std::max<size_t>(parts, 1);
+  size_t target = total / parts + 1;
+
+  std::vector<Range> ranges;
+  Range current{};
+  size_t size = 0;
+
+  for (size_t i = 0; i < chunks_.size(); i++) {
+    size += chunks_[i].end - chunks_[i].begin;
+    current.end = i + 1;
+
+    if (size >= target && ranges.size() + 1 < parts) {
+      ranges.push_back(current);
+      current = Range{i + 1, i + 1};
+      size = 0;
+    }
+  }
+
+  if (current.end > current.begin) {
+    ranges.push_back(current);
+  }
+
+  return ranges;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
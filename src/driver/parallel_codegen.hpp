@@ -0,0 +1,84 @@
+#pragma once
+
+#include <qbe/ir_emitter.hpp>
+
+#include <functional>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <span>
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+// Lowers independent functions on several worker threads.
+//
+// Each worker appends into its own in-memory emitter and remembers
+// which slice belongs to which function. The slices are then written
+// out in declaration order, so the result is byte-for-byte the same
+// as lowering everything serially, whatever the number of workers.
+//
+//   ParallelCodegen codegen{std::thread::hardware_concurrency()};
+//   codegen.LowerAll(funs.size(), [&](size_t i, qbe::IrEmitter& out) {
+//     IrGenerator{out}.Emit(funs[i]);
+//   });
+//   codegen.Write(file);
+//
+
+class ParallelCodegen {
+ public:
+  // Must be safe to call concurrently for different indices
+  using LowerFn = std::function<void(size_t index, qbe::IrEmitter& out)>;
+
+  // Half-open range of function indices [begin, end)
+  struct Range {
+    size_t begin = 0;
+    size_t end = 0;
+  };
+
+  explicit ParallelCodegen(size_t workers);
+
+  ////////////////////////////////////////////////////////////////////
+
+  // Lower functions 0..count-1. Rethrows the first exception
+  // thrown by `lower` after all the workers have stopped.
+  void LowerAll(size_t count, LowerFn lower);
+
+  ////////////////////////////////////////////////////////////////////
+
+  void Write(qbe::IrEmitter& out) const {
+    Write(out, Range{0, chunks_.size()});
+  }
+
+  void Write(qbe::IrEmitter& out, Range range) const;
+
+  // Every function once, in the given order (e.g. pgo::HotFirstOrder)
+  void WriteInOrder(qbe::IrEmitter& out,
+                    std::span<const size_t> order) const;
+
+  // Split the functions into at most `parts` contiguous ranges of
+  // roughly equal text size, one per `.ssa` file / `qbe` process
+  auto Partition(size_t parts) const -> std::vector<Range>;
+
+  size_t FunctionCount() const {
+    return chunks_.size();
+  }
+
+ private:
+  std::string_view TextOf(size_t index) const;
+
+ private:
+  struct Chunk {
+    size_t worker = 0;
+    size_t begin = 0;
+    size_t end = 0;
+  };
+
+  std::vector<std::unique_ptr<qbe::IrEmitter>> buffers_;
+  std::vector<Chunk> chunks_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
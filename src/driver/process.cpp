@@ -0,0 +1,55 @@
+#include <driver/process.hpp>
+#include <driver/driver_error.hpp>
+
+#include <sys/wait.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+extern char** environ;
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+int RunProcess(std::vector<std::string> argv) {
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null",
+                                   O_RDONLY, 0);
+
+  std::vector<char*> args;
+  for (auto& arg : argv) {
+    args.push_back(arg.data());
+  }
+  args.push_back(nullptr);
+
+  pid_t pid = -1;
+  int err = posix_spawnp(&pid, argv.at(0).c_str(), &actions, nullptr,
+                         args.data(), environ);
+
+  posix_spawn_file_actions_destroy(&actions);
+
+  if (err != 0) {
+    throw errors::SpawnError{argv.front(), err};
+  }
+
+  int status = 0;
+  while (::waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      return -1;
+    }
+  }
+
+  if (WIFSIGNALED(status)) {
+    return 128 + WTERMSIG(status);
+  }
+
+  return WEXITSTATUS(status);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
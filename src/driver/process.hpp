@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+// Runs a program to completion, searched in PATH like a shell would,
+// with stdin from /dev/null and stdout/stderr shared with ours:
+//
+//   int status = RunProcess({"cc", "-c", "main.s", "-o", "main.o"});
+//
+// Returns its exit code, or 128 + signal number if it was killed.
+// Throws errors::SpawnError if it could not be started at all.
+// (qbe::QbeProcess is the one to use for feeding a child through a
+// pipe.)
+
+int RunProcess(std::vector<std::string> argv);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
@@ -0,0 +1,177 @@
+#include <driver/task_graph.hpp>
+
+#include <condition_variable>
+#include <exception>
+#include <optional>
+#include <atomic>
+#include <thread>
+#include <deque>
+#include <mutex>
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+auto TaskGraph::Add(std::function<void()> job, std::vector<TaskId> deps)
+    -> TaskId {
+  TaskId id = tasks_.size();
+
+  tasks_.push_back(Task{
+      .job = std::move(job),
+      .dependents = {},
+      .deps = deps.size(),
+  });
+
+  for (auto dep : deps) {
+    tasks_[dep].dependents.push_back(id);
+  }
+
+  return id;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+class WorkDeque {
+ public:
+  void Push(size_t task) {
+    std::lock_guard guard{mutex_};
+    tasks_.push_back(task);
+  }
+
+  std::optional<size_t> Pop() {
+    std::lock_guard guard{mutex_};
+    if (tasks_.empty()) {
+      return std::nullopt;
+    }
+    auto task = tasks_.back();
+    tasks_.pop_back();
+    return task;
+  }
+
+  std::optional<size_t> Steal() {
+    std::lock_guard guard{mutex_};
+    if (tasks_.empty()) {
+      return std::nullopt;
+    }
+    auto task = tasks_.front();
+    tasks_.pop_front();
+    return task;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::deque<size_t> tasks_;
+};
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+void TaskGraph::Run(size_t workers) {
+  workers = std::max<size_t>(workers, 1);
+
+  std::vector<WorkDeque> deques(workers);
+  std::vector<std::atomic<size_t>> pending(tasks_.size());
+
+  std::atomic<size_t> remaining{tasks_.size()};
+  std::atomic<size_t> queued{0};
+  std::atomic<bool> failed{false};
+
+  std::exception_ptr error;
+  std::mutex mutex;  // guards `error` and sleeping
+  std::condition_variable wakeup;
+
+  auto notify = [&](bool all) {
+    // Empty critical section: a worker that has just checked the
+    // predicate is either still before it or already waiting
+    { std::lock_guard guard{mutex}; }
+    all ? wakeup.notify_all() : wakeup.notify_one();
+  };
+
+  auto push = [&](size_t worker, size_t task) {
+    deques[worker].Push(task);
+    queued.fetch_add(1);
+    notify(false);
+  };
+
+  for (size_t i = 0, next = 0; i < tasks_.size(); i++) {
+    pending[i].store(tasks_[i].deps);
+    if (tasks_[i].deps == 0) {
+      push(next++ % workers, i);
+    }
+  }
+
+  auto find_work = [&](size_t self) -> std::optional<size_t> {
+    if (auto task = deques[self].Pop()) {
+      return task;
+    }
+    for (size_t i = 1; i < workers; i++) {
+      if (auto task = deques[(self + i) % workers].Steal()) {
+        return task;
+      }
+    }
+    return std::nullopt;
+  };
+
+  auto execute = [&](size_t self, size_t id) {
+    auto& task = tasks_[id];
+
+    if (!failed.load()) {
+      try {
+        task.job();
+      } catch (...) {
+        std::lock_guard guard{mutex};
+        if (!error) {
+          error = std::current_exception();
+        }
+        failed.store(true);
+      }
+    }
+
+    // Failed or not, dependents are released so the count drains
+    for (auto dependent : task.dependents) {
+      if (pending[dependent].fetch_sub(1) == 1) {
+        push(self, dependent);
+      }
+    }
+
+    if (remaining.fetch_sub(1) == 1) {
+      notify(true);
+    }
+  };
+
+  auto work = [&](size_t self) {
+    while (remaining.load() > 0) {
+      if (auto task = find_work(self)) {
+        queued.fetch_sub(1);
+        execute(self, *task);
+        continue;
+      }
+
+      std::unique_lock lock{mutex};
+      wakeup.wait(lock, [&] {
+        return queued.load() > 0 || remaining.load() == 0;
+      });
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < workers; i++) {
+    threads.emplace_back(work, i);
+  }
+  work(0);
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <functional>
+#include <cstddef>
+#include <vector>
+
+namespace driver {
+
+//////////////////////////////////////////////////////////////////////
+
+// Runs a DAG of jobs on a work-stealing pool.
+//
+// A job becomes ready when all of its dependencies have finished and
+// is pushed onto the deque of the worker that finished the last one:
+// the owner pops from the back (what it just made ready is hot in its
+// cache), idle workers steal from the front of the others' deques.
+//
+// The number of workers is the -j cap: external tools run inside jobs,
+// so at most that many of them are alive at once.
+//
+// As with make without -k, after the first failure no new jobs start;
+// the exception is rethrown from `Run`.
+
+class TaskGraph {
+ public:
+  using TaskId = size_t;
+
+  TaskId Add(std::function<void()> job, std::vector<TaskId> deps = {});
+
+  void Run(size_t workers);
+
+  size_t Size() const {
+    return tasks_.size();
+  }
+
+ private:
+  struct Task {
+    std::function<void()> job;
+    std::vector<TaskId> dependents;
+    size_t deps = 0;
+  };
+
+  std::vector<Task> tasks_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace driver
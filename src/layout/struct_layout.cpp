@@ -0,0 +1,109 @@
+#include <layout/struct_layout.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <bit>
+
+namespace layout {
+
+//////////////////////////////////////////////////////////////////////
+
+static size_t AlignUp(size_t offset, size_t align) {
+  return (offset + align - 1) & ~(align - 1);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+StructLayout ComputeLayout(std::span<const FieldSpec> fields, Repr repr) {
+  std::vector<size_t> order(fields.size());
+  std::iota(order.begin(), order.end(), 0);
+
+  if (repr == Repr::AUTO) {
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return fields[a].align > fields[b].align;
+    });
+  }
+
+  StructLayout result;
+  result.fields.resize(fields.size());
+
+  size_t offset = 0;
+
+  for (auto index : order) {
+    auto& spec = fields[index];
+    FMT_ASSERT(std::has_single_bit(spec.align), "Bad field alignment");
+
+    offset = AlignUp(offset, spec.align);
+
+    auto& field = result.fields[index];
+    field.name = spec.name;
+    field.offset = offset;
+    field.size = spec.size;
+    field.align = spec.align;
+    field.qbe_type = spec.qbe_type;
+
+    offset += spec.size;
+    result.align = std::max(result.align, spec.align);
+  }
+
+  result.size = AlignUp(offset, result.align);
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+const FieldLayout* StructLayout::Find(std::string_view field) const {
+  for (auto& candidate : fields) {
+    if (candidate.name == field) {
+      return &candidate;
+    }
+  }
+  return nullptr;
+}
+
+size_t StructLayout::Padding() const {
+  size_t used = 0;
+  for (auto& field : fields) {
+    used += field.size;
+  }
+  return size - used;
+}
+
+void StructLayout::EmitQbeType(std::string_view name,
+                               qbe::IrEmitter& out) const {
+  std::vector<const FieldLayout*> in_memory;
+  for (auto& field : fields) {
+    in_memory.push_back(&field);
+  }
+
+  std::stable_sort(in_memory.begin(), in_memory.end(),
+                   [](auto* a, auto* b) {
+                     return a->offset < b->offset;
+                   });
+
+  std::string members;
+  for (auto* field : in_memory) {
+    if (!members.empty()) {
+      members += ", ";
+    }
+    members += field->qbe_type;
+  }
+
+  out.Emit("type :{} = align {} {{ {} }}", name, align, members);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void EmitFieldAddress(qbe::IrEmitter& out, qbe::QbeValue dst,
+                      qbe::QbeValue base, const FieldLayout& field) {
+  if (field.offset == 0) {
+    out.EmitInstr("{} =l copy {}", dst, base);
+  } else {
+    out.EmitInstr("{} =l add {}, {}", dst, base, field.offset);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace layout
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <qbe/ir_emitter.hpp>
+#include <qbe/qbe_value.hpp>
+
+#include <string_view>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <span>
+
+namespace layout {
+
+//////////////////////////////////////////////////////////////////////
+
+// What the layout engine needs to know about a field's type
+
+struct FieldSpec {
+  std::string name;
+
+  size_t size = 0;
+  size_t align = 1;  // power of two
+
+  // QBE spelling used in aggregate definitions: `b`, `w`, `l`, `:Vec`
+  std::string qbe_type;
+};
+
+enum class Repr {
+  // Fields may be reordered to minimize padding
+  AUTO,
+
+  // Declaration order, C rules: for types shared with C code
+  DECLARED,
+};
+
+//////////////////////////////////////////////////////////////////////
+
+struct FieldLayout {
+  std::string name;
+
+  size_t offset = 0;
+  size_t size = 0;
+  size_t align = 1;
+
+  std::string qbe_type;
+};
+
+struct StructLayout {
+  // Multiple of `align`, so also the stride in arrays
+  size_t size = 0;
+  size_t align = 1;
+
+  // In declaration order, whatever the order in memory
+  std::vector<FieldLayout> fields;
+
+  const FieldLayout* Find(std::string_view field) const;
+
+  // Bytes not covered by any field
+  size_t Padding() const;
+
+  // Aggregate definition for QBE, fields listed in memory order:
+  //   type :Point = align 8 { l, w, b }
+  void EmitQbeType(std::string_view name, qbe::IrEmitter& out) const;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Sizes and offsets of `type X = struct { ... }`.
+//
+// With Repr::AUTO fields go in order of decreasing alignment, which
+// for power-of-two alignments leaves padding only at the very end:
+// { a: Bool, b: Int, c: Bool } takes 16 bytes rather than 24.
+// The sort is stable, so equally aligned fields keep their order.
+StructLayout ComputeLayout(std::span<const FieldSpec> fields,
+                           Repr repr = Repr::AUTO);
+
+// Lowering of `base.field` / `base->field`: address of the field in
+// `dst`, given the address of the struct in `base`
+void EmitFieldAddress(qbe::IrEmitter& out, qbe::QbeValue dst,
+                      qbe::QbeValue base, const FieldLayout& field);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace layout
@@ -1,5 +1,7 @@
 #include <lex/lexer.hpp>
 
+#include <stats/stats.hpp>
+
 namespace lex {
 
 Lexer::Lexer(std::istream& source) : scanner_{source} {
@@ -8,6 +10,10 @@ Lexer::Lexer(std::istream& source) : scanner_{source} {
 ////////////////////////////////////////////////////////////////////
 
 Token Lexer::GetNextToken() {
+  // Timed with the parse that asks for it: a phase per token would
+  // cost more than most tokens do
+  stats::Count(stats::Counter::TOKENS);
+
   SkipWhitespace();
 
   SkipComments();
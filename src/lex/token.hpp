@@ -2,6 +2,7 @@
 
 #include <lex/scanner.hpp>
 
+#include <string_view>
 #include <variant>
 #include <cstddef>
 
@@ -10,7 +11,17 @@ namespace lex {
 //////////////////////////////////////////////////////////////////////
 
 struct Token {
-    // Your code goes here
+  TokenType type{};
+  Location location;
+
+  // Identifiers: the spelling; literals: the value
+  std::variant<std::monostate, int, std::string_view> sem_info;
+
+  std::string_view GetName() const {
+    return std::get<std::string_view>(sem_info);
+  }
+
+  // Your code goes here
 };
 
 //////////////////////////////////////////////////////////////////////
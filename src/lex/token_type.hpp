@@ -7,6 +7,15 @@ namespace lex {
 //////////////////////////////////////////////////////////////////////
 
 enum class TokenType {
+  // The kinds the parser already names (spelled as in tests/lex)
+  IDENTIFIER,
+  SEMICOLUMN,  // `;`
+  FUN,
+  VAR,
+  IMPORT,
+  EXPORT,
+  TOKEN_EOF,
+
   // Your code goes here
 };
 
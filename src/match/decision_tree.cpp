@@ -0,0 +1,430 @@
+#include <match/decision_tree.hpp>
+#include <match/match_error.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+namespace match {
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+const Pattern kAny{};
+
+struct Row {
+  std::vector<const Pattern*> patterns;
+  size_t arm = 0;
+  std::vector<std::pair<std::string, Occurrence>> bindings;
+};
+
+// One test on the path to the current node, for the witness
+struct Step {
+  Occurrence occurrence;
+  const Shape* shape;
+
+  // The tag taken, or none for the fallback (any tag not in `seen`)
+  std::optional<int64_t> tag;
+  std::vector<int64_t> seen;
+};
+
+class Compiler {
+ public:
+  explicit Compiler(size_t arms) : used_(arms) {
+  }
+
+  std::unique_ptr<Decision> Build(std::vector<Row> rows,
+                                  std::vector<Occurrence> occurrences,
+                                  std::vector<const Shape*> shapes,
+                                  size_t depth);
+
+  MatchResult Finish(std::unique_ptr<Decision> tree);
+
+ private:
+  static void Bind(Row& row, const Pattern& pattern,
+                   const Occurrence& occurrence) {
+    if (!pattern.binding.empty()) {
+      row.bindings.emplace_back(pattern.binding, occurrence);
+    }
+  }
+
+  size_t PickColumn(const std::vector<Row>& rows) const;
+
+  std::string Witness(const Occurrence& occurrence) const;
+
+ private:
+  std::vector<bool> used_;
+  std::vector<Step> path_;
+
+  std::optional<std::string> missing_;
+  size_t depth_ = 0;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// The column the first row needs, that most rows below also test
+size_t Compiler::PickColumn(const std::vector<Row>& rows) const {
+  size_t best = 0;
+  size_t best_score = 0;
+
+  for (size_t column = 0; column < rows[0].patterns.size(); column++) {
+    size_t score = 0;
+    while (score < rows.size() &&
+           rows[score].patterns[column]->kind ==
+               Pattern::Kind::CONSTRUCTOR) {
+      score += 1;
+    }
+
+    if (score > best_score) {
+      best = column;
+      best_score = score;
+    }
+  }
+
+  return best;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<Decision> Compiler::Build(
+    std::vector<Row> rows, std::vector<Occurrence> occurrences,
+    std::vector<const Shape*> shapes, size_t depth) {
+  auto node = std::make_unique<Decision>();
+
+  if (rows.empty()) {
+    depth_ = std::max(depth_, depth);
+    if (!missing_) {
+      missing_ = Witness({});
+    }
+    return node;  // FAIL
+  }
+
+  auto& first = rows[0];
+
+  bool all_wildcards = std::all_of(
+      first.patterns.begin(), first.patterns.end(), [](auto* pattern) {
+        return pattern->kind == Pattern::Kind::WILDCARD;
+      });
+
+  if (all_wildcards) {
+    depth_ = std::max(depth_, depth);
+
+    for (size_t column = 0; column < first.patterns.size(); column++) {
+      Bind(first, *first.patterns[column], occurrences[column]);
+    }
+
+    used_[first.arm] = true;
+
+    node->kind = Decision::Kind::LEAF;
+    node->arm = first.arm;
+    node->bindings = std::move(first.bindings);
+    return node;
+  }
+
+  auto column = PickColumn(rows);
+  auto& shape = *shapes[column];
+
+  node->kind = Decision::Kind::SWITCH;
+  node->occurrence = occurrences[column];
+
+  // Tags in the order the arms mention them
+  std::vector<int64_t> tags;
+  for (auto& row : rows) {
+    auto* pattern = row.patterns[column];
+    if (pattern->kind == Pattern::Kind::CONSTRUCTOR &&
+        std::find(tags.begin(), tags.end(), pattern->tag) == tags.end()) {
+      tags.push_back(pattern->tag);
+    }
+  }
+
+  auto remove_column = [column](auto vector) {
+    vector.erase(vector.begin() + column);
+    return vector;
+  };
+
+  path_.push_back(Step{
+      .occurrence = occurrences[column],
+      .shape = &shape,
+      .tag = {},
+      .seen = {},
+  });
+
+  for (auto tag : tags) {
+    auto arity = shape.open ? 0 : shape.constructors[tag].fields.size();
+
+    // Specialize: the column is replaced by the constructor's fields
+    auto sub_occurrences = remove_column(occurrences);
+    auto sub_shapes = remove_column(shapes);
+    for (size_t i = 0; i < arity; i++) {
+      auto field = occurrences[column];
+      field.push_back(i);
+      sub_occurrences.push_back(std::move(field));
+      sub_shapes.push_back(&shape.constructors[tag].fields[i]);
+    }
+
+    std::vector<Row> specialized;
+    for (auto& row : rows) {
+      auto* pattern = row.patterns[column];
+      if (pattern->kind == Pattern::Kind::CONSTRUCTOR &&
+          pattern->tag != tag) {
+        continue;
+      }
+
+      auto& copy = specialized.emplace_back(row);
+      copy.patterns = remove_column(row.patterns);
+
+      if (pattern->kind == Pattern::Kind::WILDCARD) {
+        Bind(copy, *pattern, occurrences[column]);
+        copy.patterns.insert(copy.patterns.end(), arity, &kAny);
+      } else {
+        for (auto& field : pattern->fields) {
+          copy.patterns.push_back(&field);
+        }
+      }
+    }
+
+    path_.back().tag = tag;
+    node->cases.push_back(Decision::Case{
+        .tag = tag,
+        .next = Build(std::move(specialized), std::move(sub_occurrences),
+                      std::move(sub_shapes), depth + 1),
+    });
+  }
+
+  bool complete = !shape.open && tags.size() == shape.constructors.size();
+
+  if (!complete) {
+    std::vector<Row> fallback;
+    for (auto& row : rows) {
+      auto* pattern = row.patterns[column];
+      if (pattern->kind == Pattern::Kind::WILDCARD) {
+        auto& copy = fallback.emplace_back(row);
+        Bind(copy, *pattern, occurrences[column]);
+        copy.patterns = remove_column(row.patterns);
+      }
+    }
+
+    path_.back().tag.reset();
+    path_.back().seen = tags;
+    node->fallback = Build(std::move(fallback), remove_column(occurrences),
+                           remove_column(shapes), depth + 1);
+  }
+
+  path_.pop_back();
+  return node;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::string Compiler::Witness(const Occurrence& occurrence) const {
+  auto step = std::find_if(path_.begin(), path_.end(), [&](auto& step) {
+    return step.occurrence == occurrence;
+  });
+
+  if (step == path_.end()) {
+    return "_";
+  }
+
+  auto& shape = *step->shape;
+
+  if (shape.open) {
+    return step->tag ? fmt::format("{}", *step->tag) : "_";
+  }
+
+  auto tag = step->tag.value_or(0);
+  if (!step->tag) {
+    // Some constructor the arms did not mention
+    while (std::find(step->seen.begin(), step->seen.end(), tag) !=
+           step->seen.end()) {
+      tag += 1;
+    }
+  }
+
+  auto& constructor = shape.constructors[tag];
+
+  std::vector<std::string> fields;
+  for (size_t i = 0; i < constructor.fields.size(); i++) {
+    auto field = occurrence;
+    field.push_back(i);
+    fields.push_back(step->tag ? Witness(field) : "_");
+  }
+
+  auto name = constructor.name.empty() ? "" : "." + constructor.name;
+  if (fields.empty()) {
+    return name;
+  }
+  return fmt::format("{}({})", name, fmt::join(fields, ", "));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+MatchResult Compiler::Finish(std::unique_ptr<Decision> tree) {
+  MatchResult result;
+  result.tree = std::move(tree);
+  result.missing = std::move(missing_);
+  result.depth = depth_;
+
+  for (size_t arm = 0; arm < used_.size(); arm++) {
+    if (!used_[arm]) {
+      result.redundant_arms.push_back(arm);
+    }
+  }
+
+  return result;
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+MatchResult Compile(const Shape& scrutinee, std::span<const Pattern> arms) {
+  std::vector<Row> rows;
+  for (size_t arm = 0; arm < arms.size(); arm++) {
+    rows.push_back(Row{.patterns = {&arms[arm]}, .arm = arm, .bindings = {}});
+  }
+
+  Compiler compiler{arms.size()};
+  auto tree = compiler.Build(std::move(rows), {Occurrence{}}, {&scrutinee},
+                             /*depth=*/0);
+  return compiler.Finish(std::move(tree));
+}
+
+void RequireExhaustive(const MatchResult& result) {
+  if (result.missing) {
+    throw errors::NonExhaustiveMatchError{*result.missing};
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Value, shape and (once switched on) constructor of an occurrence
+struct Known {
+  qbe::QbeValue value;
+  const Shape* shape;
+  std::optional<int64_t> tag;
+};
+
+class TreeEmitter {
+ public:
+  TreeEmitter(qbe::IrEmitter& out, const Access& access,
+              const std::string& prefix)
+      : out_{out}, access_{access}, prefix_{prefix} {
+  }
+
+  void Emit(const Decision& node, std::map<Occurrence, Known> known);
+
+ private:
+  std::string NewLabel() {
+    return fmt::format("{}.{}", prefix_, next_label_++);
+  }
+
+  // Loaded on first use; the load dominates everything below
+  Known& Lookup(std::map<Occurrence, Known>& known,
+                const Occurrence& occurrence);
+
+ private:
+  qbe::IrEmitter& out_;
+  const Access& access_;
+  const std::string& prefix_;
+  size_t next_label_ = 0;
+};
+
+Known& TreeEmitter::Lookup(std::map<Occurrence, Known>& known,
+                           const Occurrence& occurrence) {
+  if (auto it = known.find(occurrence); it != known.end()) {
+    return it->second;
+  }
+
+  Occurrence parent_path{occurrence.begin(), occurrence.end() - 1};
+  auto& parent = Lookup(known, parent_path);
+  FMT_ASSERT(parent.tag.has_value(), "Field of an untested value");
+
+  auto index = occurrence.back();
+  auto& shape = parent.shape->constructors[*parent.tag].fields[index];
+  auto value =
+      access_.load_field(parent.value, *parent.shape, *parent.tag, index);
+
+  return known[occurrence] = Known{.value = value, .shape = &shape, .tag = {}};
+}
+
+void TreeEmitter::Emit(const Decision& node,
+                       std::map<Occurrence, Known> known) {
+  switch (node.kind) {
+    case Decision::Kind::FAIL:
+      access_.emit_fail();
+      return;
+
+    case Decision::Kind::LEAF: {
+      std::vector<std::pair<std::string, qbe::QbeValue>> bound;
+      for (auto& [name, occurrence] : node.bindings) {
+        bound.emplace_back(name, Lookup(known, occurrence).value);
+      }
+      access_.emit_arm(node.arm, bound);
+      return;
+    }
+
+    case Decision::Kind::SWITCH:
+      break;
+  }
+
+  auto& scrutinee = Lookup(known, node.occurrence);
+  auto* shape = scrutinee.shape;
+
+  // A struct, or the only constructor left: nothing to test
+  if (node.cases.size() == 1 && !node.fallback) {
+    scrutinee.tag = node.cases[0].tag;
+    Emit(*node.cases[0].next, std::move(known));
+    return;
+  }
+
+  auto tag = access_.load_tag(scrutinee.value, *shape);
+
+  std::vector<qbe::SwitchCase> cases;
+  for (auto& c : node.cases) {
+    cases.push_back({.value = c.tag, .label = NewLabel()});
+  }
+
+  // Without a fallback the last case needs no compare
+  auto fallback = node.fallback ? NewLabel() : cases.back().label;
+  auto tested = cases;
+  if (!node.fallback) {
+    tested.pop_back();
+  }
+
+  qbe::EmitSwitch(out_, tag, tested, fallback, NewLabel(), access_.fresh,
+                  shape->open ? 'l' : 'w');
+
+  for (size_t i = 0; i < cases.size(); i++) {
+    out_.Emit("@{}", cases[i].label);
+    auto branch = known;
+    branch[node.occurrence].tag = node.cases[i].tag;
+    Emit(*node.cases[i].next, std::move(branch));
+  }
+
+  if (node.fallback) {
+    out_.Emit("@{}", fallback);
+    Emit(*node.fallback, std::move(known));
+  }
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+void EmitDecisionTree(qbe::IrEmitter& out, const Decision& tree,
+                      const Shape& scrutinee, qbe::QbeValue value,
+                      const Access& access, const std::string& label_prefix) {
+  std::map<Occurrence, Known> known;
+  known[{}] = Known{.value = value, .shape = &scrutinee, .tag = {}};
+
+  TreeEmitter{out, access, label_prefix}.Emit(tree, std::move(known));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace match
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <qbe/ir_emitter.hpp>
+#include <qbe/qbe_value.hpp>
+#include <qbe/switch.hpp>
+
+#include <functional>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <span>
+
+namespace match {
+
+//////////////////////////////////////////////////////////////////////
+
+// Compiles `match` into a decision tree (Maranget, "Compiling Pattern
+// Matching to Good Decision Trees"; tasks/projects.md, section 4):
+//
+//   match message {
+//   | .some .ping: ...
+//   | .some msg: ...        <<<----- .some is not tested again
+//   | .none: ...
+//   }
+//
+// Every path through the tree tests each tag and field at most once.
+// Arms that no leaf reaches are redundant; a reachable failure leaf
+// means the match is not exhaustive, and the path to it gives an
+// example of a value that is not covered.
+
+//////////////////////////////////////////////////////////////////////
+
+// The shape of the matched type, as far as patterns can see it.
+//
+//   Maybe(Bool):  constructors {none: {}, some: {Bool}}
+//   struct:       a single constructor with the fields
+//   Int, Char:    open; the literals are the constructors
+
+struct Shape {
+  struct Constructor {
+    std::string name;
+    std::vector<Shape> fields;
+  };
+
+  std::vector<Constructor> constructors;
+
+  bool open = false;
+
+  static Shape Open() {
+    Shape shape;
+    shape.open = true;
+    return shape;
+  }
+};
+
+//////////////////////////////////////////////////////////////////////
+
+struct Pattern {
+  enum class Kind {
+    WILDCARD,     // `_` or a binding `x`
+    CONSTRUCTOR,  // variant, struct or literal
+  };
+
+  Kind kind = Kind::WILDCARD;
+
+  // Bound name, empty for `_`
+  std::string binding;
+
+  // Index into the constructors of the shape, literal value if open
+  int64_t tag = 0;
+  std::vector<Pattern> fields;
+
+  static Pattern Any(std::string binding = {}) {
+    Pattern pattern;
+    pattern.binding = std::move(binding);
+    return pattern;
+  }
+
+  static Pattern Constructor(int64_t tag, std::vector<Pattern> fields = {}) {
+    Pattern pattern;
+    pattern.kind = Kind::CONSTRUCTOR;
+    pattern.tag = tag;
+    pattern.fields = std::move(fields);
+    return pattern;
+  }
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Position in the scrutinee: field indices from the root
+using Occurrence = std::vector<uint32_t>;
+
+struct Decision {
+  enum class Kind {
+    LEAF,
+    FAIL,
+    SWITCH,
+  };
+
+  Kind kind = Kind::FAIL;
+
+  // LEAF: the arm taken and the values its bindings name
+  size_t arm = 0;
+  std::vector<std::pair<std::string, Occurrence>> bindings;
+
+  // SWITCH on the tag at `occurrence`
+  Occurrence occurrence;
+
+  struct Case {
+    int64_t tag;
+    std::unique_ptr<Decision> next;
+  };
+
+  std::vector<Case> cases;
+
+  // Null if the cases cover every constructor
+  std::unique_ptr<Decision> fallback;
+};
+
+struct MatchResult {
+  std::unique_ptr<Decision> tree;
+
+  // Arms no value can reach, e.g. after a catch-all
+  std::vector<size_t> redundant_arms;
+
+  // A value no arm covers, printed like a pattern: `.some(.pong)`
+  std::optional<std::string> missing;
+
+  // Tests on the longest path, for diagnostics and benchmarks
+  size_t depth = 0;
+};
+
+MatchResult Compile(const Shape& scrutinee, std::span<const Pattern> arms);
+
+// Throws NonExhaustiveMatchError with the witness
+void RequireExhaustive(const MatchResult& result);
+
+//////////////////////////////////////////////////////////////////////
+
+// How the lowered match reaches into the scrutinee
+
+struct Access {
+  // Tag (class w) of a value of a closed shape; for an open shape the
+  // value itself, extended to class l
+  std::function<qbe::QbeValue(qbe::QbeValue value, const Shape& shape)>
+      load_tag;
+
+  // Field `index` of a value known to be built by `constructor`
+  std::function<qbe::QbeValue(qbe::QbeValue value, const Shape& shape,
+                              size_t constructor, size_t index)>
+      load_field;
+
+  // Emit the arm: its bound values are ready in temporaries
+  std::function<void(
+      size_t arm, std::span<const std::pair<std::string, qbe::QbeValue>>)>
+      emit_arm;
+
+  // Control reaches a failure leaf (non-exhaustive match)
+  std::function<void()> emit_fail;
+
+  qbe::FreshTemp fresh;
+};
+
+// Lowers the tree starting in the current block; every tag and field
+// is loaded once on each path. Labels start with `label_prefix`.
+void EmitDecisionTree(qbe::IrEmitter& out, const Decision& tree,
+                      const Shape& scrutinee, qbe::QbeValue value,
+                      const Access& access, const std::string& label_prefix);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace match
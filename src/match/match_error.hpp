@@ -0,0 +1,24 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <string>
+
+namespace match::errors {
+
+struct MatchError : std::exception {
+  std::string message;
+
+  const char* what() const noexcept override {
+    return message.c_str();
+  }
+};
+
+struct NonExhaustiveMatchError : MatchError {
+  NonExhaustiveMatchError(const std::string& witness) {
+    message = fmt::format("Match is not exhaustive: {} is not covered\n",
+                          witness);
+  }
+};
+
+}  // namespace match::errors
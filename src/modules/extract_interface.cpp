@@ -0,0 +1,38 @@
+#include <modules/interface.hpp>
+
+#include <ast/declarations.hpp>
+
+namespace modules {
+
+//////////////////////////////////////////////////////////////////////
+
+ModuleInterface ExtractInterface(std::string_view module,
+                                 std::span<Declaration* const> declarations) {
+  ModuleInterface interface;
+  interface.name = module;
+
+  for (auto declaration : declarations) {
+    if (auto import = declaration->as<ImportDeclaration>()) {
+      interface.imports.emplace_back(import->GetName());
+      continue;
+    }
+
+    if (!declaration->exported_) {
+      continue;
+    }
+
+    auto kind = declaration->as<FunDeclStatement>()
+                    ? ExportedSymbol::Kind::FUNCTION
+                    : ExportedSymbol::Kind::VARIABLE;
+
+    auto& symbol = interface.exports.emplace_back();
+    symbol.kind = kind;
+    symbol.name = declaration->GetName();
+  }
+
+  return interface;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace modules
@@ -0,0 +1,304 @@
+#include <modules/interface.hpp>
+#include <modules/module_error.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace modules {
+
+//////////////////////////////////////////////////////////////////////
+
+// Layout:
+//
+//   magic "ETI" + version byte
+//   string           module name
+//   varint n, n * (string)                        imports
+//   varint n, n * (kind byte, string, string)     exports
+//
+// where string = varint length + bytes, varint = unsigned LEB128
+
+static constexpr std::string_view kMagic = "ETI";
+static constexpr uint8_t kVersion = 1;
+
+//////////////////////////////////////////////////////////////////////
+
+const ExportedSymbol* ModuleInterface::Find(std::string_view symbol) const {
+  auto it = std::find_if(exports.begin(), exports.end(), [&](auto& sym) {
+    return sym.name == symbol;
+  });
+  return it == exports.end() ? nullptr : &*it;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+class Writer {
+ public:
+  void Byte(uint8_t byte) {
+    out_.push_back(static_cast<char>(byte));
+  }
+
+  void Varint(uint64_t value) {
+    while (value >= 0x80) {
+      Byte((value & 0x7F) | 0x80);
+      value >>= 7;
+    }
+    Byte(value);
+  }
+
+  void String(std::string_view str) {
+    Varint(str.size());
+    out_.append(str);
+  }
+
+  std::string Take() {
+    return std::move(out_);
+  }
+
+ private:
+  std::string out_;
+};
+
+class Reader {
+ public:
+  Reader(std::string_view bytes, const std::string& origin)
+      : bytes_{bytes}, origin_{origin} {
+  }
+
+  uint8_t Byte() {
+    if (pos_ >= bytes_.size()) {
+      throw errors::InterfaceFormatError{origin_, "unexpected end of file"};
+    }
+    return bytes_[pos_++];
+  }
+
+  uint64_t Varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte = Byte();
+      value |= uint64_t{byte & 0x7Fu} << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    throw errors::InterfaceFormatError{origin_, "varint is too long"};
+  }
+
+  std::string String() {
+    auto size = Varint();
+    if (size > bytes_.size() - pos_) {
+      throw errors::InterfaceFormatError{origin_, "string out of bounds"};
+    }
+    std::string result{bytes_.substr(pos_, size)};
+    pos_ += size;
+    return result;
+  }
+
+  std::string_view Raw(size_t size) {
+    auto result = bytes_.substr(pos_, size);
+    pos_ += result.size();
+    return result;
+  }
+
+  bool AtEnd() const {
+    return pos_ == bytes_.size();
+  }
+
+  const std::string& Origin() const {
+    return origin_;
+  }
+
+ private:
+  std::string_view bytes_;
+  const std::string& origin_;
+  size_t pos_ = 0;
+};
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+std::string Serialize(const ModuleInterface& interface) {
+  Writer out;
+
+  for (char ch : kMagic) {
+    out.Byte(ch);
+  }
+  out.Byte(kVersion);
+
+  out.String(interface.name);
+
+  out.Varint(interface.imports.size());
+  for (auto& import : interface.imports) {
+    out.String(import);
+  }
+
+  out.Varint(interface.exports.size());
+  for (auto& symbol : interface.exports) {
+    out.Byte(static_cast<uint8_t>(symbol.kind));
+    out.String(symbol.name);
+    out.String(symbol.type);
+  }
+
+  return out.Take();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+ModuleInterface Deserialize(std::string_view bytes, const std::string& origin) {
+  Reader in{bytes, origin};
+
+  if (in.Raw(kMagic.size()) != kMagic) {
+    throw errors::InterfaceFormatError{origin, "not an interface file"};
+  }
+
+  if (in.Byte() != kVersion) {
+    throw errors::InterfaceFormatError{origin, "unsupported version"};
+  }
+
+  ModuleInterface interface;
+  interface.name = in.String();
+
+  auto imports = in.Varint();
+  for (uint64_t i = 0; i < imports; i++) {
+    interface.imports.push_back(in.String());
+  }
+
+  auto exports = in.Varint();
+  for (uint64_t i = 0; i < exports; i++) {
+    auto kind = in.Byte();
+    if (kind > static_cast<uint8_t>(ExportedSymbol::Kind::TYPE)) {
+      throw errors::InterfaceFormatError{origin, "unknown symbol kind"};
+    }
+
+    auto& symbol = interface.exports.emplace_back();
+    symbol.kind = static_cast<ExportedSymbol::Kind>(kind);
+    symbol.name = in.String();
+    symbol.type = in.String();
+  }
+
+  if (!in.AtEnd()) {
+    throw errors::InterfaceFormatError{origin, "trailing bytes"};
+  }
+
+  return interface;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static bool SameContents(const std::filesystem::path& path,
+                         std::string_view bytes) {
+  std::ifstream file{path, std::ios::binary};
+  if (!file) {
+    return false;
+  }
+
+  std::stringstream old;
+  old << file.rdbuf();
+  return old.view() == bytes;
+}
+
+void WriteInterface(const ModuleInterface& interface,
+                    const std::filesystem::path& path) {
+  auto bytes = Serialize(interface);
+
+  // Keep the timestamp when nothing changed, so that the importers
+  // (and the revalidating loader) see no new version
+  if (SameContents(path, bytes)) {
+    return;
+  }
+
+  // Readers in other processes see the old file or the new one,
+  // never a half-written one
+  auto temp = path;
+  temp += ".tmp";
+
+  std::ofstream file{temp, std::ios::binary};
+  file.write(bytes.data(), bytes.size());
+  file.close();
+
+  if (!file) {
+    std::filesystem::remove(temp);
+    throw errors::InterfaceWriteError{path.string()};
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temp, path, error);
+  if (error) {
+    std::filesystem::remove(temp, error);
+    throw errors::InterfaceWriteError{path.string()};
+  }
+}
+
+ModuleInterface ReadInterface(const std::filesystem::path& path) {
+  std::ifstream file{path, std::ios::binary};
+  if (!file) {
+    throw errors::InterfaceNotFoundError{path.string()};
+  }
+
+  std::stringstream bytes;
+  bytes << file.rdbuf();
+
+  return Deserialize(bytes.str(), path.string());
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::filesystem::path InterfaceLoader::Locate(
+    const std::string& module) const {
+  for (auto& dir : search_path_) {
+    auto path = dir / (module + ".eti");
+    if (std::filesystem::exists(path)) {
+      return path;
+    }
+  }
+  return {};
+}
+
+const ModuleInterface& InterfaceLoader::Load(const std::string& module) {
+  std::lock_guard guard{mutex_};
+
+  auto it = loaded_.find(module);
+  if (it != loaded_.end() && !revalidate_) {
+    return *it->second.interface;
+  }
+
+  auto path = Locate(module);
+  if (path.empty()) {
+    throw errors::InterfaceNotFoundError{module};
+  }
+
+  std::error_code error;
+  auto mtime = std::filesystem::last_write_time(path, error);
+  auto size = std::filesystem::file_size(path, error);
+
+  if (it != loaded_.end()) {
+    auto& cached = it->second;
+    if (cached.path == path && cached.mtime == mtime && cached.size == size) {
+      return *cached.interface;
+    }
+  }
+
+  reads_ += 1;
+
+  // Nothing changes unless the read succeeds: a bad file leaves the
+  // loader as it was, old version included
+  auto fresh = std::make_unique<ModuleInterface>(ReadInterface(path));
+
+  auto& entry = loaded_[module];
+  if (entry.interface) {
+    stale_.push_back(std::move(entry.interface));
+  }
+  entry.interface = std::move(fresh);
+  entry.path = std::move(path);
+  entry.mtime = mtime;
+  entry.size = size;
+
+  return *entry.interface;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace modules
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <map>
+
+class Declaration;
+
+namespace modules {
+
+//////////////////////////////////////////////////////////////////////
+
+// Everything an importer needs to know about a module, without its
+// source: the modules it imports and its exported symbols.
+//
+// Stored next to the object file as `<module>.eti`, a compact binary
+// file: importers read it instead of parsing the module again.
+
+struct ExportedSymbol {
+  enum class Kind : uint8_t {
+    FUNCTION,
+    VARIABLE,
+    TYPE,
+  };
+
+  Kind kind = Kind::FUNCTION;
+
+  std::string name;
+
+  // Printed type (signature for functions, definition for types);
+  // empty until the type checker fills it in
+  std::string type;
+
+  bool operator==(const ExportedSymbol&) const = default;
+};
+
+struct ModuleInterface {
+  std::string name;
+
+  std::vector<std::string> imports;
+  std::vector<ExportedSymbol> exports;
+
+  const ExportedSymbol* Find(std::string_view symbol) const;
+
+  bool operator==(const ModuleInterface&) const = default;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Collect imports and exported declarations of a parsed module
+ModuleInterface ExtractInterface(std::string_view module,
+                                 std::span<Declaration* const> declarations);
+
+//////////////////////////////////////////////////////////////////////
+
+std::string Serialize(const ModuleInterface& interface);
+
+// `origin` only names the source in error messages
+ModuleInterface Deserialize(std::string_view bytes,
+                            const std::string& origin = "<memory>");
+
+// Leaves the file untouched if it already holds these bytes;
+// otherwise replaces it atomically (through `<path>.tmp`)
+void WriteInterface(const ModuleInterface& interface,
+                    const std::filesystem::path& path);
+
+ModuleInterface ReadInterface(const std::filesystem::path& path);
+
+//////////////////////////////////////////////////////////////////////
+
+// Finds `<module>.eti` along the search path and keeps every
+// interface it has read, so each file is loaded once per compilation.
+// Safe to share between threads.
+//
+// A loader kept across compilations (by the compile server) is built
+// with `revalidate`: it checks the file on every `Load` and reads it
+// again if it was rewritten. References handed out earlier stay valid.
+
+class InterfaceLoader {
+ public:
+  explicit InterfaceLoader(std::vector<std::filesystem::path> search_path,
+                           bool revalidate = false)
+      : search_path_{std::move(search_path)}, revalidate_{revalidate} {
+  }
+
+  const ModuleInterface& Load(const std::string& module);
+
+  // Where `Load` would read the interface from, empty if nowhere
+  std::filesystem::path Locate(const std::string& module) const;
+
+  // Interfaces read from disk so far, including re-reads
+  size_t ReadCount() {
+    std::lock_guard guard{mutex_};
+    return reads_;
+  }
+
+ private:
+  struct Loaded {
+    std::unique_ptr<ModuleInterface> interface;
+    std::filesystem::path path;
+    std::filesystem::file_time_type mtime;
+    uintmax_t size = 0;
+  };
+
+  std::vector<std::filesystem::path> search_path_;
+  bool revalidate_ = false;
+
+  std::mutex mutex_;
+  std::map<std::string, Loaded, std::less<>> loaded_;
+
+  // Replaced by a newer version of the file, still referenced
+  std::vector<std::unique_ptr<ModuleInterface>> stale_;
+
+  size_t reads_ = 0;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace modules
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <string>
+
+namespace modules::errors {
+
+struct ModuleError : std::exception {
+  std::string message;
+
+  const char* what() const noexcept override {
+    return message.c_str();
+  }
+};
+
+struct InterfaceNotFoundError : ModuleError {
+  InterfaceNotFoundError(const std::string& module) {
+    message = fmt::format("Could not find interface of module {}\n", module);
+  }
+};
+
+struct InterfaceFormatError : ModuleError {
+  InterfaceFormatError(const std::string& path, const std::string& what) {
+    message = fmt::format("Malformed interface file {}: {}\n", path, what);
+  }
+};
+
+struct InterfaceWriteError : ModuleError {
+  InterfaceWriteError(const std::string& path) {
+    message = fmt::format("Could not write interface file {}\n", path);
+  }
+};
+
+}  // namespace modules::errors
@@ -0,0 +1,178 @@
+#include <mono/instantiation_cache.hpp>
+#include <mono/mono_error.hpp>
+
+#include <stats/stats.hpp>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <utility>
+#include <fstream>
+
+namespace mono {
+
+//////////////////////////////////////////////////////////////////////
+
+static constexpr std::string_view kHeader = "etude-instances 1";
+
+//////////////////////////////////////////////////////////////////////
+
+static bool IsPlain(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9');
+}
+
+std::string Mangle(std::string_view function,
+                   std::span<const std::string_view> type_args) {
+  std::string symbol{function};
+  if (type_args.empty()) {
+    return symbol;
+  }
+
+  symbol += '.';
+
+  std::string escaped;
+  for (auto spelling : type_args) {
+    escaped.clear();
+    for (char c : spelling) {
+      if (IsPlain(c)) {
+        escaped += c;
+      } else {
+        escaped += fmt::format("_{:02x}", static_cast<unsigned char>(c));
+      }
+    }
+
+    symbol += fmt::format("{}{}", escaped.size(), escaped);
+  }
+
+  return symbol;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+bool InstantiationCache::Key::operator==(const Key& other) const {
+  return function == other.function &&
+         std::equal(type_args.begin(), type_args.end(),
+                    other.type_args.begin(), other.type_args.end());
+}
+
+size_t InstantiationCache::KeyHash::operator()(const Key& key) const {
+  auto hash = std::hash<std::string_view>{}(key.function);
+  for (auto id : key.type_args) {
+    hash = hash * 31 + id;
+  }
+  return hash;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+InstantiationCache::InstantiationCache(TypeInterner& types,
+                                       StrategyPolicy policy)
+    : types_{types}, policy_{std::move(policy)} {
+}
+
+Strategy InstantiationCache::StrategyFor(std::string_view function) const {
+  return policy_.For(function);
+}
+
+std::string_view InstantiationCache::Request(
+    std::string_view function, std::span<const TypeId> type_args) {
+  auto strategy = policy_.For(function);
+  if (strategy == Strategy::DICTIONARY) {
+    type_args = {};
+  }
+
+  std::lock_guard guard{mutex_};
+
+  if (auto it = index_.find(Key{function, type_args});
+      it != index_.end()) {
+    hits_ += 1;
+    return it->second->symbol;
+  }
+
+  std::vector<std::string_view> spellings;
+  for (auto id : type_args) {
+    spellings.push_back(types_.Spelling(id));
+  }
+
+  auto& instance = instances_.emplace_back(Instance{
+      .function = std::string{function},
+      .type_args = {type_args.begin(), type_args.end()},
+      .strategy = strategy,
+      .symbol = Mangle(function, spellings),
+  });
+
+  index_.emplace(Key{instance.function, instance.type_args}, &instance);
+
+  if (external_.contains(instance.symbol)) {
+    hits_ += 1;
+  } else {
+    lowered_ += 1;
+    pending_.push_back(&instance);
+    stats::Count(stats::Counter::INSTANTIATIONS);
+  }
+
+  return instance.symbol;
+}
+
+std::vector<const Instance*> InstantiationCache::TakePending() {
+  std::lock_guard guard{mutex_};
+  return std::exchange(pending_, {});
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void InstantiationCache::Load(const std::filesystem::path& path) {
+  std::ifstream file{path};
+  if (!file) {
+    throw errors::CacheFileError{path.string(), "cannot open"};
+  }
+
+  std::string line;
+  if (!std::getline(file, line) || line != kHeader) {
+    throw errors::CacheFileError{path.string(), "bad header"};
+  }
+
+  std::lock_guard guard{mutex_};
+
+  while (std::getline(file, line)) {
+    if (!line.empty()) {
+      external_.insert(line);
+    }
+  }
+}
+
+void InstantiationCache::Save(const std::filesystem::path& path) const {
+  std::ofstream file{path};
+  file << kHeader << '\n';
+
+  std::lock_guard guard{mutex_};
+
+  for (auto& instance : instances_) {
+    if (instance.strategy == Strategy::SPECIALIZE &&
+        !instance.type_args.empty() &&
+        !external_.contains(instance.symbol)) {
+      file << instance.symbol << '\n';
+    }
+  }
+
+  if (!file) {
+    throw errors::CacheFileError{path.string(), "cannot write"};
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+size_t InstantiationCache::Hits() const {
+  std::lock_guard guard{mutex_};
+  return hits_;
+}
+
+size_t InstantiationCache::Lowered() const {
+  std::lock_guard guard{mutex_};
+  return lowered_;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace mono
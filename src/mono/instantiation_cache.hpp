@@ -0,0 +1,117 @@
+#pragma once
+
+#include <mono/type_interner.hpp>
+#include <mono/strategy.hpp>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+#include <string_view>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <span>
+
+namespace mono {
+
+//////////////////////////////////////////////////////////////////////
+
+// One specialization of a generic function: `append` at `Int`.
+
+struct Instance {
+  std::string function;
+  // Empty for DICTIONARY functions: one copy serves every type
+  std::vector<TypeId> type_args;
+
+  Strategy strategy = Strategy::SPECIALIZE;
+
+  // Symbol the specialization is emitted under, see Mangle
+  std::string symbol;
+};
+
+// `id` at `Int` becomes `id.3Int`: each argument is length-prefixed
+// and characters QBE does not accept in names are written as `_XX`.
+// Depends on spellings only, so every module picks the same symbol.
+std::string Mangle(std::string_view function,
+                   std::span<const std::string_view> type_args);
+
+//////////////////////////////////////////////////////////////////////
+
+// Makes sure each (function, type arguments) pair is lowered once per
+// compilation, no matter how many call sites use it.
+//
+// Codegen asks for the symbol of a call with Request and emits the
+// call right away; new specializations are queued instead of lowered
+// on the spot, because lowering a body discovers more of them:
+//
+//   cache.Request("main", {});
+//   while (auto batch = cache.TakePending(); !batch.empty()) {
+//     codegen.LowerAll(batch.size(), ...);  // may Request more
+//   }
+//
+// Functions the policy compiles by DICTIONARY are lowered once with
+// no type arguments; the caller passes descriptors instead.
+//
+// Safe to share between codegen workers.
+
+class InstantiationCache {
+ public:
+  explicit InstantiationCache(TypeInterner& types,
+                              StrategyPolicy policy = StrategyPolicy{});
+
+  // Symbol to call; stays valid for the lifetime of the cache
+  std::string_view Request(std::string_view function,
+                           std::span<const TypeId> type_args);
+
+  // Whether calls to `function` take hidden descriptor arguments
+  Strategy StrategyFor(std::string_view function) const;
+
+  // Specializations requested since the last call, in request order
+  std::vector<const Instance*> TakePending();
+
+  // Specializations already lowered by other modules of the program
+  // are only referenced here, not emitted a second time.
+  // The file lists one symbol per line and is produced by Save.
+  void Load(const std::filesystem::path& path);
+
+  // Record the specializations this module emitted
+  void Save(const std::filesystem::path& path) const;
+
+  size_t Hits() const;
+  size_t Lowered() const;
+
+ private:
+  struct Key {
+    std::string_view function;
+    std::span<const TypeId> type_args;
+
+    bool operator==(const Key& other) const;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+ private:
+  TypeInterner& types_;
+  StrategyPolicy policy_;
+
+  mutable std::mutex mutex_;
+
+  // Keys point into the instances, hence a deque
+  std::deque<Instance> instances_;
+  std::unordered_map<Key, const Instance*, KeyHash> index_;
+
+  std::vector<const Instance*> pending_;
+
+  std::unordered_set<std::string> external_;
+
+  size_t hits_ = 0;
+  size_t lowered_ = 0;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace mono
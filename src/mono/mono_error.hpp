@@ -0,0 +1,23 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <string>
+
+namespace mono::errors {
+
+struct MonoError : std::exception {
+  std::string message;
+
+  const char* what() const noexcept override {
+    return message.c_str();
+  }
+};
+
+struct CacheFileError : MonoError {
+  CacheFileError(const std::string& path, const std::string& what) {
+    message = fmt::format("Bad instantiation cache {}: {}\n", path, what);
+  }
+};
+
+}  // namespace mono::errors
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <unordered_map>
+#include <string_view>
+#include <optional>
+#include <string>
+
+namespace mono {
+
+//////////////////////////////////////////////////////////////////////
+
+// How a generic function is compiled:
+//
+//  SPECIALIZE  one copy per set of type arguments (`id.3Int`), each
+//              as fast as hand-written code
+//
+//  DICTIONARY  a single copy taking hidden type-descriptor pointers
+//              (see TypeDescriptor) in front of its own parameters;
+//              slower, but code size does not grow with the types
+
+enum class Strategy {
+  SPECIALIZE,
+  DICTIONARY,
+};
+
+inline std::optional<Strategy> ParseStrategy(std::string_view name) {
+  if (name == "specialize") {
+    return Strategy::SPECIALIZE;
+  }
+  if (name == "dictionary") {
+    return Strategy::DICTIONARY;
+  }
+  return std::nullopt;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Global default (`etudec --generics=...`) with per-function overrides
+// (`--generics-for=<fun>=...`)
+
+class StrategyPolicy {
+ public:
+  explicit StrategyPolicy(Strategy fallback = Strategy::SPECIALIZE)
+      : fallback_{fallback} {
+  }
+
+  void SetDefault(Strategy strategy) {
+    fallback_ = strategy;
+  }
+
+  void Override(std::string function, Strategy strategy) {
+    overrides_[std::move(function)] = strategy;
+  }
+
+  Strategy For(std::string_view function) const {
+    auto it = overrides_.find(std::string{function});
+    return it == overrides_.end() ? fallback_ : it->second;
+  }
+
+ private:
+  Strategy fallback_;
+  std::unordered_map<std::string, Strategy> overrides_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace mono
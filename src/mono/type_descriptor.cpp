@@ -0,0 +1,47 @@
+#include <mono/type_descriptor.hpp>
+#include <mono/instantiation_cache.hpp>
+
+namespace mono {
+
+//////////////////////////////////////////////////////////////////////
+
+DescriptorTable::DescriptorTable(const TypeInterner& types)
+    : types_{types} {
+}
+
+std::string_view DescriptorTable::Require(TypeId type,
+                                          const TypeDescriptor& layout) {
+  std::string_view spelling[] = {types_.Spelling(type)};
+  auto symbol = Mangle(TypeDescriptor::kSymbolPrefix, spelling);
+
+  std::lock_guard guard{mutex_};
+
+  auto [it, inserted] = entries_.try_emplace(std::move(symbol), layout);
+  FMT_ASSERT(inserted || it->second.size == layout.size,
+             "Type layout changed between requests");
+
+  return it->first;
+}
+
+void DescriptorTable::Emit(qbe::IrEmitter& out) const {
+  std::lock_guard guard{mutex_};
+
+  for (auto& [symbol, layout] : entries_) {
+    if (layout.copy.empty()) {
+      out.Emit("data ${} = {{ l {}, l {}, l 0 }}", symbol, layout.size,
+               layout.align);
+    } else {
+      out.Emit("data ${} = {{ l {}, l {}, l ${} }}", symbol, layout.size,
+               layout.align, layout.copy);
+    }
+  }
+}
+
+size_t DescriptorTable::Size() const {
+  std::lock_guard guard{mutex_};
+  return entries_.size();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace mono
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <mono/type_interner.hpp>
+
+#include <qbe/ir_emitter.hpp>
+
+#include <string_view>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <map>
+
+namespace mono {
+
+//////////////////////////////////////////////////////////////////////
+
+// What dictionary-passing code knows about a type argument.
+// Emitted as read-only data, one per concrete type:
+//
+//   data $.td.3Int = { l 8, l 8, l 0 }
+//
+// The leading `.` keeps the name out of the way of user code: it
+// cannot start an identifier, so no function and no specialization
+// of one (see Mangle) is called that.
+//
+// The generic body moves values of the type with the size, allocates
+// stack slots with size and alignment, and calls `copy` if the type
+// needs more than a byte copy (0 otherwise).
+
+struct TypeDescriptor {
+  static constexpr std::string_view kSymbolPrefix = ".td";
+
+  static constexpr size_t kSizeOffset = 0;
+  static constexpr size_t kAlignOffset = 8;
+  static constexpr size_t kCopyOffset = 16;
+
+  size_t size = 0;
+  size_t align = 1;
+
+  // Symbol of `fun(dst: *T, src: *T)`; empty for plain bytes
+  std::string copy;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Collects the descriptors a module refers to, each emitted once.
+// Safe to share between codegen workers.
+
+class DescriptorTable {
+ public:
+  explicit DescriptorTable(const TypeInterner& types);
+
+  // Symbol of the descriptor of `type`, to pass as a hidden argument
+  std::string_view Require(TypeId type, const TypeDescriptor& layout);
+
+  // Data definitions for every required descriptor
+  void Emit(qbe::IrEmitter& out) const;
+
+  size_t Size() const;
+
+ private:
+  const TypeInterner& types_;
+
+  mutable std::mutex mutex_;
+
+  // By symbol, so the output does not depend on worker timing: type
+  // ids are handed out in whatever order the workers intern them
+  std::map<std::string, TypeDescriptor, std::less<>> entries_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace mono
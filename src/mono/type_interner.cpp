@@ -0,0 +1,36 @@
+#include <mono/type_interner.hpp>
+
+#include <fmt/core.h>
+
+namespace mono {
+
+//////////////////////////////////////////////////////////////////////
+
+TypeId TypeInterner::Intern(std::string_view spelling) {
+  std::lock_guard guard{mutex_};
+
+  if (auto it = ids_.find(spelling); it != ids_.end()) {
+    return it->second;
+  }
+
+  auto id = static_cast<TypeId>(spellings_.size());
+  auto& stored = spellings_.emplace_back(spelling);
+  ids_.emplace(stored, id);
+
+  return id;
+}
+
+std::string_view TypeInterner::Spelling(TypeId id) const {
+  std::lock_guard guard{mutex_};
+  FMT_ASSERT(id < spellings_.size(), "Unknown type id");
+  return spellings_[id];
+}
+
+size_t TypeInterner::Size() const {
+  std::lock_guard guard{mutex_};
+  return spellings_.size();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace mono
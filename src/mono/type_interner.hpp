@@ -0,0 +1,42 @@
+#pragma once
+
+#include <unordered_map>
+#include <string_view>
+#include <cstdint>
+#include <string>
+#include <deque>
+#include <mutex>
+
+namespace mono {
+
+//////////////////////////////////////////////////////////////////////
+
+using TypeId = uint32_t;
+
+// Gives every concrete type one small id, so that instantiations can
+// be compared and hashed without walking the types again.
+//
+// Types are interned by their canonical spelling, as printed by the
+// type checker after substitution: `Int`, `*Vec(Bool)`. Spellings
+// are what ends up in symbol names, so they are stable across
+// modules, while ids are only meaningful within one compilation.
+
+class TypeInterner {
+ public:
+  TypeId Intern(std::string_view spelling);
+
+  std::string_view Spelling(TypeId id) const;
+
+  size_t Size() const;
+
+ private:
+  mutable std::mutex mutex_;
+
+  // deque: string_views into it stay valid as it grows
+  std::deque<std::string> spellings_;
+  std::unordered_map<std::string_view, TypeId> ids_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace mono
@@ -0,0 +1,202 @@
+#include <opt/dead_code.hpp>
+#include <opt/opt_error.hpp>
+
+#include <stats/stats.hpp>
+#include <stats/trace.hpp>
+
+#include <fmt/core.h>
+
+#include <unordered_map>
+
+namespace opt {
+
+//////////////////////////////////////////////////////////////////////
+
+CallGraph::SymbolId CallGraph::AddSymbol(std::string_view name, Kind kind) {
+  symbols_.push_back({std::string{name}, kind, {}});
+  return static_cast<SymbolId>(symbols_.size() - 1);
+}
+
+std::optional<CallGraph::SymbolId> CallGraph::Find(
+    std::string_view name) const {
+  for (SymbolId i = 0; i < symbols_.size(); i++) {
+    if (symbols_[i].name == name) {
+      return i;
+    }
+  }
+  return std::nullopt;
+}
+
+void CallGraph::AddRoot(SymbolId symbol) {
+  roots_.push_back(symbol);
+}
+
+void CallGraph::AddReference(SymbolId from, SymbolId to) {
+  symbols_[from].references.push_back(to);
+}
+
+std::vector<bool> CallGraph::Reachable() const {
+  std::vector<bool> reached(symbols_.size(), false);
+  std::vector<SymbolId> worklist;
+
+  auto reach = [&](SymbolId symbol) {
+    if (!reached[symbol]) {
+      reached[symbol] = true;
+      worklist.push_back(symbol);
+    }
+  };
+
+  for (auto root : roots_) {
+    reach(root);
+  }
+
+  while (!worklist.empty()) {
+    auto symbol = worklist.back();
+    worklist.pop_back();
+
+    for (auto target : symbols_[symbol].references) {
+      reach(target);
+    }
+  }
+
+  return reached;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Literals and the operators on them, nothing that reads or calls
+static bool IsConstant(const FlatTree& tree, FlatIndex init) {
+  std::vector<FlatIndex> stack{init};
+
+  while (!stack.empty()) {
+    auto node = stack.back();
+    stack.pop_back();
+
+    switch (tree.Kind(node)) {
+      case FlatKind::INT_LITERAL:
+      case FlatKind::BOOL_LITERAL:
+      case FlatKind::STRING_LITERAL:
+      case FlatKind::UNIT_LITERAL:
+      case FlatKind::UNARY:
+      case FlatKind::BINARY:
+      case FlatKind::COMPARISON:
+        break;
+      default:
+        return false;
+    }
+
+    tree.ForEachChild(node, [&](FlatIndex child) {
+      stack.push_back(child);
+    });
+  }
+
+  return true;
+}
+
+CallGraph BuildCallGraph(const FlatTree& tree,
+                         std::span<const FlatIndex> declarations,
+                         std::span<const std::string_view> exported) {
+  CallGraph graph;
+
+  // Declaration i is symbol i
+  std::unordered_map<std::string_view, CallGraph::SymbolId> symbols;
+
+  for (auto decl : declarations) {
+    auto kind = tree.Kind(decl);
+    FMT_ASSERT(kind == FlatKind::FUN_DECL || kind == FlatKind::VAR_DECL,
+               "Not a top-level declaration");
+
+    auto name = tree.Name(decl);
+    if (auto it = symbols.find(name); it != symbols.end()) {
+      throw errors::DuplicateSymbolError{
+          std::string{name}, tree.GetLocation(declarations[it->second]),
+          tree.GetLocation(decl)};
+    }
+
+    auto symbol = graph.AddSymbol(name, kind == FlatKind::FUN_DECL
+                                            ? CallGraph::Kind::FUNCTION
+                                            : CallGraph::Kind::GLOBAL);
+    symbols.emplace(name, symbol);
+
+    if (kind == FlatKind::VAR_DECL && !IsConstant(tree, tree.At(decl).rhs)) {
+      graph.AddRoot(symbol);
+    }
+  }
+
+  auto root = [&](std::string_view name) {
+    if (auto it = symbols.find(name); it != symbols.end()) {
+      graph.AddRoot(it->second);
+    }
+  };
+
+  root("main");
+  for (auto name : exported) {
+    root(name);
+  }
+
+  // Callees of FN_CALL are VAR_ACCESS nodes as well, so this covers
+  // calls, uses of globals and functions passed around as values
+  std::vector<FlatIndex> stack;
+
+  for (CallGraph::SymbolId from = 0; from < declarations.size(); from++) {
+    stack.assign({declarations[from]});
+
+    while (!stack.empty()) {
+      auto node = stack.back();
+      stack.pop_back();
+
+      if (tree.Kind(node) == FlatKind::VAR_ACCESS) {
+        if (auto it = symbols.find(tree.Name(node)); it != symbols.end()) {
+          graph.AddReference(from, it->second);
+        }
+      }
+
+      tree.ForEachChild(node, [&](FlatIndex child) {
+        stack.push_back(child);
+      });
+    }
+  }
+
+  return graph;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::vector<FlatIndex> RemoveDeadDeclarations(
+    const FlatTree& tree, std::span<const FlatIndex> declarations,
+    std::span<const std::string_view> exported, DeadCodeReport* report) {
+  auto graph = BuildCallGraph(tree, declarations, exported);
+  auto reachable = graph.Reachable();
+
+  if (report) {
+    *report = {};
+  }
+
+  std::vector<FlatIndex> live;
+
+  for (CallGraph::SymbolId i = 0; i < declarations.size(); i++) {
+    if (reachable[i]) {
+      live.push_back(declarations[i]);
+      continue;
+    }
+
+    bool function = graph.KindOf(i) == CallGraph::Kind::FUNCTION;
+
+    stats::Count(function ? stats::Counter::DEAD_FUNCTIONS
+                          : stats::Counter::DEAD_GLOBALS);
+
+    // An empty event per symbol: the names show up in --trace
+    stats::TraceScope removed{"dead code", graph.Name(i)};
+
+    if (report) {
+      auto& names = function ? report->functions : report->globals;
+      names.emplace_back(graph.Name(i));
+    }
+  }
+
+  return live;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace opt
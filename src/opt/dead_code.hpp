@@ -0,0 +1,96 @@
+#pragma once
+
+#include <ast/flat_tree.hpp>
+
+#include <string_view>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <span>
+
+namespace opt {
+
+//////////////////////////////////////////////////////////////////////
+
+// Which top-level functions and globals of a module can be used at
+// all: everything reachable from `main` and the exported symbols
+// through calls and references. The rest is never lowered, so qbe and
+// the assembler do not spend time on it.
+
+class CallGraph {
+ public:
+  using SymbolId = uint32_t;
+
+  enum class Kind {
+    FUNCTION,
+    GLOBAL,
+  };
+
+  SymbolId AddSymbol(std::string_view name, Kind kind);
+
+  std::optional<SymbolId> Find(std::string_view name) const;
+
+  // Kept whatever else happens: `main`, exported, address taken by
+  // another module
+  void AddRoot(SymbolId symbol);
+
+  // `from` calls `to`, reads or writes it, or takes its address
+  void AddReference(SymbolId from, SymbolId to);
+
+  // Indexed by SymbolId; a worklist from the roots
+  std::vector<bool> Reachable() const;
+
+  size_t Size() const {
+    return symbols_.size();
+  }
+
+  std::string_view Name(SymbolId symbol) const {
+    return symbols_[symbol].name;
+  }
+
+  Kind KindOf(SymbolId symbol) const {
+    return symbols_[symbol].kind;
+  }
+
+ private:
+  struct Symbol {
+    std::string name;
+    Kind kind;
+    std::vector<SymbolId> references;
+  };
+
+  std::vector<Symbol> symbols_;
+  std::vector<SymbolId> roots_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// The graph of the top-level FUN_DECL and VAR_DECL `declarations` of
+// `tree`, rooted at `main`, the `exported` names and the globals whose
+// initializer is not a constant: `var x = f();` runs `f` at startup
+// whether `x` is used or not. A reference is any name in a
+// declaration that is also a top-level one. A local that shadows a
+// global keeps the global alive too, which can only keep too much.
+// Throws errors::DuplicateSymbolError if two declarations share a
+// name.
+CallGraph BuildCallGraph(const FlatTree& tree,
+                         std::span<const FlatIndex> declarations,
+                         std::span<const std::string_view> exported);
+
+struct DeadCodeReport {
+  std::vector<std::string> functions;
+  std::vector<std::string> globals;
+};
+
+// The `declarations` worth lowering, in their original order. What is
+// dropped goes to `report`, the stats counters and the trace.
+std::vector<FlatIndex> RemoveDeadDeclarations(
+    const FlatTree& tree, std::span<const FlatIndex> declarations,
+    std::span<const std::string_view> exported,
+    DeadCodeReport* report = nullptr);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace opt
@@ -0,0 +1,181 @@
+#include <opt/escape_analysis.hpp>
+
+#include <utility>
+
+namespace opt {
+
+//////////////////////////////////////////////////////////////////////
+
+EscapeAnalysis::ValueId EscapeAnalysis::MakeNode(bool escapes) {
+  auto id = static_cast<ValueId>(nodes_.size());
+  nodes_.push_back(Node{.parent = id, .contents = kNone, .escapes = escapes});
+  solved_ = false;
+  return id;
+}
+
+EscapeAnalysis::ValueId EscapeAnalysis::NewAllocation(size_t size,
+                                                      bool in_loop) {
+  auto value = MakeNode(false);
+  nodes_[value].in_loop = in_loop;
+  nodes_[value].oversized = size > kMaxStackAllocation;
+  allocations_.push_back(value);
+  return value;
+}
+
+EscapeAnalysis::ValueId EscapeAnalysis::NewValue() {
+  return MakeNode(false);
+}
+
+EscapeAnalysis::ValueId EscapeAnalysis::NewUnknown() {
+  return MakeNode(true);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+EscapeAnalysis::ValueId EscapeAnalysis::Find(ValueId node) {
+  auto root = node;
+  while (nodes_[root].parent != root) {
+    root = nodes_[root].parent;
+  }
+
+  while (nodes_[node].parent != root) {
+    node = std::exchange(nodes_[node].parent, root);
+  }
+
+  return root;
+}
+
+EscapeAnalysis::ValueId EscapeAnalysis::Contents(ValueId node) {
+  node = Find(node);
+  if (nodes_[node].contents == kNone) {
+    auto contents = MakeNode(false);
+    nodes_[node].contents = contents;
+  }
+  return nodes_[node].contents;
+}
+
+void EscapeAnalysis::Unify(ValueId a, ValueId b) {
+  solved_ = false;
+
+  // Merging two pointers merges what they point to, and so on down:
+  // iterative, the chains can be as long as a linked list literal
+  std::vector<std::pair<ValueId, ValueId>> work{{a, b}};
+
+  while (!work.empty()) {
+    auto [x, y] = work.back();
+    work.pop_back();
+
+    x = Find(x);
+    y = Find(y);
+    if (x == y) {
+      continue;
+    }
+
+    if (nodes_[x].rank < nodes_[y].rank) {
+      std::swap(x, y);
+    }
+    if (nodes_[x].rank == nodes_[y].rank) {
+      nodes_[x].rank += 1;
+    }
+
+    nodes_[y].parent = x;
+    nodes_[x].escapes |= nodes_[y].escapes;
+
+    auto& contents = nodes_[x].contents;
+    if (contents == kNone) {
+      contents = nodes_[y].contents;
+    } else if (nodes_[y].contents != kNone) {
+      work.emplace_back(contents, nodes_[y].contents);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void EscapeAnalysis::Copy(ValueId dst, ValueId src) {
+  Unify(dst, src);
+}
+
+void EscapeAnalysis::Store(ValueId address, ValueId value) {
+  Unify(Contents(address), value);
+}
+
+void EscapeAnalysis::Load(ValueId dst, ValueId address) {
+  Unify(dst, Contents(address));
+}
+
+void EscapeAnalysis::Escape(ValueId value) {
+  nodes_[Find(value)].escapes = true;
+  solved_ = false;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void EscapeAnalysis::Propagate() {
+  for (ValueId node = 0; node < nodes_.size(); node++) {
+    auto root = Find(node);
+    if (!nodes_[root].escapes) {
+      continue;
+    }
+
+    // Follow the contents chain until it reaches escaping memory
+    for (auto next = nodes_[root].contents; next != kNone;) {
+      next = Find(next);
+      if (nodes_[next].escapes) {
+        break;
+      }
+      nodes_[next].escapes = true;
+      next = nodes_[next].contents;
+    }
+  }
+
+  solved_ = true;
+}
+
+bool EscapeAnalysis::Escapes(ValueId value) {
+  if (!solved_) {
+    Propagate();
+  }
+  return nodes_[Find(value)].escapes;
+}
+
+bool EscapeAnalysis::OnStack(ValueId allocation) {
+  auto& site = nodes_[allocation];
+  return !site.in_loop && !site.oversized && !Escapes(allocation);
+}
+
+size_t EscapeAnalysis::StackAllocations() {
+  size_t count = 0;
+  for (auto site : allocations_) {
+    count += OnStack(site);
+  }
+  return count;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::optional<Allocator> ParseAllocator(std::string_view name) {
+  if (name == "malloc") {
+    return Allocator::MALLOC;
+  }
+  if (name == "bump") {
+    return Allocator::BUMP;
+  }
+  return std::nullopt;
+}
+
+void EmitNew(qbe::IrEmitter& out, qbe::QbeValue dst, size_t size,
+             size_t align, bool on_stack, Allocator allocator) {
+  if (on_stack && size <= kMaxStackAllocation) {
+    auto slot = align <= 4 ? 4 : (align <= 8 ? 8 : 16);
+    out.EmitInstr("{} =l alloc{} {}", dst, slot, size);
+    return;
+  }
+
+  auto function = allocator == Allocator::BUMP ? "etude_alloc" : "malloc";
+  out.EmitInstr("{} =l call ${}(l {})", dst, function, size);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace opt
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <qbe/ir_emitter.hpp>
+#include <qbe/qbe_value.hpp>
+
+#include <string_view>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace opt {
+
+//////////////////////////////////////////////////////////////////////
+
+// Larger objects stay on the heap even if they do not escape
+inline constexpr size_t kMaxStackAllocation = 4096;
+
+//////////////////////////////////////////////////////////////////////
+
+// Decides which `new` allocations of a function can live in its
+// stack frame instead of going through malloc.
+//
+// Codegen describes how pointers move inside one function; the
+// analysis unifies everything that may point to the same memory
+// (Steensgaard style, near-linear) and reports an allocation as
+// escaping when its object may be reachable from:
+//
+//   - the return value,
+//   - memory the function did not allocate itself (parameters,
+//     globals, results of calls),
+//   - arguments of callees not known to keep their pointers local.
+//
+// Objects larger than kMaxStackAllocation stay on the heap whether
+// they escape or not.
+//
+//   auto tmp = escape.NewAllocation(16);   // var t = new Pair;
+//   auto ptr = escape.NewValue();
+//   escape.Copy(ptr, tmp);                 // var p = t;
+//   escape.Store(ptr, escape.NewUnknown()); // p->left = g();
+//   escape.OnStack(tmp)  // true: `t` can go in a stack slot
+
+class EscapeAnalysis {
+ public:
+  using ValueId = uint32_t;
+
+  // Size of `new [n] T` when `n` is not a constant
+  static constexpr size_t kUnknownSize = SIZE_MAX;
+
+  // Pointer to a fresh object of `size` bytes: `new T`, `new [n] T`.
+  // Objects allocated in a loop may be alive several at a time and
+  // are never moved to the (single) stack slot, mark them here.
+  ValueId NewAllocation(size_t size, bool in_loop = false);
+
+  // Pointer-valued local or temporary
+  ValueId NewValue();
+
+  // Pointer to memory that is not ours: parameter, global, call result
+  ValueId NewUnknown();
+
+  // dst = src, also dst = &src->field, dst = src + index
+  void Copy(ValueId dst, ValueId src);
+
+  // *address = value
+  void Store(ValueId address, ValueId value);
+
+  // dst = *address
+  void Load(ValueId dst, ValueId address);
+
+  // return value; store to a global; argument of an unknown callee
+  void Escape(ValueId value);
+
+  // Whether the object of `value` may outlive the function
+  bool Escapes(ValueId value);
+
+  // Whether the `allocation` (from NewAllocation) can be lowered to
+  // a stack slot
+  bool OnStack(ValueId allocation);
+
+  // Number of allocations lowered to stack slots
+  size_t StackAllocations();
+
+ private:
+  struct Node {
+    ValueId parent;
+    uint32_t rank = 0;
+
+    // What the memory this node points to holds, kNone if unknown yet
+    ValueId contents;
+
+    bool escapes = false;
+
+    // Allocation site inside a loop
+    bool in_loop = false;
+
+    // Allocation site of more than kMaxStackAllocation bytes
+    bool oversized = false;
+  };
+
+  static constexpr ValueId kNone = UINT32_MAX;
+
+  ValueId MakeNode(bool escapes);
+  ValueId Find(ValueId node);
+  ValueId Contents(ValueId node);
+  void Unify(ValueId a, ValueId b);
+
+  // Contents of escaping memory escape too
+  void Propagate();
+
+ private:
+  std::vector<Node> nodes_;
+  std::vector<ValueId> allocations_;
+
+  bool solved_ = false;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Where heap objects come from (`etudec --alloc=...`)
+enum class Allocator {
+  MALLOC,
+
+  // Thread-local bump allocator of the runtime library (etude_rt.h),
+  // for programs that never free objects one by one
+  BUMP,
+};
+
+std::optional<Allocator> ParseAllocator(std::string_view name);
+
+// Lowering of `new`: a stack slot if `on_stack` and the object is
+// small enough, a call to the allocator otherwise.
+// QBE only coalesces `alloc` slots of the start block, so on-stack
+// objects must be emitted there.
+void EmitNew(qbe::IrEmitter& out, qbe::QbeValue dst, size_t size,
+             size_t align, bool on_stack,
+             Allocator allocator = Allocator::MALLOC);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace opt
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <lex/location.hpp>
+
+#include <fmt/core.h>
+
+#include <string>
+
+namespace opt::errors {
+
+struct OptError : std::exception {
+  std::string message;
+
+  const char* what() const noexcept override {
+    return message.c_str();
+  }
+};
+
+struct DuplicateSymbolError : OptError {
+  DuplicateSymbolError(const std::string& name, lex::Location first,
+                       lex::Location second) {
+    message = fmt::format("{} is declared twice: at {} and at {}\n", name,
+                          first.Format(), second.Format());
+  }
+};
+
+}  // namespace opt::errors
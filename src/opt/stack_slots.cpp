@@ -0,0 +1,742 @@
+#include <opt/stack_slots.hpp>
+
+#include <fmt/format.h>
+
+#include <unordered_map>
+#include <algorithm>
+#include <charconv>
+#include <cctype>
+#include <optional>
+#include <vector>
+
+namespace opt {
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Temporaries mentioned by a line: `%.1`, `%x.y`
+std::vector<std::string_view> TempsOf(std::string_view line) {
+  std::vector<std::string_view> temps;
+
+  for (size_t i = 0; i < line.size(); i++) {
+    if (line[i] != '%') {
+      continue;
+    }
+
+    auto end = i + 1;
+    while (end < line.size() &&
+           (std::isalnum(static_cast<unsigned char>(line[end])) ||
+            line[end] == '_' || line[end] == '.')) {
+      end += 1;
+    }
+
+    temps.push_back(line.substr(i, end - i));
+    i = end - 1;
+  }
+
+  return temps;
+}
+
+// `\t%x =w loadw %s` -> {"%x", "w", "loadw", {"%s"}}
+struct Instr {
+  std::string_view result;
+  std::string_view result_class;
+  std::string_view op;
+  std::vector<std::string_view> args;
+};
+
+std::string_view Trim(std::string_view text) {
+  auto begin = text.find_first_not_of(" \t");
+  if (begin == text.npos) {
+    return {};
+  }
+  auto end = text.find_last_not_of(" \t");
+  return text.substr(begin, end - begin + 1);
+}
+
+Instr ParseInstr(std::string_view line) {
+  Instr instr;
+  line = Trim(line);
+
+  if (auto eq = line.find(" ="); eq != line.npos && line[0] == '%') {
+    instr.result = line.substr(0, eq);
+    line = line.substr(eq + 2);
+    auto space = line.find(' ');
+    instr.result_class = line.substr(0, space);
+    line = space == line.npos ? "" : Trim(line.substr(space));
+  }
+
+  auto space = line.find(' ');
+  instr.op = line.substr(0, space);
+  line = space == line.npos ? "" : line.substr(space);
+
+  while (!line.empty()) {
+    auto comma = line.find(',');
+    auto arg = Trim(line.substr(0, comma));
+    if (!arg.empty()) {
+      instr.args.push_back(arg);
+    }
+    line = comma == line.npos ? "" : line.substr(comma + 1);
+  }
+
+  return instr;
+}
+
+std::optional<size_t> ParseNumber(std::string_view text) {
+  size_t value = 0;
+  auto [end, error] = std::from_chars(text.begin(), text.end(), value);
+  if (error != std::errc{} || end != text.end()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+// Bytes moved by a load/store op, 0 for other ops
+size_t AccessWidth(std::string_view op) {
+  auto width = op.back();
+  if (op.starts_with("store")) {
+    width = op[5];
+  } else if (!op.starts_with("load")) {
+    return 0;
+  }
+
+  switch (width) {
+    case 'b':
+      return 1;
+    case 'h':
+      return 2;
+    case 'w':
+    case 's':
+      return 4;
+    case 'l':
+    case 'd':
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+struct Slot {
+  std::string_view name;
+  size_t line = 0;  // of the alloc
+  size_t align = 4;
+  size_t size = 0;
+
+  // Address escapes, or accessed in a way that is not understood
+  bool pinned = false;
+
+  // Only full-width loads/stores of one class, directly
+  bool promotable = true;
+  char value_class = 0;  // w l s d
+
+  size_t home = SIZE_MAX;  // slot it shares memory with
+};
+
+struct Block {
+  size_t begin = 0;  // first instruction line
+  size_t end = 0;
+  std::vector<size_t> successors;
+
+  std::vector<bool> live_in;
+  std::vector<bool> live_out;
+  std::vector<bool> touched_in;
+};
+
+class SlotPass {
+ public:
+  explicit SlotPass(std::string_view function);
+
+  std::string Run(SlotReport* report);
+
+ private:
+  void Split();
+  void FindSlots();
+  void Classify();
+  void Promote();
+  void ComputeLiveness();
+  void Color();
+  std::string Rewrite();
+
+  // Slot accessed by `line` through temp `name` (slot or alias)
+  std::optional<size_t> SlotOf(std::string_view name) const;
+
+  // How `line` touches slots: used ones, and the one fully overwritten
+  void Effects(size_t line, std::vector<size_t>& used,
+               std::optional<size_t>& killed) const;
+
+  // The slot `line` stores or blits into, in part or in full
+  std::optional<size_t> WrittenSlot(size_t line) const;
+
+ private:
+  std::vector<std::string_view> lines_;
+  std::vector<Block> blocks_;
+
+  std::vector<Slot> slots_;
+  std::unordered_map<std::string_view, size_t> by_name_;
+
+  // Temps holding a slot address plus an offset (`add %s, 8`)
+  std::unordered_map<std::string_view, size_t> aliases_;
+
+  std::vector<std::vector<bool>> interferes_;
+
+  // Replacement text of promoted lines; empty string deletes the line
+  std::unordered_map<size_t, std::string> rewritten_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+SlotPass::SlotPass(std::string_view function) {
+  while (!function.empty()) {
+    auto newline = function.find('\n');
+    lines_.push_back(function.substr(0, newline));
+    function = newline == function.npos ? "" : function.substr(newline + 1);
+  }
+}
+
+void SlotPass::Split() {
+  std::unordered_map<std::string_view, size_t> labels;
+
+  for (size_t i = 0; i < lines_.size(); i++) {
+    auto line = lines_[i];
+    if (line.starts_with('@')) {
+      if (!blocks_.empty()) {
+        blocks_.back().end = i;
+      }
+      labels[line] = blocks_.size();
+      blocks_.emplace_back().begin = i + 1;
+    } else if (line.starts_with('}') && !blocks_.empty()) {
+      blocks_.back().end = i;
+    }
+  }
+
+  for (size_t b = 0; b < blocks_.size(); b++) {
+    auto& block = blocks_[b];
+
+    std::optional<Instr> last;
+    if (block.end > block.begin) {
+      last = ParseInstr(lines_[block.end - 1]);
+    }
+
+    if (last && (last->op == "jmp" || last->op == "jnz")) {
+      for (auto& arg : last->args) {
+        if (auto it = labels.find(arg); it != labels.end()) {
+          block.successors.push_back(it->second);
+        }
+      }
+    } else if (!last || (last->op != "ret" && last->op != "hlt")) {
+      if (b + 1 < blocks_.size()) {
+        block.successors.push_back(b + 1);  // falls through
+      }
+    }
+  }
+}
+
+void SlotPass::FindSlots() {
+  for (size_t i = 0; i < lines_.size(); i++) {
+    auto instr = ParseInstr(lines_[i]);
+    if (!instr.op.starts_with("alloc") || instr.args.size() != 1) {
+      continue;
+    }
+
+    auto size = ParseNumber(instr.args[0]);
+    auto align = ParseNumber(instr.op.substr(5));
+    if (!size || !align) {
+      continue;  // dynamic size: leave it alone
+    }
+
+    by_name_[instr.result] = slots_.size();
+    slots_.push_back(Slot{
+        .name = instr.result,
+        .line = i,
+        .align = *align,
+        .size = *size,
+    });
+  }
+}
+
+std::optional<size_t> SlotPass::SlotOf(std::string_view name) const {
+  if (auto it = by_name_.find(name); it != by_name_.end()) {
+    return it->second;
+  }
+  if (auto it = aliases_.find(name); it != aliases_.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void SlotPass::Classify() {
+  for (size_t i = 0; i < lines_.size(); i++) {
+    auto instr = ParseInstr(lines_[i]);
+    if (instr.op.starts_with("alloc")) {
+      continue;
+    }
+
+    auto width = AccessWidth(instr.op);
+
+    if (width > 0 && instr.op.starts_with("load") &&
+        instr.args.size() == 1) {
+      if (auto slot = SlotOf(instr.args[0])) {
+        auto& s = slots_[*slot];
+        bool full = by_name_.contains(instr.args[0]) && width == s.size;
+        // loadsw/loaduw into `l` extend; only same-class loads promote
+        char cls = instr.result_class.empty() ? 0 : instr.result_class[0];
+        bool same = (width == 4 && (cls == 'w' || cls == 's')) ||
+                    (width == 8 && (cls == 'l' || cls == 'd'));
+        if (!full || !same || (s.value_class && s.value_class != cls)) {
+          s.promotable = false;
+        } else {
+          s.value_class = cls;
+        }
+        continue;
+      }
+    }
+
+    if (width > 0 && instr.op.starts_with("store") &&
+        instr.args.size() == 2) {
+      // The stored value must not be a slot address
+      if (auto value = SlotOf(instr.args[0])) {
+        slots_[*value].pinned = true;
+        slots_[*value].promotable = false;
+      }
+
+      if (auto slot = SlotOf(instr.args[1])) {
+        auto& s = slots_[*slot];
+        char cls = instr.op[5] == 's' || instr.op[5] == 'd'
+                       ? instr.op[5]
+                       : (width == 8 ? 'l' : 'w');
+        bool full = by_name_.contains(instr.args[1]) && width == s.size &&
+                    width >= 4;
+        if (!full || (s.value_class && s.value_class != cls)) {
+          s.promotable = false;
+        } else {
+          s.value_class = cls;
+        }
+      }
+      continue;
+    }
+
+    // %a =l add %s, 8 / %a =l copy %s: an alias, not an escape
+    if ((instr.op == "add" || instr.op == "copy") &&
+        instr.result_class == "l" && !instr.args.empty()) {
+      std::optional<size_t> slot;
+      for (auto& arg : instr.args) {
+        if (auto s = SlotOf(arg)) {
+          slot = s;
+        }
+      }
+
+      bool others_constant =
+          std::all_of(instr.args.begin(), instr.args.end(), [&](auto arg) {
+            return SlotOf(arg) || ParseNumber(arg);
+          });
+
+      if (slot && others_constant) {
+        aliases_[instr.result] = *slot;
+        slots_[*slot].promotable = false;
+        continue;
+      }
+    }
+
+    if (instr.op == "blit") {
+      for (auto& arg : instr.args) {
+        if (auto slot = SlotOf(arg)) {
+          slots_[*slot].promotable = false;
+        }
+      }
+      continue;
+    }
+
+    // Anything else that mentions a slot address lets it escape
+    for (auto temp : TempsOf(lines_[i])) {
+      if (temp == instr.result) {
+        continue;
+      }
+      if (auto slot = SlotOf(temp)) {
+        slots_[*slot].pinned = true;
+        slots_[*slot].promotable = false;
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void SlotPass::Promote() {
+  for (auto& slot : slots_) {
+    if (!slot.promotable || slot.pinned) {
+      continue;
+    }
+
+    auto value = fmt::format("{}.v", slot.name);
+
+    // QBE wants a definition on every path: start from zero
+    auto zero = slot.value_class == 's'   ? "s_0"
+                : slot.value_class == 'd' ? "d_0"
+                                          : "0";
+    rewritten_[slot.line] = fmt::format("\t{} ={} copy {}", value,
+                                        slot.value_class ? slot.value_class
+                                                         : 'l',
+                                        zero);
+  }
+
+  for (size_t i = 0; i < lines_.size(); i++) {
+    if (rewritten_.contains(i)) {
+      continue;
+    }
+
+    auto instr = ParseInstr(lines_[i]);
+    auto width = AccessWidth(instr.op);
+    if (width == 0) {
+      continue;
+    }
+
+    auto address = instr.op.starts_with("load") ? instr.args[0]
+                                                : instr.args.back();
+    auto it = by_name_.find(address);
+    if (it == by_name_.end()) {
+      continue;
+    }
+
+    auto& slot = slots_[it->second];
+    if (!slot.promotable || slot.pinned) {
+      continue;
+    }
+
+    if (instr.op.starts_with("load")) {
+      rewritten_[i] = fmt::format("\t{} ={} copy {}.v", instr.result,
+                                  instr.result_class, slot.name);
+    } else {
+      rewritten_[i] = fmt::format("\t{}.v ={} copy {}", slot.name,
+                                  slot.value_class, instr.args[0]);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::string_view WrittenOperand(const Instr& instr) {
+  if ((instr.op.starts_with("store") || instr.op == "blit") &&
+      !instr.args.empty()) {
+    return instr.args.back();
+  }
+  return {};
+}
+
+std::optional<size_t> SlotPass::WrittenSlot(size_t line) const {
+  auto written = WrittenOperand(ParseInstr(lines_[line]));
+  return written.empty() ? std::nullopt : SlotOf(written);
+}
+
+void SlotPass::Effects(size_t line, std::vector<size_t>& used,
+                       std::optional<size_t>& killed) const {
+  auto instr = ParseInstr(lines_[line]);
+
+  if (instr.op.starts_with("store") && instr.args.size() == 2) {
+    auto it = by_name_.find(instr.args[1]);
+    if (it != by_name_.end() &&
+        AccessWidth(instr.op) >= slots_[it->second].size) {
+      killed = it->second;
+    }
+  }
+
+  // Taking an offset reads nothing; the alias is used later instead
+  if (aliases_.contains(instr.result)) {
+    return;
+  }
+
+  // Writing part of a slot does not need what was there before
+  auto written = WrittenOperand(instr);
+
+  for (auto temp : TempsOf(lines_[line])) {
+    if (temp == instr.result || temp == written) {
+      continue;
+    }
+    if (auto slot = SlotOf(temp)) {
+      used.push_back(*slot);
+    }
+  }
+}
+
+void SlotPass::ComputeLiveness() {
+  auto n = slots_.size();
+  interferes_.assign(n, std::vector<bool>(n));
+
+  for (auto& block : blocks_) {
+    block.live_in.assign(n, false);
+    block.live_out.assign(n, false);
+    block.touched_in.assign(n, false);
+  }
+
+  // Backward: the contents may still be read. A full-width store
+  // overwrites a scalar, aggregates are assumed read until their last
+  // mention.
+  auto backward = [&](const Block& block, std::vector<bool> live) {
+    for (auto line = block.end; line-- > block.begin;) {
+      std::vector<size_t> used;
+      std::optional<size_t> killed;
+      Effects(line, used, killed);
+
+      if (killed) {
+        live[*killed] = false;
+      }
+      for (auto slot : used) {
+        live[slot] = true;
+      }
+    }
+    return live;
+  };
+
+  // Forward: the slot has been written to on some path. Without it
+  // every aggregate would be live from the function entry.
+  auto touch = [&](size_t line, std::vector<bool>& touched) {
+    if (ParseInstr(lines_[line]).op.starts_with("alloc")) {
+      return;
+    }
+    for (auto temp : TempsOf(lines_[line])) {
+      if (auto slot = SlotOf(temp)) {
+        touched[*slot] = true;
+      }
+    }
+  };
+
+  auto forward = [&](const Block& block, std::vector<bool> touched) {
+    for (auto line = block.begin; line < block.end; line++) {
+      touch(line, touched);
+    }
+    return touched;
+  };
+
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (size_t b = blocks_.size(); b-- > 0;) {
+      auto& block = blocks_[b];
+
+      std::vector<bool> out(n);
+      for (auto s : block.successors) {
+        for (size_t i = 0; i < n; i++) {
+          out[i] = out[i] || blocks_[s].live_in[i];
+        }
+      }
+
+      auto in = backward(block, out);
+      if (in != block.live_in || out != block.live_out) {
+        block.live_in = std::move(in);
+        block.live_out = std::move(out);
+        changed = true;
+      }
+    }
+  }
+
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (auto& block : blocks_) {
+      auto out = forward(block, block.touched_in);
+      for (auto s : block.successors) {
+        auto& in = blocks_[s].touched_in;
+        for (size_t i = 0; i < n; i++) {
+          if (out[i] && !in[i]) {
+            in[i] = true;
+            changed = true;
+          }
+        }
+      }
+    }
+  }
+
+  // Slots both written and still needed at the same point interfere
+  auto interfere = [&](const std::vector<bool>& live,
+                       const std::vector<bool>& touched) {
+    for (size_t a = 0; a < n; a++) {
+      if (!live[a] || !touched[a]) {
+        continue;
+      }
+      for (size_t b = a + 1; b < n; b++) {
+        if (live[b] && touched[b]) {
+          interferes_[a][b] = interferes_[b][a] = true;
+        }
+      }
+    }
+  };
+
+  for (auto& block : blocks_) {
+    // Touched before each line, forwards; live after it, backwards
+    std::vector<std::vector<bool>> touched{block.touched_in};
+    for (auto line = block.begin; line < block.end; line++) {
+      auto next = touched.back();
+      touch(line, next);
+      touched.push_back(std::move(next));
+    }
+
+    auto live = block.live_out;
+    for (auto line = block.end; line-- > block.begin;) {
+      auto& after = touched[line - block.begin + 1];
+      interfere(live, after);
+
+      // A write lands in memory even if nobody reads it: it must not
+      // go where a slot that is still needed lives
+      if (auto written = WrittenSlot(line)) {
+        for (size_t other = 0; other < n; other++) {
+          if (other != *written && live[other] && after[other]) {
+            interferes_[*written][other] = interferes_[other][*written] =
+                true;
+          }
+        }
+      }
+
+      std::vector<size_t> used;
+      std::optional<size_t> killed;
+      Effects(line, used, killed);
+
+      if (killed) {
+        live[*killed] = false;
+      }
+      for (auto slot : used) {
+        live[slot] = true;
+      }
+    }
+    interfere(live, touched[0]);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void SlotPass::Color() {
+  std::vector<size_t> order;
+  for (size_t i = 0; i < slots_.size(); i++) {
+    if (!slots_[i].promotable || slots_[i].pinned) {
+      order.push_back(i);
+    }
+  }
+
+  // Biggest first: they become the homes the smaller ones move into
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return slots_[a].size > slots_[b].size;
+  });
+
+  std::vector<std::vector<size_t>> homes;  // members, home first
+
+  for (auto slot : order) {
+    auto& s = slots_[slot];
+
+    if (!s.pinned) {
+      for (auto& members : homes) {
+        auto& home = slots_[members[0]];
+        if (home.pinned || home.size < s.size || home.align < s.align) {
+          continue;
+        }
+
+        bool free = std::none_of(members.begin(), members.end(), [&](auto m) {
+          return interferes_[slot][m];
+        });
+
+        if (free) {
+          members.push_back(slot);
+          s.home = members[0];
+          break;
+        }
+      }
+    }
+
+    if (s.home == SIZE_MAX) {
+      s.home = slot;
+      homes.push_back({slot});
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::string SlotPass::Rewrite() {
+  std::unordered_map<std::string_view, std::string_view> renamed;
+  for (auto& slot : slots_) {
+    if (slot.home != SIZE_MAX && slot.home != by_name_[slot.name]) {
+      renamed[slot.name] = slots_[slot.home].name;
+      rewritten_[slot.line] = "";
+    }
+  }
+
+  std::string result;
+  for (size_t i = 0; i < lines_.size(); i++) {
+    std::string line{lines_[i]};
+
+    if (auto it = rewritten_.find(i); it != rewritten_.end()) {
+      if (it->second.empty()) {
+        continue;
+      }
+      line = it->second;
+    }
+
+    if (!renamed.empty()) {
+      std::string renamed_line;
+      std::string_view rest = line;
+
+      for (auto temp : TempsOf(line)) {
+        auto offset = temp.data() - rest.data();
+        renamed_line.append(rest.substr(0, offset));
+
+        auto it = renamed.find(temp);
+        renamed_line.append(it == renamed.end() ? temp : it->second);
+        rest = rest.substr(offset + temp.size());
+      }
+
+      renamed_line.append(rest);
+      line = std::move(renamed_line);
+    }
+
+    result += line;
+    if (i + 1 < lines_.size()) {
+      result += '\n';
+    }
+  }
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::string SlotPass::Run(SlotReport* report) {
+  Split();
+  FindSlots();
+  Classify();
+  Promote();
+  ComputeLiveness();
+  Color();
+  auto result = Rewrite();
+
+  if (report) {
+    *report = {};
+    report->slots = slots_.size();
+    for (size_t i = 0; i < slots_.size(); i++) {
+      auto& slot = slots_[i];
+      report->frame_before += slot.size;
+
+      if (slot.promotable && !slot.pinned) {
+        report->promoted += 1;
+      } else if (slot.home != i) {
+        report->merged += 1;
+      } else {
+        report->frame_after += slot.size;
+      }
+    }
+  }
+
+  return result;
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+std::string OptimizeStackSlots(std::string_view function,
+                               SlotReport* report) {
+  return SlotPass{function}.Run(report);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace opt
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string_view>
+#include <cstddef>
+#include <string>
+
+namespace opt {
+
+//////////////////////////////////////////////////////////////////////
+
+// Shrinks the stack frame of one lowered QBE function.
+//
+// A straightforward IR generator gives every local and temporary its
+// own `alloc` slot for the whole function. This pass:
+//
+//  1. promotes scalar slots that are only loaded and stored at their
+//     full width (the address is never taken) to temporaries, which
+//     QBE then keeps in registers;
+//
+//  2. computes where each remaining slot is live and lets slots with
+//     disjoint live ranges share memory.
+//
+// A slot whose address escapes (passed to a call, stored, returned)
+// is assumed live for the whole function and never shares.
+
+struct SlotReport {
+  size_t slots = 0;
+  size_t promoted = 0;
+  size_t merged = 0;
+
+  size_t frame_before = 0;  // bytes of `alloc`
+  size_t frame_after = 0;
+};
+
+// `function` is the text of one function, header to closing brace,
+// as IrEmitter writes it (one instruction per line)
+std::string OptimizeStackSlots(std::string_view function,
+                               SlotReport* report = nullptr);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace opt
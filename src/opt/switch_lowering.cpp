@@ -0,0 +1,135 @@
+#include <opt/switch_lowering.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <set>
+
+namespace opt {
+
+//////////////////////////////////////////////////////////////////////
+
+// Entries from the smallest case to the largest, if few enough of
+// them are holes. The distance is taken unsigned, where even
+// INT64_MIN..INT64_MAX fits; only then is the entry for Max added.
+static std::optional<size_t> DenseTableSize(const SwitchPlan& plan) {
+  auto distance = static_cast<uint64_t>(plan.Max()) -
+                  static_cast<uint64_t>(plan.Min());
+  if (distance >= plan.cases.size() * 100 / kMinTableDensityPercent) {
+    return std::nullopt;
+  }
+  return distance + 1;
+}
+
+std::optional<SwitchPlan> RecognizeChain(std::span<const ChainLink> chain) {
+  if (chain.empty() || !chain[0].is_equality) {
+    return std::nullopt;
+  }
+
+  SwitchPlan plan;
+  plan.variable = chain[0].variable;
+
+  struct Case {
+    int64_t value;
+    std::string target;
+    std::optional<int64_t> result;
+  };
+
+  std::vector<Case> cases;
+  std::set<int64_t> seen;
+
+  for (auto& link : chain) {
+    if (!link.is_equality || link.variable != plan.variable) {
+      break;
+    }
+
+    plan.consumed += 1;
+
+    // A later test of the same literal can never succeed
+    if (seen.insert(link.literal).second) {
+      cases.push_back({link.literal, link.target, link.result});
+    }
+  }
+
+  if (cases.size() < kMinSwitchCases) {
+    return std::nullopt;
+  }
+
+  std::sort(cases.begin(), cases.end(), [](auto& a, auto& b) {
+    return a.value < b.value;
+  });
+
+  for (auto& c : cases) {
+    plan.cases.push_back({.value = c.value, .label = c.target});
+    plan.results.push_back(c.result);
+  }
+
+  if (auto size = DenseTableSize(plan)) {
+    plan.strategy = SwitchPlan::Strategy::TABLE;
+    plan.table_size = *size;
+  }
+  return plan;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void EmitSwitchPlan(qbe::IrEmitter& out, const SwitchPlan& plan,
+                    qbe::QbeValue value, const std::string& default_label,
+                    const std::string& label_prefix,
+                    const qbe::FreshTemp& fresh) {
+  qbe::EmitSwitch(out, value, plan.cases, default_label, label_prefix, fresh,
+                  'l');
+}
+
+bool EmitLookupTable(qbe::IrEmitter& out, qbe::IrEmitter& data,
+                     const SwitchPlan& plan, qbe::QbeValue value,
+                     int64_t default_result, qbe::QbeValue dst,
+                     const std::string& table_name,
+                     const qbe::FreshTemp& fresh) {
+  if (plan.strategy != SwitchPlan::Strategy::TABLE) {
+    return false;
+  }
+
+  bool all_constant =
+      std::all_of(plan.results.begin(), plan.results.end(), [](auto& r) {
+        return r.has_value();
+      });
+  if (!all_constant) {
+    return false;
+  }
+
+  // Holes in the range take the default
+  auto size = plan.table_size;
+  std::vector<int64_t> table(size, default_result);
+  for (size_t i = 0; i < plan.cases.size(); i++) {
+    auto entry = static_cast<uint64_t>(plan.cases[i].value) -
+                 static_cast<uint64_t>(plan.Min());
+    FMT_ASSERT(entry < size, "Case outside of the table");
+    table[entry] = *plan.results[i];
+  }
+
+  data.Emit("data ${} = {{ l {} }}", table_name, fmt::join(table, ", l "));
+
+  // dst = index < size ? table[index] : default (unsigned compare)
+  auto index = fresh();
+  auto in_range = fresh();
+  out.EmitInstr("{} =l sub {}, {}", index, value, plan.Min());
+  out.EmitInstr("{} =w cultl {}, {}", in_range, index, size);
+  out.EmitInstr("{} =l copy {}", dst, default_result);
+  out.EmitInstr("jnz {}, @{}.hit, @{}.done", in_range, table_name,
+                table_name);
+
+  auto offset = fresh();
+  auto address = fresh();
+  out.Emit("@{}.hit", table_name);
+  out.EmitInstr("{} =l mul {}, 8", offset, index);
+  out.EmitInstr("{} =l add ${}, {}", address, table_name, offset);
+  out.EmitInstr("{} =l loadl {}", dst, address);
+  out.Emit("@{}.done", table_name);
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace opt
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <qbe/ir_emitter.hpp>
+#include <qbe/qbe_value.hpp>
+#include <qbe/switch.hpp>
+
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <span>
+
+namespace opt {
+
+//////////////////////////////////////////////////////////////////////
+
+// Turns else-if chains that compare one variable against literals
+//
+//   if c == 'a' { ... } else if c == 'b' { ... } else if ... else { ... }
+//
+// into a single multi-way branch, instead of one compare per link.
+
+// One `if` of the chain, as codegen sees it
+struct ChainLink {
+  // `variable == literal`; anything else ends the switch
+  bool is_equality = false;
+
+  std::string variable;
+  int64_t literal = 0;
+
+  // Block of the then-branch
+  std::string target;
+
+  // The then-branch only produces this constant (for lookup tables)
+  std::optional<int64_t> result;
+};
+
+struct SwitchPlan {
+  enum class Strategy {
+    // Dense cases: index a table (QBE: of results, native: of jumps)
+    TABLE,
+    BINARY_SEARCH,
+  };
+
+  Strategy strategy = Strategy::BINARY_SEARCH;
+
+  // TABLE: entries from Min() to Max(), checked to be few
+  size_t table_size = 0;
+
+  std::string variable;
+
+  // Sorted by value; for a repeated literal the first link wins
+  std::vector<qbe::SwitchCase> cases;
+  std::vector<std::optional<int64_t>> results;
+
+  // Links folded into the switch; the rest of the chain is its default
+  size_t consumed = 0;
+
+  int64_t Min() const {
+    return cases.front().value;
+  }
+
+  int64_t Max() const {
+    return cases.back().value;
+  }
+};
+
+// Shorter chains are left to linear compares
+inline constexpr size_t kMinSwitchCases = 4;
+
+// At least this share of the table range must be actual cases
+inline constexpr size_t kMinTableDensityPercent = 40;
+
+// The longest prefix of `chain` testing one variable against literals
+std::optional<SwitchPlan> RecognizeChain(std::span<const ChainLink> chain);
+
+//////////////////////////////////////////////////////////////////////
+
+// Branch to the plan's targets or to `default_label`.
+// QBE cannot jump through a table, so this is a binary search; see
+// x86::Assembler::JumpTable for the native one.
+void EmitSwitchPlan(qbe::IrEmitter& out, const SwitchPlan& plan,
+                    qbe::QbeValue value, const std::string& default_label,
+                    const std::string& label_prefix,
+                    const qbe::FreshTemp& fresh);
+
+// If every case and the default only produce a constant and the cases
+// are dense, load the result from a read-only table instead of
+// branching at all. `data` receives the table definition (top level).
+// Returns false, emitting nothing, when the plan does not qualify.
+bool EmitLookupTable(qbe::IrEmitter& out, qbe::IrEmitter& data,
+                     const SwitchPlan& plan, qbe::QbeValue value,
+                     int64_t default_result, qbe::QbeValue dst,
+                     const std::string& table_name,
+                     const qbe::FreshTemp& fresh);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace opt
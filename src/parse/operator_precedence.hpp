@@ -0,0 +1,260 @@
+#pragma once
+
+#include <parse/parse_error.hpp>
+
+#include <optional>
+#include <cstddef>
+#include <utility>
+#include <limits>
+#include <vector>
+
+namespace parse {
+
+//////////////////////////////////////////////////////////////////////
+
+// Expressions made of prefix operators, binary operators and
+// parentheses, parsed with explicit stacks (shunting-yard) instead of
+// one recursive call per nesting level: `((((...1...))))` and
+// `- - - ... 1` are as deep as memory allows, not as the C++ stack.
+//
+// The stacks cost more per operator than recursive descent, so they
+// are the parser's way out, not its everyday path: the recursive
+// productions hand a sub-expression over only once they are nested
+// kRecursionDepth deep (see there).
+//
+// The grammar around it stays recursive descent. The parser asks its
+// `Source` for everything else:
+//
+//   std::optional<int> MatchPrefix();     // consume `-`, `!`, `*`, `&`
+//   bool MatchOpenParen();
+//   bool MatchCloseParen();
+//   std::optional<BinaryOperator> PeekBinary();
+//   void ConsumeBinary();
+//
+//   Node ParseOperand();           // literal, name, block, if, ...
+//   Node ParsePostfix(Node node);  // calls, `.field`, `[i]` after it
+//
+//   Node MakeUnary(int op, Node operand);
+//   Node MakeBinary(const BinaryOperator& op, Node lhs, Node rhs);
+//
+//   [[noreturn]] void MissingCloseParen();
+//
+// Prefix operators bind tighter than any binary one, postfix ones
+// tighter still: `-a.b * c` is `(-(a.b)) * c`.
+
+struct BinaryOperator {
+  int token = 0;  // which operator, for `MakeBinary`
+  int precedence = 0;  // higher binds tighter
+  bool right_associative = false;
+};
+
+// For `min_precedence`: the whole expression, or only a unary one
+// (prefixes, an operand or a parenthesized expression, postfixes)
+inline constexpr int kAllOperators = std::numeric_limits<int>::min();
+inline constexpr int kNoOperators = std::numeric_limits<int>::max();
+
+// The parser's working memory. Keep one per Parser and pass it to
+// every call: the vectors are then allocated once, not once per
+// expression. Nested calls (an operand that contains an expression)
+// share it, each working above what its caller left there.
+template <typename Node>
+struct ExpressionStacks {
+  struct Pending {
+    enum Kind { PREFIX, BINARY, PAREN } kind;
+    int prefix = 0;
+    BinaryOperator binary{};
+  };
+
+  std::vector<Node> operands;
+  std::vector<Pending> pending;
+};
+
+// Stops before the first binary operator outside of its own
+// parentheses that binds weaker than `min_precedence`: a recursive
+// production hands over what it would have parsed itself.
+template <typename Node, typename Source>
+Node ParseOperatorExpression(Source& source, ExpressionStacks<Node>& stacks,
+                             int min_precedence = kAllOperators) {
+  using Pending = typename ExpressionStacks<Node>::Pending;
+
+  auto& operands = stacks.operands;
+  auto& pending = stacks.pending;
+
+  // The caller's part of the stacks, restored on the way out even if
+  // the source throws
+  struct Restore {
+    ExpressionStacks<Node>& stacks;
+    size_t operands;
+    size_t pending;
+
+    ~Restore() {
+      stacks.operands.resize(operands);
+      stacks.pending.resize(pending);
+    }
+  } restore{stacks, operands.size(), pending.size()};
+
+  const auto pending_base = restore.pending;
+  size_t open_parens = 0;
+
+  auto pop = [&] {
+    auto node = std::move(operands.back());
+    operands.pop_back();
+    return node;
+  };
+
+  auto reduce = [&] {
+    auto top = pending.back();
+    pending.pop_back();
+
+    if (top.kind == Pending::PREFIX) {
+      operands.push_back(source.MakeUnary(top.prefix, pop()));
+    } else {
+      auto rhs = pop();
+      auto lhs = pop();
+      operands.push_back(
+          source.MakeBinary(top.binary, std::move(lhs), std::move(rhs)));
+    }
+  };
+
+  // Whether what is on the stack is complete before `next` applies
+  auto binds_first = [](const Pending& top, const BinaryOperator& next) {
+    if (top.kind == Pending::PREFIX) {
+      return true;
+    }
+    return top.binary.precedence > next.precedence ||
+           (top.binary.precedence == next.precedence &&
+            !next.right_associative);
+  };
+
+  while (true) {
+    // Operand position: prefixes and parens, then the operand itself
+
+    while (true) {
+      if (auto prefix = source.MatchPrefix()) {
+        pending.push_back({Pending::PREFIX, *prefix, {}});
+      } else if (source.MatchOpenParen()) {
+        pending.push_back({Pending::PAREN, 0, {}});
+        open_parens += 1;
+      } else {
+        break;
+      }
+    }
+
+    operands.push_back(source.ParsePostfix(source.ParseOperand()));
+
+    // Operator position: close parens until a binary operator or the
+    // end of the expression
+
+    while (true) {
+      auto binary = source.PeekBinary();
+
+      // Weaker operators outside our parens are the caller's
+      if (binary && open_parens == 0 &&
+          binary->precedence < min_precedence) {
+        binary.reset();
+      }
+
+      if (binary) {
+        while (pending.size() > pending_base &&
+               pending.back().kind != Pending::PAREN &&
+               binds_first(pending.back(), *binary)) {
+          reduce();
+        }
+
+        source.ConsumeBinary();
+        pending.push_back({Pending::BINARY, 0, *binary});
+        break;
+      }
+
+      // A `)` with no `(` of ours belongs to the caller: `f(a + b)`
+      if (open_parens > 0 && source.MatchCloseParen()) {
+        while (pending.back().kind != Pending::PAREN) {
+          reduce();
+        }
+        pending.pop_back();
+        open_parens -= 1;
+
+        operands.push_back(source.ParsePostfix(pop()));
+        continue;
+      }
+
+      if (open_parens > 0) {
+        source.MissingCloseParen();
+      }
+
+      while (pending.size() > pending_base) {
+        reduce();
+      }
+
+      FMT_ASSERT(operands.size() == restore.operands + 1,
+                 "Unbalanced expression stacks");
+      return pop();
+    }
+  }
+}
+
+template <typename Node, typename Source>
+Node ParseOperatorExpression(Source& source) {
+  ExpressionStacks<Node> stacks;
+  return ParseOperatorExpression(source, stacks);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Recursive descent for ordinary code, explicit stacks past a depth.
+// The productions pass their nesting depth down by value, and where
+// they would recurse deeper than kRecursionDepth they parse what they
+// stand for with ParseOperatorExpression instead:
+//
+//   Expression* Parser::ParseUnary(size_t depth) {
+//     if (Matches(lex::TokenType::MINUS)) {
+//       auto operand = depth < parse::kRecursionDepth
+//                          ? ParseUnary(depth + 1)
+//                          : parse::ParseOperatorExpression(
+//                                source_, stacks_, parse::kNoOperators);
+//       ...
+//     }
+//     ...  // `(`: ParseExpression(depth + 1) or kAllOperators
+//   }
+//
+// A parameter rather than a counter in the Parser: in
+// bench/expressions.cpp a member the calls write to costs the everyday
+// path 10-25%, the parameter and its check about 5%.
+
+inline constexpr size_t kRecursionDepth = 64;
+
+//////////////////////////////////////////////////////////////////////
+
+// For a recursion that cannot pass its depth down: counts the nesting
+// in a counter the caller owns and turns runaway input into a
+// diagnostic rather than a stack overflow.
+//
+//   size_t depth = 0;  // outlives every guard on it
+//   ...
+//   NestingGuard guard{depth, location};  // at each level
+
+class NestingGuard {
+ public:
+  static constexpr size_t kMaxDepth = 1024;
+
+  NestingGuard(size_t& depth, lex::Location location) : depth_{depth} {
+    if (++depth_ > kMaxDepth) {
+      --depth_;
+      throw errors::ParseNestingError{location};
+    }
+  }
+
+  ~NestingGuard() {
+    --depth_;
+  }
+
+  NestingGuard(const NestingGuard&) = delete;
+  NestingGuard& operator=(const NestingGuard&) = delete;
+
+ private:
+  size_t& depth_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace parse
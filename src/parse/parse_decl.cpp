@@ -1,6 +1,9 @@
 #include <parse/parser.hpp>
 #include <parse/parse_error.hpp>
 
+#include <stats/stats.hpp>
+#include <stats/trace.hpp>
+
 ///////////////////////////////////////////////////////////////////
 
 FunDeclStatement* Parser::ParseFunDeclarationStandalone() {
@@ -8,20 +11,91 @@ FunDeclStatement* Parser::ParseFunDeclarationStandalone() {
 
 ///////////////////////////////////////////////////////////////////
 
+auto Parser::ParseModule() -> std::vector<Declaration*> {
+  std::vector<Declaration*> declarations;
+
+  while (true) {
+    try {
+      auto declaration = ParseDeclaration();
+      if (!declaration) {
+        break;
+      }
+      declarations.push_back(declaration);
+    } catch (parse::errors::ParseError& error) {
+      if (!diagnostics_) {
+        throw;
+      }
+
+      auto diagnostic = error.diagnostic;
+      diagnostic.file = file_;
+      diagnostics_->Report(diagnostic);
+
+      Synchronize();
+    }
+  }
+
+  return declarations;
+}
+
+///////////////////////////////////////////////////////////////////
+
 Declaration* Parser::ParseDeclaration() {
+  stats::TraceScope trace{"parse"};
+
+  if (auto import_declaration = ParseImportDeclaration()) {
+    trace.SetName(import_declaration->GetName());
+    return import_declaration;
+  }
+
+  bool exported = Matches(lex::TokenType::EXPORT);
+
   if (auto var_declaration = ParseVarDeclStatement()) {
+    declarations_seen_ = true;
+    var_declaration->exported_ = exported;
+    trace.SetName(var_declaration->GetName());
     return var_declaration;
   }
 
   if (auto fun_declaration = ParseFunDeclStatement()) {
+    declarations_seen_ = true;
+    fun_declaration->exported_ = exported;
+    stats::Count(stats::Counter::FUNCTIONS);
+    trace.SetName(fun_declaration->GetName());
     return fun_declaration;
   }
 
+  if (exported) {
+    throw parse::errors::ParseExportError{CurrentLocation()};
+  }
+
   return nullptr;
 }
 
 ///////////////////////////////////////////////////////////////////
 
+ImportDeclaration* Parser::ParseImportDeclaration() {
+  auto location = CurrentLocation();
+
+  if (!Matches(lex::TokenType::IMPORT)) {
+    return nullptr;
+  }
+
+  // driver::ScanImports only reads the imports at the top of a file;
+  // one further down would be missing from the build graph
+  if (declarations_seen_) {
+    throw parse::errors::ParseImportOrderError{location};
+  }
+
+  Consume(lex::TokenType::IDENTIFIER);
+  auto module = lexer_.GetPreviousToken();
+
+  Consume(lex::TokenType::SEMICOLUMN);
+
+  return new ImportDeclaration{module.GetName(), module.location};
+}
+
+///////////////////////////////////////////////////////////////////
+
 FunDeclStatement* Parser::ParseFunDeclStatement() {
 }
 
@@ -1,49 +1,92 @@
 #pragma once
 
+#include <diag/diagnostic.hpp>
+
 #include <fmt/core.h>
 
 #include <string>
 
 namespace parse::errors {
 
+// Speculative parsing throws and catches these routinely, so they
+// only record the diagnostic; the message is built on first `what()`.
+
 struct ParseError : std::exception {
-  std::string message;
+  diag::Diagnostic diagnostic;
+
+  explicit ParseError(const diag::Diagnostic& diagnostic)
+      : diagnostic{diagnostic} {
+  }
 
   const char* what() const noexcept override {
+    if (message.empty()) {
+      try {
+        message = fmt::format("{} at location {}\n",
+                              diag::FormatMessage(diagnostic),
+                              diagnostic.GetLocation().Format());
+      } catch (...) {
+        return "Parse error";
+      }
+    }
     return message.c_str();
   }
+
+ private:
+  mutable std::string message;
 };
 
 struct ParsePrimaryError : ParseError {
-  ParsePrimaryError(const std::string& location) {
-    message = fmt::format("Could not match primary expression at location {}\n",
-                          location);
+  ParsePrimaryError(lex::Location location)
+      : ParseError{diag::Diagnostic::At(diag::DiagKind::PARSE_PRIMARY,
+                                        location)} {
   }
 };
 
 struct ParseTrueBlockError : ParseError {
-  ParseTrueBlockError(const std::string& location) {
-    message =
-        fmt::format("Could not parse true block at location {}\n", location);
+  ParseTrueBlockError(lex::Location location)
+      : ParseError{diag::Diagnostic::At(diag::DiagKind::PARSE_TRUE_BLOCK,
+                                        location)} {
   }
 };
 
 struct ParseNonLvalueError : ParseError {
-  ParseNonLvalueError(const std::string& location) {
-    message = fmt::format("Expected lvalue at location {}\n", location);
+  ParseNonLvalueError(lex::Location location)
+      : ParseError{diag::Diagnostic::At(diag::DiagKind::PARSE_NON_LVALUE,
+                                        location)} {
   }
 };
 
 struct ParseTypeError : ParseError {
-  ParseTypeError(const std::string& location) {
-    message =
-        fmt::format("Could not parse the type at location {}\n", location);
+  ParseTypeError(lex::Location location)
+      : ParseError{
+            diag::Diagnostic::At(diag::DiagKind::PARSE_TYPE, location)} {
+  }
+};
+
+struct ParseExportError : ParseError {
+  ParseExportError(lex::Location location)
+      : ParseError{
+            diag::Diagnostic::At(diag::DiagKind::PARSE_EXPORT, location)} {
+  }
+};
+
+struct ParseImportOrderError : ParseError {
+  ParseImportOrderError(lex::Location location)
+      : ParseError{diag::Diagnostic::At(diag::DiagKind::PARSE_IMPORT_ORDER,
+                                        location)} {
+  }
+};
+
+struct ParseNestingError : ParseError {
+  ParseNestingError(lex::Location location)
+      : ParseError{
+            diag::Diagnostic::At(diag::DiagKind::PARSE_NESTING, location)} {
   }
 };
 
 struct ParseTokenError : ParseError {
-  ParseTokenError(const std::string& tok, const std::string& location) {
-    message = fmt::format("Expected token {} at location {}\n", tok, location);
+  ParseTokenError(lex::TokenType expected, lex::Location location)
+      : ParseError{diag::Diagnostic::ExpectedToken(expected, location)} {
   }
 };
 
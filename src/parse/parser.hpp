@@ -2,14 +2,29 @@
 
 #include <ast/declarations.hpp>
 
+#include <diag/diagnostic_engine.hpp>
+
 #include <lex/lexer.hpp>
 
+#include <vector>
+
 class Parser {
  public:
   Parser(lex::Lexer& l);
 
+  // Reports the parse errors of ParseModule to `diagnostics`, as
+  // coming from `file`, instead of throwing them
+  Parser(lex::Lexer& l, diag::DiagnosticEngine& diagnostics,
+         diag::FileId file);
+
   ///////////////////////////////////////////////////////////////////
 
+  // The declarations up to the end of input. One that fails to parse
+  // is reported and skipped: parsing resumes at the next declaration
+  // keyword, so a single run reports every broken declaration.
+  // Without an engine the first error is thrown.
+  auto ParseModule() -> std::vector<Declaration*>;
+
 
   ///////////////////////////////////////////////////////////////////
 
@@ -21,6 +36,7 @@ class Parser {
   ////////////////////////////////////////////////////////////////////
 
   Declaration* ParseDeclaration();
+  ImportDeclaration* ParseImportDeclaration();
 
   Declaration* ParsePrototype();
   FunDeclStatement* ParseFunPrototype();
@@ -66,7 +82,10 @@ class Parser {
   ////////////////////////////////////////////////////////////////////
 
  private:
-  std::string FormatLocation();
+  lex::Location CurrentLocation();
+
+  // Skip to the start of the next declaration (or the end of input)
+  void Synchronize();
 
   auto ParseCSV() -> std::vector<Expression*>;
   auto ParseFormals() -> std::vector<lex::Token>;
@@ -77,4 +96,10 @@ class Parser {
 
  private:
   lex::Lexer& lexer_;
+
+  diag::DiagnosticEngine* diagnostics_ = nullptr;
+  diag::FileId file_ = 0;
+
+  // Imports must come first (see driver::ScanImports)
+  bool declarations_seen_ = false;
 };
@@ -4,3 +4,34 @@
 Parser::Parser(lex::Lexer& l) : lexer_{l} {
 }
 
+Parser::Parser(lex::Lexer& l, diag::DiagnosticEngine& diagnostics,
+               diag::FileId file)
+    : lexer_{l}, diagnostics_{&diagnostics}, file_{file} {
+}
+
+///////////////////////////////////////////////////////////////////
+
+lex::Location Parser::CurrentLocation() {
+  return lexer_.Peek().location;
+}
+
+///////////////////////////////////////////////////////////////////
+
+void Parser::Synchronize() {
+  // The token that failed may itself start a declaration, but then
+  // the same error would come right back
+  lexer_.Advance();
+
+  while (true) {
+    switch (lexer_.Peek().type) {
+      case lex::TokenType::FUN:
+      case lex::TokenType::VAR:
+      case lex::TokenType::EXPORT:
+      case lex::TokenType::IMPORT:
+      case lex::TokenType::TOKEN_EOF:
+        return;
+      default:
+        lexer_.Advance();
+    }
+  }
+}
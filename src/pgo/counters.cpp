@@ -0,0 +1,117 @@
+#include <pgo/counters.hpp>
+
+#include <fmt/format.h>
+
+namespace pgo {
+
+//////////////////////////////////////////////////////////////////////
+
+std::string TableSymbol(std::string_view module) {
+  // Module names come from file names; symbols are more picky
+  std::string symbol{"etude_prof."};
+  for (char ch : module) {
+    bool plain = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+                 (ch >= '0' && ch <= '9') || ch == '_' || ch == '.';
+    symbol += plain ? ch : '_';
+  }
+  return symbol;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+uint32_t FunctionCounters::AddSite(uint32_t arms) {
+  first_.push_back(CounterCount());
+  arms_.push_back(arms);
+  return static_cast<uint32_t>(arms_.size() - 1);
+}
+
+size_t FunctionCounters::CounterCount() const {
+  if (arms_.empty()) {
+    return 1;
+  }
+  return first_.back() + arms_.back();
+}
+
+void FunctionCounters::EmitArm(qbe::IrEmitter& out, uint32_t site,
+                               uint32_t arm) const {
+  FMT_ASSERT(site < arms_.size() && arm < arms_[site],
+             "No such branch counter");
+  EmitIncrement(out, first_[site] + arm);
+}
+
+void FunctionCounters::EmitIncrement(qbe::IrEmitter& out,
+                                     size_t counter) const {
+  // QBE puts the temporaries back into SSA form, so every increment
+  // can reuse the same names
+  out.EmitInstr("%.prof =l add ${}.counters, {}", symbol_, counter * 8);
+  out.EmitInstr("%.prof.n =l loadl %.prof");
+  out.EmitInstr("%.prof.n =l add %.prof.n, 1");
+  out.EmitInstr("storel %.prof.n, %.prof");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+CounterTable::CounterTable(std::string_view module)
+    : module_{module}, symbol_{TableSymbol(module)} {
+}
+
+size_t CounterTable::AddFunction(std::string_view name) {
+  auto index = functions_.size();
+  functions_.emplace_back(fmt::format("{}.{}", symbol_, index),
+                          std::string{name});
+  return index;
+}
+
+void CounterTable::EmitData(qbe::IrEmitter& out) const {
+  out.Emit("data ${}.module = {{ b \"{}\", b 0 }}", symbol_, module_);
+
+  for (auto& fun : functions_) {
+    auto& symbol = fun.symbol_;
+
+    out.Emit("data ${}.counters = align 8 {{ z {} }}", symbol,
+             fun.CounterCount() * 8);
+    out.Emit("data ${}.name = {{ b \"{}\", b 0 }}", symbol, fun.name_);
+
+    if (fun.arms_.empty()) {
+      out.Emit(
+          "data ${} = align 8 {{ l ${}.module, l ${}.name, "
+          "l ${}.counters, l 0, l 0 }}",
+          symbol, symbol_, symbol, symbol);
+      continue;
+    }
+
+    out.Emit("data ${}.arms = align 4 {{ w {} }}", symbol,
+             fmt::join(fun.arms_, " "));
+    out.Emit(
+        "data ${} = align 8 {{ l ${}.module, l ${}.name, "
+        "l ${}.counters, l ${}.arms, l {} }}",
+        symbol, symbol_, symbol, symbol, symbol, fun.arms_.size());
+  }
+
+  fmt::memory_buffer list;
+  for (auto& fun : functions_) {
+    fmt::format_to(std::back_inserter(list), "l ${}, ", fun.symbol_);
+  }
+  out.Emit("export data ${} = align 8 {{ {}l 0 }}", symbol_,
+           fmt::to_string(list));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void EmitModuleList(qbe::IrEmitter& out,
+                    std::span<const std::string> modules) {
+  fmt::memory_buffer list;
+  for (auto& module : modules) {
+    fmt::format_to(std::back_inserter(list), "l ${}, ", TableSymbol(module));
+  }
+  out.Emit("export data $etude_prof_modules = align 8 {{ {}l 0 }}",
+           fmt::to_string(list));
+
+  // Nothing else in the program refers to the dump code of the
+  // runtime, so without this it is not linked in from the archive
+  out.Emit("data $etude_prof.init = align 8 {{ l $etude_prof_init }}");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace pgo
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <qbe/ir_emitter.hpp>
+
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <span>
+
+namespace pgo {
+
+//////////////////////////////////////////////////////////////////////
+
+// The counters `etudec --instrument` puts into a module, and the data
+// the runtime needs to dump them (runtime/etude_rt.h).
+//
+// Every function gets a block of its own, registered in declaration
+// order before lowering starts. A worker then only touches the block
+// of the function it lowers, so lowering stays parallel and the
+// output stays the same whatever the number of workers:
+//
+//   CounterTable table{module.name};
+//   for (auto& fun : funs) {
+//     table.AddFunction(fun->GetName());
+//   }
+//   codegen.LowerAll(funs.size(), [&](size_t i, qbe::IrEmitter& out) {
+//     auto& counters = table.Function(i);
+//     ...                       // after the function's @start:
+//     counters.EmitEntry(out);
+//     ...                       // `if`: two arms, then and else
+//     auto site = counters.AddSite(2);
+//     counters.EmitArm(out, site, 0);  // first thing in @then
+//   });
+//   table.EmitData(ir);
+
+class FunctionCounters {
+ public:
+  FunctionCounters(std::string symbol, std::string name)
+      : symbol_{std::move(symbol)}, name_{std::move(name)} {
+  }
+
+  // A branch with `arms` ways to go; sites are numbered in the order
+  // they are added, which must not depend on anything but the source
+  uint32_t AddSite(uint32_t arms);
+
+  void EmitEntry(qbe::IrEmitter& out) const {
+    EmitIncrement(out, 0);
+  }
+
+  void EmitArm(qbe::IrEmitter& out, uint32_t site, uint32_t arm) const;
+
+  std::string_view Name() const {
+    return name_;
+  }
+
+  // Symbol of the counter block's descriptor
+  std::string_view Symbol() const {
+    return symbol_;
+  }
+
+  size_t CounterCount() const;
+
+  std::span<const uint32_t> Arms() const {
+    return arms_;
+  }
+
+ private:
+  void EmitIncrement(qbe::IrEmitter& out, size_t counter) const;
+
+  friend class CounterTable;
+
+ private:
+  std::string symbol_;
+  std::string name_;
+
+  std::vector<uint32_t> arms_;  // of each site
+  std::vector<size_t> first_;   // counter of each site's arm 0
+};
+
+//////////////////////////////////////////////////////////////////////
+
+class CounterTable {
+ public:
+  explicit CounterTable(std::string_view module);
+
+  // Before lowering, serially; returns the function's index
+  size_t AddFunction(std::string_view name);
+
+  FunctionCounters& Function(size_t index) {
+    return functions_[index];
+  }
+
+  // After lowering: the counters and the descriptors of the module
+  void EmitData(qbe::IrEmitter& out) const;
+
+  // The module's NULL-terminated array of descriptors
+  std::string_view Symbol() const {
+    return symbol_;
+  }
+
+ private:
+  std::string module_;
+  std::string symbol_;
+
+  std::vector<FunctionCounters> functions_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// The symbol of the counter table of `module`
+std::string TableSymbol(std::string_view module);
+
+// The `etude_prof_modules` list the runtime dumps at exit: one extra
+// IR file linked into every instrumented program. It also refers to
+// `etude_prof_init`, which pulls the dump out of libetude_rt.a.
+void EmitModuleList(qbe::IrEmitter& out,
+                    std::span<const std::string> modules);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace pgo
@@ -0,0 +1,66 @@
+#include <pgo/decisions.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+namespace pgo {
+
+//////////////////////////////////////////////////////////////////////
+
+std::vector<size_t> HotFirstOrder(const Profile& profile,
+                                  std::string_view module,
+                                  std::span<const std::string> functions) {
+  std::vector<uint64_t> counts;
+  for (auto& fun : functions) {
+    counts.push_back(profile.EntryCount(module, fun));
+  }
+
+  std::vector<size_t> order(functions.size());
+  std::iota(order.begin(), order.end(), 0);
+
+  // Stable: functions that never ran stay in declaration order
+  std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+    return counts[lhs] > counts[rhs];
+  });
+
+  return order;
+}
+
+std::vector<uint32_t> ArmLayout(std::span<const uint64_t> counts,
+                                uint32_t arms) {
+  std::vector<uint32_t> order(arms);
+  std::iota(order.begin(), order.end(), 0);
+
+  // A profile of another version of the function
+  if (counts.size() != arms) {
+    return order;
+  }
+
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) {
+    return counts[lhs] > counts[rhs];
+  });
+
+  return order;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+size_t InlineAdvisor::Budget(std::optional<uint64_t> site_count) const {
+  if (!profile_ || profile_->MaxEntryCount() == 0 || !site_count) {
+    return options_.default_size;
+  }
+
+  if (*site_count == 0) {
+    return options_.cold_size;
+  }
+
+  if (*site_count * options_.hot_ratio >= profile_->MaxEntryCount()) {
+    return options_.hot_size;
+  }
+
+  return options_.default_size;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace pgo
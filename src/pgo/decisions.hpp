@@ -0,0 +1,75 @@
+#pragma once
+
+#include <pgo/profile.hpp>
+
+#include <string_view>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <span>
+
+namespace pgo {
+
+//////////////////////////////////////////////////////////////////////
+
+// What `etudec --profile-use` changes in the output. Without counts
+// for something, each of these keeps what codegen does by default.
+
+// The order to write out the functions of `module` (given in
+// declaration order): those that ran, hottest first, then the others
+// as declared. Hot code ends up packed on few pages.
+std::vector<size_t> HotFirstOrder(const Profile& profile,
+                                  std::string_view module,
+                                  std::span<const std::string> functions);
+
+// The order to place the arm blocks of a branch site in, given the
+// site's counts: the most taken arm goes right after the branch and
+// falls through, the rest follow by decreasing count. Ties, and sites
+// without counts, keep the source order.
+std::vector<uint32_t> ArmLayout(std::span<const uint64_t> counts,
+                                uint32_t arms);
+
+//////////////////////////////////////////////////////////////////////
+
+// Sizes are in IR instructions of the callee
+struct InlineOptions {
+  size_t default_size = 16;
+
+  // Call sites that ran at least 1/hot_ratio as often as the hottest
+  // function was entered
+  uint64_t hot_ratio = 100;
+  size_t hot_size = 64;
+
+  // Call sites that never ran: only what is smaller than a call
+  size_t cold_size = 4;
+};
+
+class InlineAdvisor {
+ public:
+  // `profile` may be null: every site gets the default budget
+  explicit InlineAdvisor(const Profile* profile, InlineOptions options = {})
+      : profile_{profile}, options_{options} {
+  }
+
+  // `site_count`: how often the call ran, i.e. the count of the arm
+  // it is in, or its function's entry count outside of any branch.
+  // Nullopt when the profile has no counts for the site (a function
+  // added since the instrumented run): the default budget, not the
+  // cold one.
+  size_t Budget(std::optional<uint64_t> site_count) const;
+
+  bool ShouldInline(std::optional<uint64_t> site_count,
+                    size_t callee_size) const {
+    return callee_size <= Budget(site_count);
+  }
+
+ private:
+  const Profile* profile_;
+  InlineOptions options_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace pgo
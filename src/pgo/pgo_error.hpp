@@ -0,0 +1,30 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <cstddef>
+#include <string>
+
+namespace pgo::errors {
+
+struct PgoError : std::exception {
+  std::string message;
+
+  const char* what() const noexcept override {
+    return message.c_str();
+  }
+};
+
+struct ProfileReadError : PgoError {
+  ProfileReadError(const std::string& path) {
+    message = fmt::format("Could not read profile {}\n", path);
+  }
+};
+
+struct ProfileFormatError : PgoError {
+  ProfileFormatError(const std::string& path, size_t lineno) {
+    message = fmt::format("{}:{}: malformed profile line\n", path, lineno);
+  }
+};
+
+}  // namespace pgo::errors
@@ -0,0 +1,133 @@
+#include <pgo/profile.hpp>
+#include <pgo/pgo_error.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+
+namespace pgo {
+
+//////////////////////////////////////////////////////////////////////
+
+template <typename T>
+static bool ParseNumber(std::string_view text, T& value) {
+  auto end = text.data() + text.size();
+  auto [ptr, ec] = std::from_chars(text.data(), end, value);
+  return ec == std::errc{} && ptr == end;
+}
+
+// "<module> <function> entry|<site>.<arm> <count>"
+static bool ParseLine(std::string_view line, std::string_view fields[4]) {
+  for (size_t i = 0; i < 4; i++) {
+    auto space = line.find(' ');
+    if ((space == line.npos) != (i == 3)) {
+      return false;
+    }
+    fields[i] = line.substr(0, space);
+    if (fields[i].empty()) {
+      return false;
+    }
+    line.remove_prefix(space == line.npos ? line.size() : space + 1);
+  }
+  return true;
+}
+
+std::string Profile::Key(std::string_view module,
+                         std::string_view function) {
+  std::string key{module};
+  key += ' ';
+  key += function;
+  return key;
+}
+
+void Profile::Merge(std::string_view text, const std::string& path) {
+  size_t lineno = 0;
+
+  while (!text.empty()) {
+    auto newline = text.find('\n');
+    auto line = text.substr(0, newline);
+    text.remove_prefix(newline == text.npos ? text.size() : newline + 1);
+    lineno += 1;
+
+    if (line.empty() || line.starts_with('#')) {
+      continue;
+    }
+
+    std::string_view fields[4];
+    uint64_t count = 0;
+    if (!ParseLine(line, fields) || !ParseNumber(fields[3], count)) {
+      throw errors::ProfileFormatError{path, lineno};
+    }
+
+    auto& fun = functions_[Key(fields[0], fields[1])];
+
+    if (fields[2] == "entry") {
+      fun.entry += count;
+      max_entry_ = std::max(max_entry_, fun.entry);
+      continue;
+    }
+
+    auto dot = fields[2].find('.');
+    uint32_t site = 0;
+    uint32_t arm = 0;
+    if (dot == fields[2].npos ||
+        !ParseNumber(fields[2].substr(0, dot), site) ||
+        !ParseNumber(fields[2].substr(dot + 1), arm)) {
+      throw errors::ProfileFormatError{path, lineno};
+    }
+
+    if (fun.sites.size() <= site) {
+      fun.sites.resize(site + 1);
+    }
+    auto& arms = fun.sites[site];
+    if (arms.size() <= arm) {
+      arms.resize(arm + 1);
+    }
+    arms[arm] += count;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+const FunctionProfile* Profile::Find(std::string_view module,
+                                     std::string_view function) const {
+  auto it = functions_.find(Key(module, function));
+  return it == functions_.end() ? nullptr : &it->second;
+}
+
+uint64_t Profile::EntryCount(std::string_view module,
+                             std::string_view function) const {
+  auto fun = Find(module, function);
+  return fun ? fun->entry : 0;
+}
+
+std::vector<uint64_t> Profile::ArmCounts(std::string_view module,
+                                         std::string_view function,
+                                         uint32_t site) const {
+  auto fun = Find(module, function);
+  if (!fun || site >= fun->sites.size()) {
+    return {};
+  }
+  return fun->sites[site];
+}
+
+//////////////////////////////////////////////////////////////////////
+
+Profile ReadProfile(const std::filesystem::path& path) {
+  std::ifstream file{path};
+  if (!file) {
+    throw errors::ProfileReadError{path.string()};
+  }
+
+  std::stringstream text;
+  text << file.rdbuf();
+
+  Profile profile;
+  profile.Merge(text.str(), path.string());
+  return profile;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace pgo
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace pgo {
+
+//////////////////////////////////////////////////////////////////////
+
+// What instrumented runs counted (see runtime/etude_rt.h for the file
+// format). Repeated lines, from several runs, add up.
+
+struct FunctionProfile {
+  uint64_t entry = 0;
+
+  // Per branch site, per arm
+  std::vector<std::vector<uint64_t>> sites;
+};
+
+class Profile {
+ public:
+  // Parse the text of a profile; `path` is only for error messages.
+  // Throws errors::ProfileFormatError.
+  void Merge(std::string_view text, const std::string& path = "<profile>");
+
+  // Null for a function that never ran (or is not in the profile)
+  const FunctionProfile* Find(std::string_view module,
+                              std::string_view function) const;
+
+  uint64_t EntryCount(std::string_view module,
+                      std::string_view function) const;
+
+  // Empty when unknown; then nothing is known about the layout
+  std::vector<uint64_t> ArmCounts(std::string_view module,
+                                  std::string_view function,
+                                  uint32_t site) const;
+
+  // Entry count of the hottest function, the scale for "hot"
+  uint64_t MaxEntryCount() const {
+    return max_entry_;
+  }
+
+  size_t FunctionCount() const {
+    return functions_.size();
+  }
+
+ private:
+  // "<module> <function>", as in the file
+  static std::string Key(std::string_view module, std::string_view function);
+
+  std::map<std::string, FunctionProfile, std::less<>> functions_;
+  uint64_t max_entry_ = 0;
+};
+
+// Throws errors::ProfileReadError, errors::ProfileFormatError
+Profile ReadProfile(const std::filesystem::path& path);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace pgo
@@ -0,0 +1,68 @@
+#include <qbe/ir_emitter.hpp>
+#include <qbe/qbe_error.hpp>
+
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace qbe {
+
+//////////////////////////////////////////////////////////////////////
+
+IrEmitter::IrEmitter() {
+}
+
+IrEmitter::IrEmitter(int fd, size_t flush_threshold)
+    : fd_{fd}, threshold_{flush_threshold} {
+  // Leave some room so that a line crossing the threshold
+  // does not trigger a reallocation right before the flush
+  buffer_.reserve(threshold_ + threshold_ / 4);
+}
+
+IrEmitter::~IrEmitter() {
+  try {
+    Flush();
+  } catch (...) {
+    // Destructor must not throw, call `Flush` explicitly
+    // to observe write errors
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void IrEmitter::Append(std::string_view text) {
+  buffer_.append(text.data(), text.data() + text.size());
+  MaybeFlush();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void IrEmitter::Flush() {
+  if (fd_ < 0) {
+    return;
+  }
+
+  const char* data = buffer_.data();
+  size_t left = buffer_.size();
+
+  while (left > 0) {
+    auto n = ::write(fd_, data, left);
+
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw errors::WriteError{errno};
+    }
+
+    data += n;
+    left -= n;
+  }
+
+  written_ += buffer_.size();
+  buffer_.clear();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace qbe
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <string_view>
+#include <iterator>
+#include <cstddef>
+
+namespace qbe {
+
+//////////////////////////////////////////////////////////////////////
+
+// Formats IR text directly into one reusable buffer and hands it to
+// the file descriptor in big chunks with a single write(2).
+//
+// Once the buffer has grown to its working size, emitting an
+// instruction allocates nothing.
+//
+//   IrEmitter out{fd};
+//   out.Emit("function w ${}() {{", name);
+//   out.Emit("@start");
+//   out.EmitInstr("{} =w add {}, {}", dst, lhs, rhs);
+//
+
+class IrEmitter {
+ public:
+  static constexpr size_t kFlushThreshold = 64 * 1024;
+
+  // Keep everything in memory, nothing is written until the contents
+  // are taken by the caller (see `Contents`, `Clear`)
+  IrEmitter();
+
+  // Stream to `fd` whenever the buffer exceeds `flush_threshold` bytes
+  explicit IrEmitter(int fd, size_t flush_threshold = kFlushThreshold);
+
+  IrEmitter(const IrEmitter&) = delete;
+  IrEmitter& operator=(const IrEmitter&) = delete;
+
+  ~IrEmitter();
+
+  ////////////////////////////////////////////////////////////////////
+
+  // Top-level line: function header, label, data definition
+  template <typename... Args>
+  void Emit(fmt::format_string<Args...> format, Args&&... args) {
+    fmt::format_to(std::back_inserter(buffer_), format,
+                   std::forward<Args>(args)...);
+    buffer_.push_back('\n');
+    MaybeFlush();
+  }
+
+  // Instruction inside a function body
+  template <typename... Args>
+  void EmitInstr(fmt::format_string<Args...> format, Args&&... args) {
+    buffer_.push_back('\t');
+    Emit(format, std::forward<Args>(args)...);
+  }
+
+  // Verbatim text, e.g. an already lowered function
+  void Append(std::string_view text);
+
+  ////////////////////////////////////////////////////////////////////
+
+  // Write out everything buffered so far (no-op in memory mode)
+  void Flush();
+
+  std::string_view Contents() const {
+    return {buffer_.data(), buffer_.size()};
+  }
+
+  // Drop the contents but keep the capacity for the next round
+  void Clear() {
+    buffer_.clear();
+  }
+
+  size_t BytesWritten() const {
+    return written_;
+  }
+
+ private:
+  void MaybeFlush() {
+    if (fd_ >= 0 && buffer_.size() >= threshold_) {
+      Flush();
+    }
+  }
+
+ private:
+  int fd_ = -1;
+  size_t threshold_ = kFlushThreshold;
+  size_t written_ = 0;
+
+  fmt::memory_buffer buffer_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace qbe
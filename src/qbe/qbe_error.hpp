@@ -0,0 +1,31 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <cstring>
+#include <string>
+
+namespace qbe::errors {
+
+struct QbeError : std::exception {
+  std::string message;
+
+  const char* what() const noexcept override {
+    return message.c_str();
+  }
+};
+
+struct WriteError : QbeError {
+  WriteError(int err) {
+    message = fmt::format("Could not write IR: {}\n", std::strerror(err));
+  }
+};
+
+struct SpawnError : QbeError {
+  SpawnError(const std::string& program, int err) {
+    message = fmt::format("Could not start {}: {}\n", program,
+                          std::strerror(err));
+  }
+};
+
+}  // namespace qbe::errors
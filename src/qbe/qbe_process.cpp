@@ -0,0 +1,88 @@
+#include <qbe/qbe_process.hpp>
+#include <qbe/qbe_error.hpp>
+
+#include <sys/wait.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+extern char** environ;
+
+namespace qbe {
+
+//////////////////////////////////////////////////////////////////////
+
+QbeProcess::QbeProcess(std::vector<std::string> argv, int out_fd)
+    : program_{argv.at(0)} {
+  int fds[2];
+
+  // O_CLOEXEC: other children spawned meanwhile must not
+  // inherit the write end, or qbe never sees EOF
+  if (::pipe2(fds, O_CLOEXEC) < 0) {
+    throw errors::SpawnError{program_, errno};
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fds[0], STDIN_FILENO);
+  if (out_fd >= 0) {
+    posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO);
+  }
+
+  std::vector<char*> args;
+  for (auto& arg : argv) {
+    args.push_back(arg.data());
+  }
+  args.push_back(nullptr);
+
+  int err = posix_spawnp(&pid_, program_.c_str(), &actions, nullptr,
+                         args.data(), environ);
+
+  posix_spawn_file_actions_destroy(&actions);
+  ::close(fds[0]);
+
+  if (err != 0) {
+    ::close(fds[1]);
+    throw errors::SpawnError{program_, err};
+  }
+
+  input_fd_ = fds[1];
+}
+
+QbeProcess::~QbeProcess() {
+  Wait();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int QbeProcess::Wait() {
+  if (input_fd_ >= 0) {
+    ::close(input_fd_);
+    input_fd_ = -1;
+  }
+
+  if (pid_ < 0) {
+    return -1;
+  }
+
+  int status = 0;
+  while (::waitpid(pid_, &status, 0) < 0) {
+    if (errno != EINTR) {
+      pid_ = -1;
+      return -1;
+    }
+  }
+  pid_ = -1;
+
+  if (WIFSIGNALED(status)) {
+    return 128 + WTERMSIG(status);
+  }
+
+  return WEXITSTATUS(status);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace qbe
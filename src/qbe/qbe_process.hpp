@@ -0,0 +1,51 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+namespace qbe {
+
+//////////////////////////////////////////////////////////////////////
+
+// Runs `qbe` as a child process reading IR from a pipe, so the IR
+// never touches a temporary file:
+//
+//   QbeProcess qbe{{"qbe", "-o", "out.s"}};
+//   IrEmitter out{qbe.InputFd()};
+//   ... emit ...
+//   out.Flush();
+//   int status = qbe.Wait();
+//
+// Note: if the child dies early, writing to the pipe raises SIGPIPE.
+// The driver is expected to ignore it and report the exit status.
+
+class QbeProcess {
+ public:
+  explicit QbeProcess(std::vector<std::string> argv = {"qbe"},
+                      int out_fd = -1);
+
+  QbeProcess(const QbeProcess&) = delete;
+  QbeProcess& operator=(const QbeProcess&) = delete;
+
+  ~QbeProcess();
+
+  int InputFd() const {
+    return input_fd_;
+  }
+
+  // Close the pipe and wait for the child. Returns its exit code,
+  // or 128 + signal number if it was killed.
+  int Wait();
+
+ private:
+  std::string program_;
+
+  pid_t pid_ = -1;
+  int input_fd_ = -1;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace qbe
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+namespace qbe {
+
+//////////////////////////////////////////////////////////////////////
+
+// QbeValue = Temporary (%.1) | Global ($data) | Const (4)
+//
+// Trivially copyable and formatted in place, so operands never have
+// to be turned into strings before they reach the output buffer.
+
+struct QbeValue {
+  enum class Kind {
+    TEMPORARY,
+    GLOBAL,
+    CONST,
+  };
+
+  static QbeValue Temporary(size_t id) {
+    return {.kind = Kind::TEMPORARY, .id = id};
+  }
+
+  static QbeValue Global(std::string_view name) {
+    return {.kind = Kind::GLOBAL, .name = name};
+  }
+
+  static QbeValue Const(int64_t value) {
+    return {.kind = Kind::CONST, .value = value};
+  }
+
+  Kind kind = Kind::CONST;
+
+  size_t id = 0;
+  std::string_view name{};
+  int64_t value = 0;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace qbe
+
+template <>
+struct fmt::formatter<qbe::QbeValue> {
+  constexpr auto parse(format_parse_context& ctx) {
+    return ctx.begin();
+  }
+
+  template <typename FormatContext>
+  auto format(const qbe::QbeValue& v, FormatContext& ctx) const {
+    switch (v.kind) {
+      case qbe::QbeValue::Kind::TEMPORARY:
+        return fmt::format_to(ctx.out(), "%.{}", v.id);
+      case qbe::QbeValue::Kind::GLOBAL:
+        return fmt::format_to(ctx.out(), "${}", v.name);
+      case qbe::QbeValue::Kind::CONST:
+        return fmt::format_to(ctx.out(), "{}", v.value);
+    }
+    return ctx.out();
+  }
+};
@@ -0,0 +1,104 @@
+#include <qbe/switch.hpp>
+
+#include <algorithm>
+#include <span>
+
+namespace qbe {
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+class SearchEmitter {
+ public:
+  SearchEmitter(IrEmitter& out, QbeValue value,
+                const std::string& default_label, const std::string& prefix,
+                const FreshTemp& fresh, char value_class)
+      : out_{out},
+        value_{value},
+        default_{default_label},
+        prefix_{prefix},
+        fresh_{fresh},
+        class_{value_class} {
+  }
+
+  // Emits the tests for `cases` starting in the current block
+  void Emit(std::span<const SwitchCase> cases) {
+    if (cases.empty()) {
+      out_.EmitInstr("jmp @{}", default_);
+      return;
+    }
+
+    if (cases.size() <= 2) {
+      for (auto& c : cases) {
+        auto last = &c == &cases.back();
+        auto next = last ? default_ : NewLabel();
+
+        auto is_equal = fresh_();
+        out_.EmitInstr("{} =w ceq{} {}, {}", is_equal, class_, value_,
+                       c.value);
+        out_.EmitInstr("jnz {}, @{}, @{}", is_equal, c.label, next);
+
+        if (!last) {
+          out_.Emit("@{}", next);
+        }
+      }
+      return;
+    }
+
+    // value < pivot goes left, the rest (pivot included) right
+    auto middle = cases.size() / 2;
+    auto pivot = cases[middle].value;
+
+    auto left = NewLabel();
+    auto right = NewLabel();
+
+    auto is_less = fresh_();
+    out_.EmitInstr("{} =w cslt{} {}, {}", is_less, class_, value_,
+                   pivot);
+    out_.EmitInstr("jnz {}, @{}, @{}", is_less, left, right);
+
+    out_.Emit("@{}", left);
+    Emit(cases.first(middle));
+
+    out_.Emit("@{}", right);
+    Emit(cases.subspan(middle));
+  }
+
+ private:
+  std::string NewLabel() {
+    return fmt::format("{}.{}", prefix_, next_label_++);
+  }
+
+ private:
+  IrEmitter& out_;
+  QbeValue value_;
+  const std::string& default_;
+  const std::string& prefix_;
+  const FreshTemp& fresh_;
+  char class_;
+
+  size_t next_label_ = 0;
+};
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+void EmitSwitch(IrEmitter& out, QbeValue value,
+                std::vector<SwitchCase> cases,
+                const std::string& default_label,
+                const std::string& label_prefix, const FreshTemp& fresh,
+                char value_class) {
+  std::sort(cases.begin(), cases.end(), [](auto& a, auto& b) {
+    return a.value < b.value;
+  });
+
+  SearchEmitter search{out, value, default_label,
+                      label_prefix, fresh, value_class};
+  search.Emit(cases);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace qbe
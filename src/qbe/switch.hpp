@@ -0,0 +1,38 @@
+#pragma once
+
+#include <qbe/ir_emitter.hpp>
+#include <qbe/qbe_value.hpp>
+
+#include <functional>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace qbe {
+
+//////////////////////////////////////////////////////////////////////
+
+// Multi-way branch on an integer value of class `w` or `l`.
+//
+// QBE has no indirect jump, so a jump table cannot be expressed in
+// its IL; the cases are dispatched by a balanced binary search
+// instead: O(log n) compares, never a linear chain.
+
+struct SwitchCase {
+  int64_t value = 0;
+  std::string label;  // without the `@`
+};
+
+using FreshTemp = std::function<QbeValue()>;
+
+// `label_prefix` names the inner blocks of the search tree and must
+// be unique within the function
+void EmitSwitch(IrEmitter& out, QbeValue value,
+                std::vector<SwitchCase> cases,
+                const std::string& default_label,
+                const std::string& label_prefix, const FreshTemp& fresh,
+                char value_class = 'w');
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace qbe
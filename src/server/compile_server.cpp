@@ -0,0 +1,212 @@
+#include <server/compile_server.hpp>
+#include <server/server_error.hpp>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <cerrno>
+
+namespace server {
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+sockaddr_un AddressOf(const std::filesystem::path& socket) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+
+  auto& path = socket.native();
+  if (path.size() >= sizeof(address.sun_path)) {
+    throw errors::SocketError{path, "use", ENAMETOOLONG};
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  return address;
+}
+
+// Connected socket, or -1 with errno set
+int Connect(const std::filesystem::path& socket) {
+  auto address = AddressOf(socket);
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                sizeof(address)) < 0) {
+    int err = errno;
+    ::close(fd);
+    errno = err;
+    return -1;
+  }
+
+  return fd;
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+CompileServer::CompileServer(std::filesystem::path socket, Handler handler)
+    : socket_{std::move(socket)}, handler_{std::move(handler)} {
+  auto address = AddressOf(socket_);
+
+  if (std::filesystem::exists(socket_)) {
+    if (int fd = Connect(socket_); fd >= 0) {
+      ::close(fd);
+      throw errors::SocketError{socket_, "listen on", EADDRINUSE};
+    }
+    std::filesystem::remove(socket_);
+  }
+
+  listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    throw errors::SocketError{socket_, "create", errno};
+  }
+
+  if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)) < 0 ||
+      ::listen(listen_fd_, SOMAXCONN) < 0) {
+    int err = errno;
+    ::close(listen_fd_);
+    throw errors::SocketError{socket_, "listen on", err};
+  }
+}
+
+CompileServer::~CompileServer() {
+  Stop();
+  ReapConnections(/*all=*/true);
+
+  ::close(listen_fd_);
+  std::error_code ignored;
+  std::filesystem::remove(socket_, ignored);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void CompileServer::Serve() {
+  while (!stopping_) {
+    int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (stopping_) {
+        break;
+      }
+      throw errors::SocketError{socket_, "accept on", errno};
+    }
+
+    ReapConnections(/*all=*/false);
+
+    std::lock_guard guard{mutex_};
+    auto& connection = connections_.emplace_back();
+    connection.fd = fd;
+    if (stopping_) {
+      ::shutdown(fd, SHUT_RD);  // raced with `Stop`
+    }
+    connection.thread = std::thread([this, &connection] {
+      ServeConnection(connection);
+      connection.done = true;
+    });
+  }
+
+  ReapConnections(/*all=*/true);
+}
+
+void CompileServer::Stop() {
+  if (stopping_.exchange(true)) {
+    return;
+  }
+
+  // Wakes up `accept`, and the connections waiting for a request
+  ::shutdown(listen_fd_, SHUT_RDWR);
+
+  std::lock_guard guard{mutex_};
+  for (auto& connection : connections_) {
+    if (connection.fd >= 0) {
+      ::shutdown(connection.fd, SHUT_RD);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void CompileServer::ServeConnection(Connection& connection) {
+  int fd = connection.fd;
+
+  try {
+    while (auto frame = ReceiveFrame(fd)) {
+      CompileResponse response;
+
+      try {
+        response = handler_(DecodeRequest(*frame));
+      } catch (std::exception& error) {
+        response.status = 1;
+        response.output = error.what();
+      }
+
+      SendFrame(fd, Encode(response));
+      served_ += 1;
+    }
+  } catch (errors::ServerError&) {
+    // A broken client only loses its own connection
+  }
+
+  std::lock_guard guard{mutex_};
+  ::close(fd);
+  connection.fd = -1;
+}
+
+void CompileServer::ReapConnections(bool all) {
+  std::list<Connection> finished;
+
+  {
+    std::lock_guard guard{mutex_};
+    for (auto it = connections_.begin(); it != connections_.end();) {
+      auto next = std::next(it);
+      if (all || it->done) {
+        finished.splice(finished.end(), connections_, it);
+      }
+      it = next;
+    }
+  }
+
+  for (auto& connection : finished) {
+    connection.thread.join();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+CompileResponse SendCompileRequest(const std::filesystem::path& socket,
+                                   const CompileRequest& request) {
+  int fd = Connect(socket);
+  if (fd < 0) {
+    throw errors::SocketError{socket, "connect to", errno};
+  }
+
+  try {
+    SendFrame(fd, Encode(request));
+
+    auto frame = ReceiveFrame(fd);
+    if (!frame) {
+      throw errors::ProtocolError{"server closed the connection"};
+    }
+
+    ::close(fd);
+    return DecodeResponse(*frame);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace server
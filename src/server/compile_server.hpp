@@ -0,0 +1,87 @@
+#pragma once
+
+#include <server/protocol.hpp>
+
+#include <filesystem>
+#include <functional>
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <list>
+
+namespace server {
+
+//////////////////////////////////////////////////////////////////////
+
+// `etudec --serve=<socket>`: a long-lived compiler process that keeps
+// its caches warm and compiles on behalf of thin clients, so a build
+// issuing thousands of small compiles pays for process startup and
+// for loading the common interfaces once.
+//
+//   CompileServer server{"/tmp/etude.sock", [&](auto& request) {
+//     return Compile(request);
+//   }};
+//   server.Serve();  // until Stop()
+//
+// Every connection is served on its own thread: the handler must be
+// safe to call concurrently.
+
+class CompileServer {
+ public:
+  using Handler = std::function<CompileResponse(const CompileRequest&)>;
+
+  // Listens right away; a socket file left by a dead server is
+  // replaced, one with a live server behind it is an error
+  CompileServer(std::filesystem::path socket, Handler handler);
+  ~CompileServer();
+
+  CompileServer(const CompileServer&) = delete;
+  CompileServer& operator=(const CompileServer&) = delete;
+
+  // Accept connections until `Stop`; then finish the requests in
+  // flight
+  void Serve();
+
+  // From any thread. Idle connections are closed, requests already
+  // read are still answered.
+  void Stop();
+
+  size_t RequestsServed() const {
+    return served_.load();
+  }
+
+ private:
+  struct Connection;
+
+  void ServeConnection(Connection& connection);
+  void ReapConnections(bool all);
+
+ private:
+  std::filesystem::path socket_;
+  Handler handler_;
+
+  int listen_fd_ = -1;
+  std::atomic<bool> stopping_{false};
+  std::atomic<size_t> served_{0};
+
+  struct Connection {
+    std::thread thread;
+    int fd = -1;  // guarded by mutex_, -1 once closed
+    std::atomic<bool> done{false};
+  };
+
+  std::mutex mutex_;
+  std::list<Connection> connections_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// The client side: send one request and wait for the answer.
+// Throws errors::SocketError if no server listens on `socket`.
+CompileResponse SendCompileRequest(const std::filesystem::path& socket,
+                                   const CompileRequest& request);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace server
@@ -0,0 +1,183 @@
+#include <server/protocol.hpp>
+#include <server/server_error.hpp>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+
+namespace server {
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// A frame larger than this is not something a client would send
+constexpr uint32_t kMaxFrame = 64 << 20;
+
+void PutU32(std::string& out, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+void PutString(std::string& out, std::string_view str) {
+  PutU32(out, static_cast<uint32_t>(str.size()));
+  out.append(str);
+}
+
+class Reader {
+ public:
+  explicit Reader(std::string_view bytes) : bytes_{bytes} {
+  }
+
+  uint32_t U32() {
+    if (bytes_.size() < 4) {
+      throw errors::ProtocolError{"truncated"};
+    }
+
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+      value |= uint32_t{static_cast<unsigned char>(bytes_[i])} << (8 * i);
+    }
+
+    bytes_.remove_prefix(4);
+    return value;
+  }
+
+  std::string String() {
+    auto size = U32();
+    if (bytes_.size() < size) {
+      throw errors::ProtocolError{"truncated"};
+    }
+
+    std::string str{bytes_.substr(0, size)};
+    bytes_.remove_prefix(size);
+    return str;
+  }
+
+  void Finish() {
+    if (!bytes_.empty()) {
+      throw errors::ProtocolError{"trailing bytes"};
+    }
+  }
+
+ private:
+  std::string_view bytes_;
+};
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+std::string Encode(const CompileRequest& request) {
+  std::string out;
+  PutString(out, request.cwd);
+  PutU32(out, static_cast<uint32_t>(request.args.size()));
+  for (auto& arg : request.args) {
+    PutString(out, arg);
+  }
+  return out;
+}
+
+std::string Encode(const CompileResponse& response) {
+  std::string out;
+  PutU32(out, static_cast<uint32_t>(response.status));
+  PutString(out, response.output);
+  return out;
+}
+
+CompileRequest DecodeRequest(std::string_view payload) {
+  Reader reader{payload};
+
+  CompileRequest request;
+  request.cwd = reader.String();
+
+  auto count = reader.U32();
+  if (count > payload.size() / 4) {
+    throw errors::ProtocolError{"bad argument count"};
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    request.args.push_back(reader.String());
+  }
+
+  reader.Finish();
+  return request;
+}
+
+CompileResponse DecodeResponse(std::string_view payload) {
+  Reader reader{payload};
+
+  CompileResponse response;
+  response.status = static_cast<int>(reader.U32());
+  response.output = reader.String();
+
+  reader.Finish();
+  return response;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void SendFrame(int fd, std::string_view payload) {
+  std::string frame;
+  PutString(frame, payload);
+
+  std::string_view rest = frame;
+  while (!rest.empty()) {
+    // MSG_NOSIGNAL: a client that went away must not kill the server
+    auto written = ::send(fd, rest.data(), rest.size(), MSG_NOSIGNAL);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw errors::SocketError{"socket", "write to", errno};
+    }
+    rest.remove_prefix(static_cast<size_t>(written));
+  }
+}
+
+// False on EOF before the first byte
+static bool ReadExactly(int fd, char* data, size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    auto got = ::read(fd, data + done, size - done);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw errors::SocketError{"socket", "read from", errno};
+    }
+    if (got == 0) {
+      if (done == 0) {
+        return false;
+      }
+      throw errors::ProtocolError{"connection closed mid-frame"};
+    }
+    done += static_cast<size_t>(got);
+  }
+  return true;
+}
+
+std::optional<std::string> ReceiveFrame(int fd) {
+  char header[4];
+  if (!ReadExactly(fd, header, sizeof(header))) {
+    return std::nullopt;
+  }
+
+  auto size = Reader{{header, sizeof(header)}}.U32();
+  if (size > kMaxFrame) {
+    throw errors::ProtocolError{"frame too large"};
+  }
+
+  std::string payload(size, '\0');
+  if (size > 0 && !ReadExactly(fd, payload.data(), size)) {
+    throw errors::ProtocolError{"connection closed mid-frame"};
+  }
+
+  return payload;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace server
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string_view>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace server {
+
+//////////////////////////////////////////////////////////////////////
+
+// What a thin `etudec --server=<socket>` client sends to the compile
+// server, and gets back.
+//
+// Every message is one frame: a 4-byte little-endian length and the
+// payload. Strings inside a payload are length-prefixed the same way.
+
+struct CompileRequest {
+  std::string cwd;  // paths in `args` are relative to it
+  std::vector<std::string> args;
+
+  bool operator==(const CompileRequest&) const = default;
+};
+
+struct CompileResponse {
+  int status = 0;
+  std::string output;  // what `etudec` would print to stderr
+
+  bool operator==(const CompileResponse&) const = default;
+};
+
+std::string Encode(const CompileRequest& request);
+std::string Encode(const CompileResponse& response);
+
+// Throw errors::ProtocolError on truncated or trailing bytes
+CompileRequest DecodeRequest(std::string_view payload);
+CompileResponse DecodeResponse(std::string_view payload);
+
+//////////////////////////////////////////////////////////////////////
+
+// Blocking frame I/O on a connected socket; throw errors::SocketError
+
+void SendFrame(int fd, std::string_view payload);
+
+// std::nullopt if the peer closed the connection before a frame
+std::optional<std::string> ReceiveFrame(int fd);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace server
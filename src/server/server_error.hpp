@@ -0,0 +1,31 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <cstring>
+#include <string>
+
+namespace server::errors {
+
+struct ServerError : std::exception {
+  std::string message;
+
+  const char* what() const noexcept override {
+    return message.c_str();
+  }
+};
+
+struct SocketError : ServerError {
+  SocketError(const std::string& path, const std::string& what, int err) {
+    message = fmt::format("Could not {} {}: {}\n", what, path,
+                          std::strerror(err));
+  }
+};
+
+struct ProtocolError : ServerError {
+  ProtocolError(const std::string& what) {
+    message = fmt::format("Malformed compile server message: {}\n", what);
+  }
+};
+
+}  // namespace server::errors
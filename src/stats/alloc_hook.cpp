@@ -0,0 +1,152 @@
+#include <stats/stats.hpp>
+
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+
+//////////////////////////////////////////////////////////////////////
+
+#ifdef COMPILER_STATS
+
+namespace {
+
+// Plain thread-locals: no atomics on the allocation path,
+// phases read them from their own thread
+
+thread_local uint64_t alloc_bytes = 0;
+thread_local uint64_t alloc_count = 0;
+
+// Counts and allocates; null on failure. Aligned blocks come from
+// aligned_alloc, which std::free releases like the others.
+void* Allocate(std::size_t size) {
+  alloc_bytes += size;
+  alloc_count += 1;
+  return std::malloc(size ? size : 1);
+}
+
+void* Allocate(std::size_t size, std::align_val_t align) {
+  alloc_bytes += size;
+  alloc_count += 1;
+
+  // aligned_alloc wants a multiple of the alignment
+  auto alignment = static_cast<std::size_t>(align);
+  if (size > SIZE_MAX - alignment) {
+    return nullptr;
+  }
+  auto rounded = (size + alignment - 1) / alignment * alignment;
+  return std::aligned_alloc(alignment, rounded ? rounded : alignment);
+}
+
+template <typename... Align>
+void* AllocateOrThrow(std::size_t size, Align... align) {
+  if (void* ptr = Allocate(size, align...)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+}  // namespace
+
+// Every replaceable form: libstdc++ forwards most of them to the
+// plain ones, but that is not a guarantee, and the aligned forms go
+// to aligned_alloc directly
+
+void* operator new(std::size_t size) {
+  return AllocateOrThrow(size);
+}
+
+void* operator new[](std::size_t size) {
+  return AllocateOrThrow(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+  return AllocateOrThrow(size, align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+  return AllocateOrThrow(size, align);
+}
+
+void* operator new(std::size_t size, std::align_val_t align,
+                   const std::nothrow_t&) noexcept {
+  return Allocate(size, align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align,
+                     const std::nothrow_t&) noexcept {
+  return Allocate(size, align);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t,
+                       const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////
+
+namespace stats {
+
+AllocCounters ThreadAllocations() {
+#ifdef COMPILER_STATS
+  return {.bytes = alloc_bytes, .count = alloc_count};
+#else
+  return {};
+#endif
+}
+
+}  // namespace stats
@@ -0,0 +1,206 @@
+#include <stats/stats.hpp>
+
+#include <fmt/format.h>
+
+#include <atomic>
+
+namespace stats {
+
+//////////////////////////////////////////////////////////////////////
+
+const char* FormatPhase(Phase phase) {
+  switch (phase) {
+    case Phase::LEX:
+      return "lex";
+    case Phase::PARSE:
+      return "parse";
+    case Phase::SYMBOLS:
+      return "symbols";
+    case Phase::TYPECHECK:
+      return "typecheck";
+    case Phase::CODEGEN:
+      return "codegen";
+    case Phase::BACKEND:
+      return "backend";
+    default:
+      return "?";
+  }
+}
+
+const char* FormatCounter(Counter counter) {
+  switch (counter) {
+    case Counter::TOKENS:
+      return "tokens";
+    case Counter::AST_NODES:
+      return "ast_nodes";
+    case Counter::FUNCTIONS:
+      return "functions";
+    case Counter::INSTANTIATIONS:
+      return "instantiations";
+    case Counter::DEAD_FUNCTIONS:
+      return "dead_funs";
+    case Counter::DEAD_GLOBALS:
+      return "dead_globals";
+    default:
+      return "?";
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+constexpr size_t kPhases = static_cast<size_t>(Phase::PHASE_COUNT);
+constexpr size_t kCounters = static_cast<size_t>(Counter::COUNTER_COUNT);
+
+struct PhaseTotals {
+  std::atomic<uint64_t> ns{0};
+  std::atomic<uint64_t> entered{0};
+  std::atomic<uint64_t> alloc_bytes{0};
+  std::atomic<uint64_t> alloc_count{0};
+};
+
+PhaseTotals phases[kPhases];
+std::atomic<uint64_t> counters[kCounters];
+
+[[maybe_unused]] thread_local ScopedPhase* current = nullptr;
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+#ifdef COMPILER_STATS
+
+ScopedPhase::ScopedPhase(Phase phase) : phase_{phase}, parent_{current} {
+  if (parent_) {
+    parent_->Pause();
+  }
+
+  current = this;
+  phases[static_cast<size_t>(phase_)].entered.fetch_add(
+      1, std::memory_order_relaxed);
+
+  Resume();
+}
+
+ScopedPhase::~ScopedPhase() {
+  Pause();
+
+  current = parent_;
+  if (parent_) {
+    parent_->Resume();
+  }
+}
+
+void ScopedPhase::Resume() {
+  auto allocs = ThreadAllocations();
+  alloc_bytes_ = allocs.bytes;
+  alloc_count_ = allocs.count;
+  start_ = Clock::now();
+}
+
+void ScopedPhase::Pause() {
+  auto elapsed = Clock::now() - start_;
+  auto allocs = ThreadAllocations();
+
+  auto& totals = phases[static_cast<size_t>(phase_)];
+  totals.ns.fetch_add(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+      std::memory_order_relaxed);
+  totals.alloc_bytes.fetch_add(allocs.bytes - alloc_bytes_,
+                               std::memory_order_relaxed);
+  totals.alloc_count.fetch_add(allocs.count - alloc_count_,
+                               std::memory_order_relaxed);
+}
+
+void Count(Counter counter, uint64_t delta) {
+  counters[static_cast<size_t>(counter)].fetch_add(delta,
+                                                   std::memory_order_relaxed);
+}
+
+uint64_t Value(Counter counter) {
+  return counters[static_cast<size_t>(counter)].load();
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////
+
+std::string FormatTable() {
+  if (!kEnabled) {
+    return "Time report is not available: built without COMPILER_STATS\n";
+  }
+
+  uint64_t total_ns = 0;
+  for (auto& phase : phases) {
+    total_ns += phase.ns.load();
+  }
+
+  fmt::memory_buffer out;
+  auto it = std::back_inserter(out);
+
+  fmt::format_to(it, "===== Compilation time report =====\n");
+  fmt::format_to(it, "{:<12}{:>12}{:>8}{:>10}{:>12}{:>14}\n",  //
+                 "phase", "wall (ms)", "%", "entered", "allocs", "bytes");
+
+  for (size_t i = 0; i < kPhases; i++) {
+    auto& phase = phases[i];
+    double ms = phase.ns.load() / 1e6;
+    double percent = total_ns ? 100.0 * phase.ns.load() / total_ns : 0;
+
+    fmt::format_to(it, "{:<12}{:>12.3f}{:>7.1f}%{:>10}{:>12}{:>14}\n",
+                   FormatPhase(static_cast<Phase>(i)), ms, percent,
+                   phase.entered.load(), phase.alloc_count.load(),
+                   phase.alloc_bytes.load());
+  }
+
+  fmt::format_to(it, "{:<12}{:>12.3f}\n", "total", total_ns / 1e6);
+
+  for (size_t i = 0; i < kCounters; i++) {
+    fmt::format_to(it, "{:<12}{:>12}\n", FormatCounter(static_cast<Counter>(i)),
+                   counters[i].load());
+  }
+
+  return fmt::to_string(out);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+AllocCounters PhaseAllocations(Phase phase) {
+  auto& totals = phases[static_cast<size_t>(phase)];
+  return {totals.alloc_bytes.load(), totals.alloc_count.load()};
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::string FormatJson() {
+  fmt::memory_buffer out;
+  auto it = std::back_inserter(out);
+
+  fmt::format_to(it, "{{\"enabled\": {}, \"phases\": {{", kEnabled);
+
+  for (size_t i = 0; i < kPhases; i++) {
+    auto& phase = phases[i];
+    fmt::format_to(it,
+                   "{}\"{}\": {{\"ns\": {}, \"entered\": {}, "
+                   "\"allocs\": {}, \"bytes\": {}}}",
+                   i ? ", " : "", FormatPhase(static_cast<Phase>(i)),
+                   phase.ns.load(), phase.entered.load(),
+                   phase.alloc_count.load(), phase.alloc_bytes.load());
+  }
+
+  fmt::format_to(it, "}}, \"counters\": {{");
+
+  for (size_t i = 0; i < kCounters; i++) {
+    fmt::format_to(it, "{}\"{}\": {}", i ? ", " : "",
+                   FormatCounter(static_cast<Counter>(i)), counters[i].load());
+  }
+
+  fmt::format_to(it, "}}}}\n");
+
+  return fmt::to_string(out);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace stats
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace stats {
+
+//////////////////////////////////////////////////////////////////////
+
+// -ftime-report style instrumentation.
+//
+// Built with COMPILER_STATS (cmake -DCOMPILER_STATS=ON) the phases
+// below are timed, allocations made inside them are counted through
+// every form of the global operator new (array, nothrow, aligned),
+// and the counters are collected. Direct malloc calls are not seen.
+// Without it everything here is an empty inline function and
+// compiles down to nothing.
+
+#ifdef COMPILER_STATS
+inline constexpr bool kEnabled = true;
+#else
+inline constexpr bool kEnabled = false;
+#endif
+
+//////////////////////////////////////////////////////////////////////
+
+enum class Phase {
+  LEX,
+  PARSE,
+  SYMBOLS,
+  TYPECHECK,
+  CODEGEN,
+  BACKEND,  // qbe, assembler, linker
+  PHASE_COUNT,
+};
+
+const char* FormatPhase(Phase phase);
+
+enum class Counter {
+  TOKENS,
+  AST_NODES,
+  FUNCTIONS,
+  INSTANTIATIONS,  // specializations of generic functions lowered
+  DEAD_FUNCTIONS,  // unreachable from main and the exports, not lowered
+  DEAD_GLOBALS,
+  COUNTER_COUNT,
+};
+
+const char* FormatCounter(Counter counter);
+
+//////////////////////////////////////////////////////////////////////
+
+#ifdef COMPILER_STATS
+
+// Time and allocations are charged to the innermost phase only.
+// Open one around a whole unit of work (a file, a module), not an
+// item of it: each costs two clock reads. Lexing happens on demand
+// inside the parse, so it is part of PARSE; LEX is for lexing a
+// whole file on its own.
+
+class ScopedPhase {
+  using Clock = std::chrono::steady_clock;
+
+ public:
+  explicit ScopedPhase(Phase phase);
+  ~ScopedPhase();
+
+  ScopedPhase(const ScopedPhase&) = delete;
+  ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+ private:
+  void Pause();
+  void Resume();
+
+ private:
+  Phase phase_;
+  ScopedPhase* parent_;
+
+  Clock::time_point start_;
+  uint64_t alloc_bytes_ = 0;
+  uint64_t alloc_count_ = 0;
+};
+
+void Count(Counter counter, uint64_t delta = 1);
+
+uint64_t Value(Counter counter);
+
+#else
+
+class ScopedPhase {
+ public:
+  explicit ScopedPhase(Phase) {
+  }
+};
+
+inline void Count(Counter, uint64_t = 1) {
+}
+
+inline uint64_t Value(Counter) {
+  return 0;
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////
+
+// Human readable table, as printed for --time-report
+std::string FormatTable();
+
+// The same numbers for scripts, --time-report=json
+std::string FormatJson();
+
+//////////////////////////////////////////////////////////////////////
+
+// Allocations made by the calling thread so far (zeros when disabled)
+struct AllocCounters {
+  uint64_t bytes = 0;
+  uint64_t count = 0;
+};
+
+AllocCounters ThreadAllocations();
+
+// Allocations charged to `phase` so far, by all threads
+AllocCounters PhaseAllocations(Phase phase);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace stats
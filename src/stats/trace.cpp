@@ -0,0 +1,243 @@
+#include <stats/trace.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace stats {
+
+//////////////////////////////////////////////////////////////////////
+
+namespace detail {
+std::atomic<bool> tracing = false;
+}  // namespace detail
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+struct Event {
+  const char* category;
+  uint64_t start_ns;
+  uint64_t duration_ns;
+  char name[TraceScope::kMaxName + 1];
+};
+
+// Single producer (the owning thread), read only after it is done.
+// When full the oldest events are overwritten.
+
+class RingBuffer {
+ public:
+  static constexpr size_t kCapacity = 1 << 16;
+
+  explicit RingBuffer(size_t tid) : tid_{tid}, events_(kCapacity) {
+  }
+
+  void Clear() {
+    head_.store(0, std::memory_order_relaxed);
+    thread_name_.clear();
+  }
+
+  void Push(const Event& event) {
+    auto head = head_.load(std::memory_order_relaxed);
+    events_[head % kCapacity] = event;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  template <typename F>
+  void ForEach(F&& visit) const {
+    auto head = head_.load(std::memory_order_acquire);
+    auto count = std::min<uint64_t>(head, kCapacity);
+    for (auto i = head - count; i < head; i++) {
+      visit(events_[i % kCapacity]);
+    }
+  }
+
+  size_t tid_;
+  std::string thread_name_;
+
+ private:
+  std::atomic<uint64_t> head_{0};
+  std::vector<Event> events_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<RingBuffer>> buffers;
+
+  std::string path;
+  std::chrono::steady_clock::time_point start;
+};
+
+Registry& GetRegistry() {
+  // Leaked on purpose: threads may still record during static
+  // destruction, and the dump runs from an atexit handler
+  static auto registry = new Registry;
+  return *registry;
+}
+
+// Buffers outlive their threads: workers are usually gone by dump time
+RingBuffer& ThreadBuffer() {
+  thread_local RingBuffer* buffer = nullptr;
+
+  if (!buffer) {
+    auto& registry = GetRegistry();
+    std::lock_guard guard{registry.mutex};
+    registry.buffers.push_back(
+        std::make_unique<RingBuffer>(registry.buffers.size() + 1));
+    buffer = registry.buffers.back().get();
+  }
+
+  return *buffer;
+}
+
+uint64_t NowNs() {
+  auto elapsed = std::chrono::steady_clock::now() - GetRegistry().start;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+      .count();
+}
+
+void WriteJsonString(fmt::memory_buffer& out, std::string_view str) {
+  out.push_back('"');
+  for (char ch : str) {
+    if (ch == '"' || ch == '\\') {
+      out.push_back('\\');
+      out.push_back(ch);
+    } else if (static_cast<unsigned char>(ch) < 0x20) {
+      fmt::format_to(std::back_inserter(out), "\\u{:04x}", ch);
+    } else {
+      out.push_back(ch);
+    }
+  }
+  out.push_back('"');
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+void EnableTracing(std::string path) {
+  auto& registry = GetRegistry();
+  registry.path = std::move(path);
+  registry.start = std::chrono::steady_clock::now();
+
+  detail::tracing.store(true, std::memory_order_relaxed);
+
+  static bool registered = false;
+  if (!std::exchange(registered, true)) {
+    std::atexit([] {
+      if (TracingEnabled()) {
+        WriteTrace(GetRegistry().path);
+      }
+    });
+  }
+}
+
+void DisableTracing() {
+  detail::tracing.store(false, std::memory_order_relaxed);
+
+  auto& registry = GetRegistry();
+  std::lock_guard guard{registry.mutex};
+
+  // Threads keep their buffers: emptied, not freed
+  for (auto& buffer : registry.buffers) {
+    buffer->Clear();
+  }
+  registry.path.clear();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void SetThreadName(std::string_view name) {
+  if (TracingEnabled()) {
+    ThreadBuffer().thread_name_ = name;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void TraceScope::Begin(const char* category, std::string_view name) {
+  category_ = category;
+  CopyName(name);
+  start_ns_ = NowNs();
+}
+
+void TraceScope::CopyName(std::string_view name) {
+  auto length = std::min(name.size(), kMaxName);
+  std::memcpy(name_, name.data(), length);
+  name_[length] = '\0';
+}
+
+void TraceScope::End() {
+  Event event{
+      .category = category_,
+      .start_ns = start_ns_,
+      .duration_ns = NowNs() - start_ns_,
+      .name = {},
+  };
+  std::memcpy(event.name, name_, sizeof(name_));
+
+  ThreadBuffer().Push(event);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+bool WriteTrace(const std::string& path) {
+  auto& registry = GetRegistry();
+  std::lock_guard guard{registry.mutex};
+
+  fmt::memory_buffer out;
+  auto it = std::back_inserter(out);
+
+  fmt::format_to(it, "{{\"traceEvents\": [\n");
+
+  bool first = true;
+  auto separate = [&] {
+    fmt::format_to(it, "{}", first ? "  " : ",\n  ");
+    first = false;
+  };
+
+  for (auto& buffer : registry.buffers) {
+    if (!buffer->thread_name_.empty()) {
+      separate();
+      fmt::format_to(it,
+                     "{{\"name\": \"thread_name\", \"ph\": \"M\", "
+                     "\"pid\": 1, \"tid\": {}, \"args\": {{\"name\": ",
+                     buffer->tid_);
+      WriteJsonString(out, buffer->thread_name_);
+      fmt::format_to(it, "}}}}");
+    }
+
+    buffer->ForEach([&](const Event& event) {
+      separate();
+      fmt::format_to(it, "{{\"name\": ");
+      WriteJsonString(out, event.name[0] ? event.name : event.category);
+      fmt::format_to(it,
+                     ", \"cat\": \"{}\", \"ph\": \"X\", \"ts\": {:.3f}, "
+                     "\"dur\": {:.3f}, \"pid\": 1, \"tid\": {}}}",
+                     event.category, event.start_ns / 1e3,
+                     event.duration_ns / 1e3, buffer->tid_);
+    });
+  }
+
+  fmt::format_to(it, "\n]}}\n");
+
+  std::ofstream file{path};
+  file.write(out.data(), out.size());
+  return static_cast<bool>(file);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace stats
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string_view>
+#include <cstdint>
+#include <atomic>
+#include <string>
+
+namespace stats {
+
+//////////////////////////////////////////////////////////////////////
+
+// Chrome / Perfetto trace-event output (--trace=out.json).
+//
+// Every thread records into its own ring buffer, so there are no
+// locks or shared cache lines on the hot path. The buffers are dumped
+// at exit (or by `WriteTrace`), open the result in chrome://tracing
+// or ui.perfetto.dev.
+//
+// With tracing off a scope costs one check of a global flag that
+// never changes after startup. A scope reads it once, when it opens,
+// so one that opened with tracing off stays unrecorded even if
+// tracing is turned on before it closes.
+
+namespace detail {
+// Relaxed: it only decides whether to record, the buffers have their
+// own synchronization
+extern std::atomic<bool> tracing;
+}  // namespace detail
+
+inline bool TracingEnabled() {
+  return detail::tracing.load(std::memory_order_relaxed);
+}
+
+// Start recording; the trace goes to `path` at exit
+void EnableTracing(std::string path);
+
+// Stop recording and drop what was recorded: nothing is written at
+// exit. Recording threads must have finished by now.
+void DisableTracing();
+
+// Dump everything recorded so far; false if the file could not be
+// written. Recording threads must have finished by now.
+bool WriteTrace(const std::string& path);
+
+// Shown instead of the thread id in the viewer
+void SetThreadName(std::string_view name);
+
+//////////////////////////////////////////////////////////////////////
+
+// Records one complete ("X") event spanning its lifetime:
+//
+//   stats::TraceScope scope{"typecheck"};
+//   scope.SetName(fun->GetName());  // may be known only later
+//
+
+class TraceScope {
+ public:
+  explicit TraceScope(const char* category, std::string_view name = {})
+      : active_{TracingEnabled()} {
+    if (active_) [[unlikely]] {
+      Begin(category, name);
+    }
+  }
+
+  ~TraceScope() {
+    if (active_) [[unlikely]] {
+      End();
+    }
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+  void SetName(std::string_view name) {
+    if (active_) [[unlikely]] {
+      CopyName(name);
+    }
+  }
+
+ public:
+  static constexpr size_t kMaxName = 47;
+
+ private:
+  void Begin(const char* category, std::string_view name);
+  void End();
+  void CopyName(std::string_view name);
+
+ private:
+  bool active_;
+  const char* category_ = nullptr;
+  uint64_t start_ns_ = 0;
+  char name_[kMaxName + 1];
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace stats
@@ -0,0 +1,359 @@
+#include <x86/assembler.hpp>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+
+namespace x86 {
+
+//////////////////////////////////////////////////////////////////////
+
+static uint8_t Low(Reg reg) {
+  return static_cast<uint8_t>(reg) & 7;
+}
+
+static bool Extended(Reg reg) {
+  return static_cast<uint8_t>(reg) >= 8;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Assembler::Byte(uint8_t byte) {
+  code_.push_back(byte);
+}
+
+void Assembler::Int32(int32_t value) {
+  auto bits = static_cast<uint32_t>(value);
+  for (int i = 0; i < 4; i++) {
+    Byte((bits >> (8 * i)) & 0xFF);
+  }
+}
+
+void Assembler::PatchInt32(size_t offset, int32_t value) {
+  auto bits = static_cast<uint32_t>(value);
+  for (int i = 0; i < 4; i++) {
+    code_[offset + i] = (bits >> (8 * i)) & 0xFF;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Assembler::Rex(bool wide, Reg reg, Reg rm) {
+  Byte(0x40 | (wide << 3) | (Extended(reg) << 2) | Extended(rm));
+}
+
+void Assembler::ModRmReg(Reg reg, Reg rm) {
+  Byte(0xC0 | (Low(reg) << 3) | Low(rm));
+}
+
+void Assembler::ModRmMem(Reg reg, Reg base, int32_t disp) {
+  // Always mod = 10 (disp32): keeps rbp/r13 bases regular
+  Byte(0x80 | (Low(reg) << 3) | Low(base));
+
+  if (Low(base) == 4) {
+    // rsp/r12 as a base need a SIB byte
+    Byte(0x24);
+  }
+
+  Int32(disp);
+}
+
+void Assembler::AluOp(uint8_t opcode, Reg dst, Reg src) {
+  Rex(true, src, dst);
+  Byte(opcode);
+  ModRmReg(src, dst);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Assembler::BeginFunction(std::string_view name) {
+  functions_.push_back(Symbol{
+      .name = std::string{name},
+      .offset = code_.size(),
+  });
+}
+
+void Assembler::EndFunction() {
+  auto& function = functions_.back();
+  function.size = code_.size() - function.offset;
+}
+
+void Assembler::Prologue() {
+  Push(Reg::RBP);
+  MovRegReg(Reg::RBP, Reg::RSP);
+
+  // sub rsp, imm32
+  Rex(true, Reg::RAX, Reg::RSP);
+  Byte(0x81);
+  ModRmReg(Reg{5}, Reg::RSP);
+  frame_patch_ = code_.size();
+  Int32(0);
+}
+
+void Assembler::SetFrameSize(int32_t size) {
+  PatchInt32(frame_patch_, size);
+}
+
+void Assembler::Epilogue() {
+  MovRegReg(Reg::RSP, Reg::RBP);
+  Pop(Reg::RBP);
+  Ret();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Assembler::DefineData(std::string_view name, std::string_view bytes) {
+  data_symbols_.push_back(Symbol{
+      .name = std::string{name},
+      .offset = data_.size(),
+      .size = bytes.size(),
+  });
+  data_.insert(data_.end(), bytes.begin(), bytes.end());
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Assembler::MovRegReg(Reg dst, Reg src) {
+  AluOp(0x89, dst, src);
+}
+
+void Assembler::MovRegImm(Reg dst, int64_t imm) {
+  if (imm == static_cast<int32_t>(imm)) {
+    // mov r/m64, imm32 (sign-extended)
+    Rex(true, Reg::RAX, dst);
+    Byte(0xC7);
+    ModRmReg(Reg::RAX, dst);
+    Int32(static_cast<int32_t>(imm));
+    return;
+  }
+
+  // movabs r64, imm64
+  Rex(true, Reg::RAX, dst);
+  Byte(0xB8 + Low(dst));
+  auto bits = static_cast<uint64_t>(imm);
+  for (int i = 0; i < 8; i++) {
+    Byte((bits >> (8 * i)) & 0xFF);
+  }
+}
+
+void Assembler::Load(Reg dst, Reg base, int32_t disp) {
+  Rex(true, dst, base);
+  Byte(0x8B);
+  ModRmMem(dst, base, disp);
+}
+
+void Assembler::Store(Reg base, int32_t disp, Reg src) {
+  Rex(true, src, base);
+  Byte(0x89);
+  ModRmMem(src, base, disp);
+}
+
+void Assembler::Lea(Reg dst, Reg base, int32_t disp) {
+  Rex(true, dst, base);
+  Byte(0x8D);
+  ModRmMem(dst, base, disp);
+}
+
+void Assembler::LeaSymbol(Reg dst, std::string_view symbol) {
+  Rex(true, dst, Reg::RAX);
+  Byte(0x8D);
+  // mod = 00, rm = 101: [rip + disp32]
+  Byte((Low(dst) << 3) | 0x5);
+
+  relocations_.push_back(Relocation{
+      .kind = Relocation::Kind::DATA,
+      .offset = code_.size(),
+      .symbol = std::string{symbol},
+  });
+  Int32(0);
+}
+
+void Assembler::Push(Reg reg) {
+  if (Extended(reg)) {
+    Byte(0x41);
+  }
+  Byte(0x50 + Low(reg));
+}
+
+void Assembler::Pop(Reg reg) {
+  if (Extended(reg)) {
+    Byte(0x41);
+  }
+  Byte(0x58 + Low(reg));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Assembler::Add(Reg dst, Reg src) {
+  AluOp(0x01, dst, src);
+}
+
+void Assembler::Sub(Reg dst, Reg src) {
+  AluOp(0x29, dst, src);
+}
+
+void Assembler::And(Reg dst, Reg src) {
+  AluOp(0x21, dst, src);
+}
+
+void Assembler::Or(Reg dst, Reg src) {
+  AluOp(0x09, dst, src);
+}
+
+void Assembler::Xor(Reg dst, Reg src) {
+  AluOp(0x31, dst, src);
+}
+
+void Assembler::Cmp(Reg lhs, Reg rhs) {
+  AluOp(0x39, lhs, rhs);
+}
+
+void Assembler::Imul(Reg dst, Reg src) {
+  Rex(true, dst, src);
+  Byte(0x0F);
+  Byte(0xAF);
+  ModRmReg(dst, src);
+}
+
+void Assembler::Neg(Reg reg) {
+  Rex(true, Reg::RAX, reg);
+  Byte(0xF7);
+  ModRmReg(Reg{3}, reg);
+}
+
+void Assembler::Idiv(Reg src) {
+  // cqo
+  Byte(0x48);
+  Byte(0x99);
+
+  Rex(true, Reg::RAX, src);
+  Byte(0xF7);
+  ModRmReg(Reg{7}, src);
+}
+
+void Assembler::SetCond(Cond cond, Reg dst) {
+  // setcc dst8; the REX prefix selects sil/dil instead of dh/bh
+  Rex(false, Reg::RAX, dst);
+  Byte(0x0F);
+  Byte(0x90 + static_cast<uint8_t>(cond));
+  ModRmReg(Reg::RAX, dst);
+
+  // movzx dst, dst8
+  Rex(true, dst, dst);
+  Byte(0x0F);
+  Byte(0xB6);
+  ModRmReg(dst, dst);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+auto Assembler::NewLabel() -> Label {
+  labels_.push_back(kUnbound);
+  return Label{labels_.size() - 1};
+}
+
+void Assembler::Bind(Label label) {
+  labels_[label.id] = code_.size();
+
+  std::erase_if(fixups_, [&](const Fixup& fixup) {
+    if (fixup.label != label.id) {
+      return false;
+    }
+    PatchInt32(fixup.offset, code_.size() - fixup.base);
+    return true;
+  });
+}
+
+void Assembler::JumpTo(Label label, size_t base) {
+  // rel32 is relative to the end of the instruction by default
+  if (base == kUnbound) {
+    base = code_.size() + 4;
+  }
+
+  if (labels_[label.id] != kUnbound) {
+    Int32(labels_[label.id] - base);
+  } else {
+    fixups_.push_back(Fixup{code_.size(), label.id, base});
+    Int32(0);
+  }
+}
+
+void Assembler::Jmp(Label label) {
+  Byte(0xE9);
+  JumpTo(label);
+}
+
+void Assembler::JmpIf(Cond cond, Label label) {
+  Byte(0x0F);
+  Byte(0x80 + static_cast<uint8_t>(cond));
+  JumpTo(label);
+}
+
+void Assembler::JumpTable(Reg index, Reg scratch, int64_t first,
+                          std::span<const Label> targets, Label fallback) {
+  FMT_ASSERT(index != Reg::RSP, "rsp cannot be a SIB index");
+
+  if (first != 0) {
+    MovRegImm(scratch, first);
+    Sub(index, scratch);
+  }
+
+  // Unsigned: below `first` wraps around to a huge index
+  MovRegImm(scratch, targets.size());
+  Cmp(index, scratch);
+  JmpIf(Cond::ABOVE_EQUAL, fallback);
+
+  auto table = NewLabel();
+
+  // lea scratch, [rip + table]
+  Rex(true, scratch, Reg::RAX);
+  Byte(0x8D);
+  Byte(0x05 | (Low(scratch) << 3));
+  JumpTo(table);
+
+  // movsxd index, dword [scratch + index * 4 + 0]
+  Byte(0x48 | (Extended(index) << 2) | (Extended(index) << 1) |
+       Extended(scratch));
+  Byte(0x63);
+  Byte(0x44 | (Low(index) << 3));
+  Byte(0x80 | (Low(index) << 3) | Low(scratch));
+  Byte(0x00);
+
+  Add(scratch, index);
+
+  // jmp scratch
+  Rex(false, Reg::RAX, scratch);
+  Byte(0xFF);
+  ModRmReg(Reg{4}, scratch);
+
+  Bind(table);
+  auto base = code_.size();
+  for (auto target : targets) {
+    JumpTo(target, base);
+  }
+}
+
+void Assembler::Call(std::string_view symbol) {
+  Byte(0xE8);
+  relocations_.push_back(Relocation{
+      .kind = Relocation::Kind::CALL,
+      .offset = code_.size(),
+      .symbol = std::string{symbol},
+  });
+  Int32(0);
+}
+
+void Assembler::Ret() {
+  Byte(0xC3);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+const std::vector<uint8_t>& Assembler::Code() const {
+  FMT_ASSERT(fixups_.empty(), "Jump to a label that was never bound");
+  return code_;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace x86
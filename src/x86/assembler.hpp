@@ -0,0 +1,195 @@
+#pragma once
+
+#include <x86/registers.hpp>
+
+#include <string_view>
+#include <cstdint>
+#include <span>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace x86 {
+
+//////////////////////////////////////////////////////////////////////
+
+// Single-pass x86-64 machine code encoder.
+//
+// Only what a non-optimizing, stack-slot based code generator needs:
+// 64-bit moves between registers and [base + disp] slots, integer
+// arithmetic, comparisons, jumps to labels and calls by symbol name.
+// Calls and data references are recorded as relocations, resolved
+// by the linker (see `ElfWriter`) or by a loader in memory.
+
+class Assembler {
+ public:
+  struct Label {
+    size_t id;
+  };
+
+  struct Symbol {
+    std::string name;
+    size_t offset = 0;
+    size_t size = 0;
+  };
+
+  struct Relocation {
+    enum class Kind {
+      CALL,  // rel32 of `call`, R_X86_64_PLT32
+      DATA,  // rel32 of rip-relative `lea`, R_X86_64_PC32
+    };
+
+    Kind kind;
+
+    // Where the rel32 lives in the code
+    size_t offset = 0;
+
+    std::string symbol;
+    int64_t addend = -4;
+  };
+
+  ////////////////////////////////////////////////////////////////////
+
+  // Functions
+
+  void BeginFunction(std::string_view name);
+  void EndFunction();
+
+  // push rbp; mov rbp, rsp; sub rsp, <patched later>
+  void Prologue();
+
+  // The frame size is only known once the body has been emitted
+  void SetFrameSize(int32_t size);
+
+  // mov rsp, rbp; pop rbp; ret
+  void Epilogue();
+
+  ////////////////////////////////////////////////////////////////////
+
+  // Read-only data, e.g. string literals
+
+  void DefineData(std::string_view name, std::string_view bytes);
+
+  ////////////////////////////////////////////////////////////////////
+
+  void MovRegReg(Reg dst, Reg src);
+  void MovRegImm(Reg dst, int64_t imm);
+
+  // mov dst, [base + disp]
+  void Load(Reg dst, Reg base, int32_t disp);
+
+  // mov [base + disp], src
+  void Store(Reg base, int32_t disp, Reg src);
+
+  // lea dst, [base + disp]
+  void Lea(Reg dst, Reg base, int32_t disp);
+
+  // lea dst, [rip + symbol]
+  void LeaSymbol(Reg dst, std::string_view symbol);
+
+  void Push(Reg reg);
+  void Pop(Reg reg);
+
+  ////////////////////////////////////////////////////////////////////
+
+  void Add(Reg dst, Reg src);
+  void Sub(Reg dst, Reg src);
+  void Imul(Reg dst, Reg src);
+  void And(Reg dst, Reg src);
+  void Or(Reg dst, Reg src);
+  void Xor(Reg dst, Reg src);
+  void Neg(Reg reg);
+
+  // rdx:rax / src -> rax, rdx (sign-extends rax first)
+  void Idiv(Reg src);
+
+  // Flags from `lhs - rhs`
+  void Cmp(Reg lhs, Reg rhs);
+
+  // dst = cond ? 1 : 0
+  void SetCond(Cond cond, Reg dst);
+
+  ////////////////////////////////////////////////////////////////////
+
+  Label NewLabel();
+  void Bind(Label label);
+
+  void Jmp(Label label);
+  void JmpIf(Cond cond, Label label);
+
+  // Dense switch: jumps to targets[index - first], or to `fallback`
+  // when the index is out of range. The table of rel32 offsets is
+  // placed in the code right after the indirect jump.
+  // Clobbers `index` and `scratch`.
+  void JumpTable(Reg index, Reg scratch, int64_t first,
+                 std::span<const Label> targets, Label fallback);
+
+  void Call(std::string_view symbol);
+  void Ret();
+
+  ////////////////////////////////////////////////////////////////////
+
+  // All the labels must be bound by now
+  const std::vector<uint8_t>& Code() const;
+
+  const std::vector<uint8_t>& Data() const {
+    return data_;
+  }
+
+  const std::vector<Symbol>& Functions() const {
+    return functions_;
+  }
+
+  const std::vector<Symbol>& DataSymbols() const {
+    return data_symbols_;
+  }
+
+  const std::vector<Relocation>& Relocations() const {
+    return relocations_;
+  }
+
+ private:
+  void Byte(uint8_t byte);
+  void Int32(int32_t value);
+  void PatchInt32(size_t offset, int32_t value);
+
+  void Rex(bool wide, Reg reg, Reg rm);
+
+  // reg, [base + disp32]
+  void ModRmMem(Reg reg, Reg base, int32_t disp);
+  void ModRmReg(Reg reg, Reg rm);
+
+  // Most two-operand ALU ops: opcode /r with `rm` = dst
+  void AluOp(uint8_t opcode, Reg dst, Reg src);
+
+  // rel32 to `label`, counted from `base` (end of the field if -1)
+  void JumpTo(Label label, size_t base = kUnbound);
+
+ private:
+  std::vector<uint8_t> code_;
+  std::vector<uint8_t> data_;
+
+  std::vector<Symbol> functions_;
+  std::vector<Symbol> data_symbols_;
+  std::vector<Relocation> relocations_;
+
+  static constexpr size_t kUnbound = SIZE_MAX;
+
+  struct Fixup {
+    size_t offset;
+    size_t label;
+
+    // The rel32 is `label - base`
+    size_t base;
+  };
+
+  std::vector<size_t> labels_;
+  std::vector<Fixup> fixups_;
+
+  // Where `sub rsp, imm32` of the current function keeps its imm32
+  size_t frame_patch_ = 0;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace x86
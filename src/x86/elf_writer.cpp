@@ -0,0 +1,226 @@
+#include <x86/elf_writer.hpp>
+
+#include <elf.h>
+
+#include <unordered_map>
+#include <fstream>
+#include <cerrno>
+
+namespace x86 {
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+enum SectionIndex : uint16_t {
+  NULL_SECTION,
+  TEXT,
+  RODATA,
+  RELA_TEXT,
+  SYMTAB,
+  STRTAB,
+  SHSTRTAB,
+  NOTE_GNU_STACK,
+  SECTION_COUNT,
+};
+
+class StringTable {
+ public:
+  StringTable() {
+    bytes_.push_back('\0');
+  }
+
+  uint32_t Add(std::string_view str) {
+    uint32_t offset = bytes_.size();
+    bytes_.insert(bytes_.end(), str.begin(), str.end());
+    bytes_.push_back('\0');
+    return offset;
+  }
+
+  const std::vector<uint8_t>& Bytes() const {
+    return bytes_;
+  }
+
+ private:
+  std::vector<uint8_t> bytes_;
+};
+
+template <typename T>
+void Put(std::vector<uint8_t>& out, const T& value) {
+  auto bytes = reinterpret_cast<const uint8_t*>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+void Align(std::vector<uint8_t>& out, size_t align) {
+  out.resize((out.size() + align - 1) / align * align);
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+std::vector<uint8_t> ElfWriter::Serialize() const {
+  auto& code = assembler_.Code();
+  auto& data = assembler_.Data();
+
+  StringTable strtab;
+  std::vector<Elf64_Sym> symbols(1);  // index 0 is reserved
+  std::unordered_map<std::string_view, uint32_t> symbol_index;
+
+  // Locals go first: sh_info of .symtab points past them
+
+  for (auto& sym : assembler_.DataSymbols()) {
+    symbol_index[sym.name] = symbols.size();
+    symbols.push_back(Elf64_Sym{
+        .st_name = strtab.Add(sym.name),
+        .st_info = ELF64_ST_INFO(STB_LOCAL, STT_OBJECT),
+        .st_other = STV_DEFAULT,
+        .st_shndx = RODATA,
+        .st_value = sym.offset,
+        .st_size = sym.size,
+    });
+  }
+
+  uint32_t first_global = symbols.size();
+
+  for (auto& sym : assembler_.Functions()) {
+    symbol_index[sym.name] = symbols.size();
+    symbols.push_back(Elf64_Sym{
+        .st_name = strtab.Add(sym.name),
+        .st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC),
+        .st_other = STV_DEFAULT,
+        .st_shndx = TEXT,
+        .st_value = sym.offset,
+        .st_size = sym.size,
+    });
+  }
+
+  std::vector<Elf64_Rela> relocations;
+
+  for (auto& reloc : assembler_.Relocations()) {
+    auto [it, undefined] =
+        symbol_index.try_emplace(reloc.symbol, symbols.size());
+
+    if (undefined) {
+      symbols.push_back(Elf64_Sym{
+          .st_name = strtab.Add(reloc.symbol),
+          .st_info = ELF64_ST_INFO(STB_GLOBAL, STT_NOTYPE),
+          .st_other = STV_DEFAULT,
+          .st_shndx = SHN_UNDEF,
+          .st_value = 0,
+          .st_size = 0,
+      });
+    }
+
+    auto type = reloc.kind == Assembler::Relocation::Kind::CALL
+                    ? R_X86_64_PLT32
+                    : R_X86_64_PC32;
+
+    relocations.push_back(Elf64_Rela{
+        .r_offset = reloc.offset,
+        .r_info = ELF64_R_INFO(it->second, type),
+        .r_addend = reloc.addend,
+    });
+  }
+
+  ////////////////////////////////////////////////////////////////////
+
+  StringTable shstrtab;
+  Elf64_Shdr headers[SECTION_COUNT] = {};
+
+  std::vector<uint8_t> out(sizeof(Elf64_Ehdr));
+
+  auto place = [&](SectionIndex index, const char* name, uint32_t type,
+                   const void* bytes, size_t size, size_t align) {
+    Align(out, align);
+
+    auto& header = headers[index];
+    header.sh_name = shstrtab.Add(name);
+    header.sh_type = type;
+    header.sh_offset = out.size();
+    header.sh_size = size;
+    header.sh_addralign = align;
+
+    auto begin = static_cast<const uint8_t*>(bytes);
+    out.insert(out.end(), begin, begin + size);
+  };
+
+  place(TEXT, ".text", SHT_PROGBITS, code.data(), code.size(), 16);
+  headers[TEXT].sh_flags = SHF_ALLOC | SHF_EXECINSTR;
+
+  place(RODATA, ".rodata", SHT_PROGBITS, data.data(), data.size(), 8);
+  headers[RODATA].sh_flags = SHF_ALLOC;
+
+  place(RELA_TEXT, ".rela.text", SHT_RELA, relocations.data(),
+        relocations.size() * sizeof(Elf64_Rela), 8);
+  headers[RELA_TEXT].sh_flags = SHF_INFO_LINK;
+  headers[RELA_TEXT].sh_link = SYMTAB;
+  headers[RELA_TEXT].sh_info = TEXT;
+  headers[RELA_TEXT].sh_entsize = sizeof(Elf64_Rela);
+
+  place(SYMTAB, ".symtab", SHT_SYMTAB, symbols.data(),
+        symbols.size() * sizeof(Elf64_Sym), 8);
+  headers[SYMTAB].sh_link = STRTAB;
+  headers[SYMTAB].sh_info = first_global;
+  headers[SYMTAB].sh_entsize = sizeof(Elf64_Sym);
+
+  place(STRTAB, ".strtab", SHT_STRTAB, strtab.Bytes().data(),
+        strtab.Bytes().size(), 1);
+
+  // Marks the stack as non-executable for the linker
+  place(NOTE_GNU_STACK, ".note.GNU-stack", SHT_PROGBITS, nullptr, 0, 1);
+
+  // Its own name has to be in the table before the table is copied
+  auto shstrtab_name = shstrtab.Add(".shstrtab");
+  auto& names = shstrtab.Bytes();
+  headers[SHSTRTAB].sh_name = shstrtab_name;
+  headers[SHSTRTAB].sh_type = SHT_STRTAB;
+  headers[SHSTRTAB].sh_offset = out.size();
+  headers[SHSTRTAB].sh_size = names.size();
+  headers[SHSTRTAB].sh_addralign = 1;
+  out.insert(out.end(), names.begin(), names.end());
+
+  ////////////////////////////////////////////////////////////////////
+
+  Align(out, 8);
+  size_t section_headers = out.size();
+  for (auto& header : headers) {
+    Put(out, header);
+  }
+
+  Elf64_Ehdr elf{};
+  std::memcpy(elf.e_ident, ELFMAG, SELFMAG);
+  elf.e_ident[EI_CLASS] = ELFCLASS64;
+  elf.e_ident[EI_DATA] = ELFDATA2LSB;
+  elf.e_ident[EI_VERSION] = EV_CURRENT;
+  elf.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+  elf.e_type = ET_REL;
+  elf.e_machine = EM_X86_64;
+  elf.e_version = EV_CURRENT;
+  elf.e_shoff = section_headers;
+  elf.e_ehsize = sizeof(Elf64_Ehdr);
+  elf.e_shentsize = sizeof(Elf64_Shdr);
+  elf.e_shnum = SECTION_COUNT;
+  elf.e_shstrndx = SHSTRTAB;
+
+  std::memcpy(out.data(), &elf, sizeof(elf));
+
+  return out;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void ElfWriter::WriteTo(const std::string& path) const {
+  auto bytes = Serialize();
+
+  std::ofstream file{path, std::ios::binary};
+  file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+
+  if (!file) {
+    throw errors::ElfWriteError{path, errno};
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace x86
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <x86/assembler.hpp>
+
+#include <fmt/core.h>
+
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <string>
+
+namespace x86 {
+
+//////////////////////////////////////////////////////////////////////
+
+namespace errors {
+
+struct ElfWriteError : std::exception {
+  std::string message;
+
+  ElfWriteError(const std::string& path, int err) {
+    message = fmt::format("Could not write object file {}: {}\n", path,
+                          std::strerror(err));
+  }
+
+  const char* what() const noexcept override {
+    return message.c_str();
+  }
+};
+
+}  // namespace errors
+
+//////////////////////////////////////////////////////////////////////
+
+// Packs the output of an `Assembler` into an ELF64 relocatable object
+// (what `cc -c` would produce), ready for the system linker:
+//
+//   .text       functions, global
+//   .rodata     data, local to the object
+//   .rela.text  calls and data references
+//
+// Symbols referenced but not defined become undefined globals
+// (e.g. `printf`), to be resolved at link time.
+
+class ElfWriter {
+ public:
+  explicit ElfWriter(const Assembler& assembler) : assembler_{assembler} {
+  }
+
+  std::vector<uint8_t> Serialize() const;
+
+  void WriteTo(const std::string& path) const;
+
+ private:
+  const Assembler& assembler_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace x86
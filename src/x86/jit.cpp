@@ -0,0 +1,204 @@
+#include <x86/jit.hpp>
+
+#include <sys/mman.h>
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace x86 {
+
+//////////////////////////////////////////////////////////////////////
+
+Jit::Jit(size_t capacity) : capacity_{capacity} {
+  // Everything has to be in reach of a rel32
+  FMT_ASSERT(capacity_ < (size_t{1} << 31), "JIT region is too large");
+
+  void* region = ::mmap(nullptr, capacity_, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (region == MAP_FAILED) {
+    throw errors::JitError{"could not map the code region"};
+  }
+
+  base_ = static_cast<uint8_t*>(region);
+}
+
+Jit::~Jit() {
+  ::munmap(base_, capacity_);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void* Jit::Lookup(std::string_view name) const {
+  auto it = functions_.find(std::string{name});
+  return it == functions_.end() ? nullptr : it->second;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+uint8_t* Jit::Reserve(size_t size, size_t align) {
+  size_t begin = (used_ + align - 1) / align * align;
+  if (begin + size > capacity_) {
+    throw errors::JitError{"out of code memory"};
+  }
+  used_ = begin + size;
+  return base_ + begin;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Jit::WriteStub(uint8_t* stub, void* address) {
+  // jmp [rip + 0]; .quad address
+  const uint8_t jmp[] = {0xFF, 0x25, 0, 0, 0, 0};
+  std::memcpy(stub, jmp, sizeof(jmp));
+  std::memcpy(stub + sizeof(jmp), &address, sizeof(address));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Jit::PatchRel32(uint8_t* rel32, const uint8_t* target) {
+  int32_t offset = target - (rel32 + 4);
+  std::memcpy(rel32, &offset, sizeof(offset));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Jit::SetWritable(bool writable) {
+  // W^X: the region is never writable and executable at once
+  int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC;
+  if (::mprotect(base_, capacity_, prot) != 0) {
+    throw errors::JitError{"could not change code protection"};
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Jit::Load(const Assembler& assembler) {
+  SetWritable(true);
+
+  try {
+    Link(assembler);
+  } catch (...) {
+    SetWritable(false);
+    throw;
+  }
+
+  SetWritable(false);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Jit::Link(const Assembler& assembler) {
+  auto& code = assembler.Code();
+  auto& data = assembler.Data();
+
+  // Resolve everything first and only then touch what is loaded: an
+  // undefined symbol must not leave some functions redefined. Until
+  // then the only change is the reserved space, given back on failure.
+  auto mark = used_;
+
+  struct Patch {
+    uint8_t* site;
+    const uint8_t* target;
+    const std::string* callee;  // JIT function, repatched on redefinition
+  };
+
+  struct Stub {
+    const std::string* name;
+    uint8_t* stub;
+    void* address;
+  };
+
+  uint8_t* text = nullptr;
+  uint8_t* rodata = nullptr;
+
+  std::unordered_map<std::string_view, uint8_t*> defined;
+  std::unordered_map<std::string_view, uint8_t*> new_stubs;
+  std::vector<Stub> stubs;
+  std::vector<Patch> patches;
+
+  try {
+    text = Reserve(code.size(), 16);
+    rodata = Reserve(data.size(), 16);
+
+    // The functions of this load first, they may call each other in
+    // any order and win over older ones of the same name
+    for (auto& function : assembler.Functions()) {
+      defined[function.name] = text + function.offset;
+    }
+
+    for (auto& reloc : assembler.Relocations()) {
+      auto site = text + reloc.offset;
+
+      if (reloc.kind == Assembler::Relocation::Kind::DATA) {
+        auto& symbols = assembler.DataSymbols();
+        auto it = std::find_if(symbols.begin(), symbols.end(),
+                               [&](auto& sym) {
+                                 return sym.name == reloc.symbol;
+                               });
+        if (it == symbols.end()) {
+          throw errors::JitError{
+              fmt::format("undefined data symbol {}", reloc.symbol)};
+        }
+        patches.push_back({site, rodata + it->offset, nullptr});
+        continue;
+      }
+
+      if (auto it = defined.find(reloc.symbol); it != defined.end()) {
+        patches.push_back({site, it->second, &reloc.symbol});
+      } else if (auto it = functions_.find(reloc.symbol);
+                 it != functions_.end()) {
+        patches.push_back({site, it->second, &reloc.symbol});
+      } else if (auto it = stubs_.find(reloc.symbol); it != stubs_.end()) {
+        patches.push_back({site, it->second, nullptr});
+      } else if (auto it = new_stubs.find(reloc.symbol);
+                 it != new_stubs.end()) {
+        patches.push_back({site, it->second, nullptr});
+      } else {
+        void* address = ::dlsym(RTLD_DEFAULT, reloc.symbol.c_str());
+        if (address == nullptr) {
+          throw errors::JitError{
+              fmt::format("undefined symbol {}", reloc.symbol)};
+        }
+
+        auto stub = Reserve(kStubSize, 16);
+        stubs.push_back({&reloc.symbol, stub, address});
+        new_stubs.emplace(reloc.symbol, stub);
+        patches.push_back({site, stub, nullptr});
+      }
+    }
+  } catch (...) {
+    used_ = mark;
+    throw;
+  }
+
+  // Commit
+
+  std::memcpy(text, code.data(), code.size());
+  std::memcpy(rodata, data.data(), data.size());
+
+  for (auto& [name, stub, address] : stubs) {
+    WriteStub(stub, address);
+    stubs_.emplace(*name, stub);
+  }
+
+  for (auto& function : assembler.Functions()) {
+    auto address = text + function.offset;
+    functions_[function.name] = address;
+
+    for (auto site : call_sites_[function.name]) {
+      PatchRel32(site, address);
+    }
+  }
+
+  for (auto& [site, target, callee] : patches) {
+    PatchRel32(site, target);
+    if (callee) {
+      call_sites_[*callee].push_back(site);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace x86
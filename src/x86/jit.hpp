@@ -0,0 +1,103 @@
+#pragma once
+
+#include <x86/assembler.hpp>
+
+#include <fmt/core.h>
+
+#include <unordered_map>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace x86 {
+
+//////////////////////////////////////////////////////////////////////
+
+namespace errors {
+
+struct JitError : std::exception {
+  std::string message;
+
+  JitError(const std::string& what) {
+    message = fmt::format("JIT: {}\n", what);
+  }
+
+  const char* what() const noexcept override {
+    return message.c_str();
+  }
+};
+
+}  // namespace errors
+
+//////////////////////////////////////////////////////////////////////
+
+// Loads the output of an `Assembler` straight into executable memory,
+// no object files, no external tools. Meant for the REPL:
+//
+//   Jit jit;
+//   jit.Load(assembler);  // fun twice(x) { ... }
+//   auto twice = jit.Get<long(long)>("twice");
+//   twice(21);
+//
+// Functions stay resident between loads. Loading a function with
+// a name that is already taken redefines it: every call site loaded
+// so far is patched to jump to the new body.
+//
+// Calls to functions outside the JIT (e.g. `printf`) are looked up
+// with dlsym and go through a small absolute-jump stub, since
+// the target may be too far away for a rel32.
+//
+// A load either happens as a whole or not at all: if a symbol is
+// undefined or the region is full, it throws and every function
+// loaded before stays as it was.
+
+class Jit {
+ public:
+  explicit Jit(size_t capacity = 64 << 20);
+
+  Jit(const Jit&) = delete;
+  Jit& operator=(const Jit&) = delete;
+
+  ~Jit();
+
+  void Load(const Assembler& assembler);
+
+  // nullptr if there is no such function
+  void* Lookup(std::string_view name) const;
+
+  template <typename Fn>
+  Fn* Get(std::string_view name) const {
+    return reinterpret_cast<Fn*>(Lookup(name));
+  }
+
+ private:
+  // Copy in and resolve relocations, the region is writable
+  void Link(const Assembler& assembler);
+
+  uint8_t* Reserve(size_t size, size_t align);
+
+  static constexpr size_t kStubSize = 14;
+
+  static void WriteStub(uint8_t* stub, void* address);
+
+  void PatchRel32(uint8_t* rel32, const uint8_t* target);
+
+  void SetWritable(bool writable);
+
+ private:
+  uint8_t* base_ = nullptr;
+  size_t capacity_ = 0;
+  size_t used_ = 0;
+
+  std::unordered_map<std::string, uint8_t*> functions_;
+  std::unordered_map<std::string, uint8_t*> stubs_;
+
+  // Every rel32 of a `call` into a JIT function, by callee name
+  std::unordered_map<std::string, std::vector<uint8_t*>> call_sites_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace x86
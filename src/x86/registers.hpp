@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+namespace x86 {
+
+//////////////////////////////////////////////////////////////////////
+
+// Numbering matches the hardware encoding
+
+enum class Reg : uint8_t {
+  RAX,
+  RCX,
+  RDX,
+  RBX,
+  RSP,
+  RBP,
+  RSI,
+  RDI,
+  R8,
+  R9,
+  R10,
+  R11,
+  R12,
+  R13,
+  R14,
+  R15,
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Condition codes for jcc / setcc
+
+enum class Cond : uint8_t {
+  BELOW = 0x2,
+  ABOVE_EQUAL = 0x3,
+  EQUAL = 0x4,
+  NOT_EQUAL = 0x5,
+  BELOW_EQUAL = 0x6,
+  ABOVE = 0x7,
+  LESS = 0xC,
+  GREATER_EQUAL = 0xD,
+  LESS_EQUAL = 0xE,
+  GREATER = 0xF,
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// System V AMD64 calling convention
+
+inline constexpr Reg kArgRegs[] = {
+    Reg::RDI, Reg::RSI, Reg::RDX, Reg::RCX, Reg::R8, Reg::R9,
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace x86
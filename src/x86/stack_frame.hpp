@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace x86 {
+
+//////////////////////////////////////////////////////////////////////
+
+// Hands out rbp-relative stack slots for one function.
+// No reuse, no register allocation: every local gets its own slot.
+
+class StackFrame {
+ public:
+  // Returns the (negative) offset from rbp
+  int32_t Allocate(size_t size, size_t align = 8) {
+    size_ = (size_ + size + align - 1) / align * align;
+    return -static_cast<int32_t>(size_);
+  }
+
+  // What `sub rsp, N` has to reserve: keeps rsp 16-byte aligned
+  // at call sites (the return address and saved rbp make 16)
+  int32_t FrameSize() const {
+    return static_cast<int32_t>((size_ + 15) / 16 * 16);
+  }
+
+ private:
+  size_t size_ = 0;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace x86
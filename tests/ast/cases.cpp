@@ -0,0 +1,281 @@
+#include <ast/visitors/return_visitor.hpp>
+#include <ast/visitors/post_order.hpp>
+#include <ast/flat_fold.hpp>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+#include <string_view>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <vector>
+#include <array>
+
+//////////////////////////////////////////////////////////////////////
+
+// The real node classes are filled in by the course tasks; these
+// stand-ins only have what the traversals need
+
+class SumVisitor;
+
+struct Num : TreeNode {
+  explicit Num(int64_t value) : value{value} {
+  }
+
+  void Accept(Visitor* visitor) override;
+
+  lex::Location GetLocation() override {
+    return {};
+  }
+
+  int64_t value;
+};
+
+struct Add : TreeNode {
+  Add(TreeNode* lhs, TreeNode* rhs) : lhs{lhs}, rhs{rhs} {
+    alive += 1;
+  }
+
+  ~Add() override {
+    alive -= 1;
+  }
+
+  void Accept(Visitor* visitor) override;
+
+  lex::Location GetLocation() override {
+    return {};
+  }
+
+  void AppendChildren(std::vector<TreeNode*>& children) override {
+    children.push_back(lhs);
+    children.push_back(rhs);
+  }
+
+  static inline size_t alive = 0;
+
+  TreeNode* lhs;
+  TreeNode* rhs;
+};
+
+class SumVisitor : public ReturnVisitor<int64_t> {
+ public:
+  void VisitNum(Num* num) {
+    visits += 1;
+    return_value = num->value;
+  }
+
+  void VisitAdd(Add* add) {
+    visits += 1;
+    return_value = Eval(add->lhs) + Eval(add->rhs);
+  }
+
+  size_t visits = 0;
+};
+
+void Num::Accept(Visitor* visitor) {
+  static_cast<SumVisitor*>(visitor)->VisitNum(this);
+}
+
+void Add::Accept(Visitor* visitor) {
+  static_cast<SumVisitor*>(visitor)->VisitAdd(this);
+}
+
+// ((((1 + 2) + 3) + ...) + n), left-leaning like a long `+` chain
+static TreeNode* Chain(size_t n) {
+  TreeNode* tree = new Num{1};
+  for (size_t i = 2; i <= n; i++) {
+    tree = new Add{tree, new Num{static_cast<int64_t>(i)}};
+  }
+  return tree;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Post-order: order and shape", "[ast]") {
+  auto tree = new Add{new Add{new Num{1}, new Num{2}}, new Num{3}};
+
+  std::vector<int64_t> order;
+  ForEachPostOrder(tree, [&](TreeNode* node) {
+    if (auto num = dynamic_cast<Num*>(node)) {
+      order.push_back(num->value);
+    } else {
+      order.push_back(0);
+    }
+  });
+
+  CHECK(order == std::vector<int64_t>{1, 2, 0, 3, 0});
+
+  SumVisitor sum;
+  CHECK(sum.Eval(tree) == 6);
+  CHECK(sum.EvalIteratively(tree) == 6);
+  CHECK(sum.visits == 10);  // five nodes, once each way
+
+  DestroyTree(tree);
+  CHECK(Add::alive == 0);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Post-order: deep trees", "[ast]") {
+  static constexpr size_t kDepth = 200'000;
+
+  auto tree = Chain(kDepth);
+
+  size_t nodes = 0;
+  ForEachPostOrder(tree, [&](TreeNode*) {
+    nodes += 1;
+  });
+  CHECK(nodes == 2 * kDepth - 1);
+
+  SumVisitor sum;
+  CHECK(sum.EvalIteratively(tree) ==
+        static_cast<int64_t>(kDepth * (kDepth + 1) / 2));
+  CHECK(sum.visits == 2 * kDepth - 1);
+
+  // The memo is gone: plain Eval works as before
+  auto small = Chain(3);
+  CHECK(sum.Eval(small) == 6);
+
+  DestroyTree(tree);
+  DestroyTree(small);
+  CHECK(Add::alive == 0);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Flat tree: layout", "[ast]") {
+  FlatTree tree;
+
+  // fun f(x) { g(x, 2); if x < 1 { 3 } }
+  auto x = tree.AddVar("x");
+  auto two = tree.AddInt(2);
+  auto g = tree.AddVar("g");
+  auto call = tree.AddCall(g, std::array{x, two});
+  auto stmt = tree.AddExprStatement(call);
+  auto cond = tree.AddBinary(FlatOp::LT, tree.AddVar("x"), tree.AddInt(1));
+  auto branch = tree.AddIf(cond, tree.AddInt(3), kNoNode);
+  auto body = tree.AddBlock(std::array{stmt, branch});
+  auto fun = tree.AddFunDecl("f", std::array<std::string_view, 1>{"x"}, body,
+                             {.lineno = 4, .columnno = 0});
+
+  CHECK(tree.Kind(cond) == FlatKind::COMPARISON);
+  CHECK(tree.Op(cond) == FlatOp::LT);
+  CHECK(tree.Name(fun) == "f");
+  CHECK(tree.Params(fun) == std::vector<std::string_view>{"x"});
+  CHECK(tree.Body(fun) == body);
+  CHECK(tree.GetLocation(fun).lineno == 4);
+  CHECK(tree.Else(branch) == kNoNode);
+
+  auto args = tree.List(call);
+  CHECK(std::vector(args.begin(), args.end()) ==
+        std::vector<FlatIndex>{x, two});
+
+  std::vector<FlatIndex> children;
+  tree.ForEachChild(call, [&](FlatIndex child) {
+    children.push_back(child);
+  });
+  CHECK(children == std::vector<FlatIndex>{g, x, two});
+  CHECK(tree.CountChildren(branch) == 2);
+
+  // Every child comes before its parent
+  for (FlatIndex i = 0; i < tree.Size(); i++) {
+    tree.ForEachChild(i, [&](FlatIndex child) {
+      CHECK(child < i);
+    });
+  }
+
+  // Names are the tree's own, whatever held them before
+  auto spelling = std::make_unique<std::string>("counter");
+  auto counter = tree.AddVar(*spelling);
+  spelling.reset();
+  CHECK(tree.Name(counter) == "counter");
+  CHECK(tree.Name(fun) == "f");
+
+  CHECK(tree.Int(tree.AddInt(INT64_MIN)) == INT64_MIN);
+  CHECK(tree.Int(tree.AddInt(-2)) == -2);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Flat tree: folding", "[ast]") {
+  FlatTree tree;
+
+  // -(2 * 3) + 10 / 0, (1 < 2) || y, false && y, if 2 == 2 { 7 } else { y }
+  auto sum = tree.AddBinary(
+      FlatOp::ADD,
+      tree.AddUnary(FlatOp::NEG, tree.AddBinary(FlatOp::MUL, tree.AddInt(2),
+                                                tree.AddInt(3))),
+      tree.AddBinary(FlatOp::DIV, tree.AddInt(10), tree.AddInt(0)));
+  auto product = tree.AddBinary(FlatOp::MUL, tree.AddInt(2), tree.AddInt(3));
+  auto any = tree.AddBinary(
+      FlatOp::OR, tree.AddBinary(FlatOp::LT, tree.AddInt(1), tree.AddInt(2)),
+      tree.AddVar("y"));
+  auto none = tree.AddBinary(FlatOp::AND, tree.AddBool(false),
+                             tree.AddVar("y"));
+  auto pick = tree.AddIf(
+      tree.AddBinary(FlatOp::EQ, tree.AddInt(2), tree.AddInt(2)),
+      tree.AddBlock(std::array{tree.AddInt(7)}),
+      tree.AddBlock(std::array{tree.AddVar("y")}));
+  auto unknown = tree.AddBinary(FlatOp::ADD, tree.AddVar("y"), tree.AddInt(1));
+
+  auto values = FoldConstants(tree);
+  REQUIRE(values.Size() == tree.Size());
+
+  CHECK(values[product] == 6);
+  CHECK_FALSE(values[sum]);  // division by zero stays at runtime
+  CHECK(values[any] == 1);
+  CHECK(values[none] == 0);
+  CHECK(values[pick] == 7);
+  CHECK_FALSE(values[unknown]);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static FlatIndex Lower(FlatTree& tree, TreeNode* node,
+                       std::span<const FlatIndex> children) {
+  if (auto num = dynamic_cast<Num*>(node)) {
+    return tree.AddInt(num->value);
+  }
+  return tree.AddBinary(FlatOp::ADD, children[0], children[1]);
+}
+
+static TreeNode* Raise(const FlatTree& tree, FlatIndex index,
+                       std::span<TreeNode* const> children) {
+  if (tree.Kind(index) == FlatKind::INT_LITERAL) {
+    return new Num{tree.Int(index)};
+  }
+  return new Add{children[0], children[1]};
+}
+
+TEST_CASE("Flat tree: conversion", "[ast]") {
+  static constexpr size_t kDepth = 200'000;
+
+  auto chain = Chain(kDepth);
+
+  FlatTree tree;
+  auto root = Flatten(chain, tree, Lower);
+  CHECK(tree.Size() == 2 * kDepth - 1);
+  CHECK(root == tree.Size() - 1);
+
+  auto values = FoldConstants(tree);
+  CHECK(values[root] == static_cast<int64_t>(kDepth * (kDepth + 1) / 2));
+
+  // Only the sub-tree asked for: 1, 2, 1 + 2, 3, (1 + 2) + 3
+  FlatIndex inner = 4;
+  auto back = Inflate(tree, inner, Raise);
+
+  SumVisitor sum;
+  CHECK(sum.Eval(back) == 6);
+  CHECK(Add::alive == kDepth - 1 + 2);
+
+  auto whole = Inflate(tree, root, Raise);
+  CHECK(sum.EvalIteratively(whole) == *values[root]);
+
+  DestroyTree(chain);
+  DestroyTree(back);
+  DestroyTree(whole);
+  CHECK(Add::alive == 0);
+}
+
+//////////////////////////////////////////////////////////////////////
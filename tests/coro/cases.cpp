@@ -0,0 +1,234 @@
+#include <coro/coroutine.hpp>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+//////////////////////////////////////////////////////////////////////
+
+// fun range from to = {
+//   var i = from;
+//   while i < to { yield i; i += 1; }
+// };
+
+static std::vector<coro::Local> RangeLocals() {
+  return {
+      {"from", 8, 8},
+      {"to", 8, 8},
+      {"i", 8, 8},
+      {"tmp", 4, 4},  // scratch never live across the yield
+  };
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Coro: frame holds what is live across yields", "[coro]") {
+  auto locals = RangeLocals();
+  size_t params[] = {0, 1};
+  coro::SuspendPoint suspends[] = {{.live = {1, 2}}};
+
+  auto frame = coro::ComputeFrame(locals, params, suspends, 8, 8);
+
+  // `from` and `i` are never live together: one slot for both
+  CHECK(frame.slot_offsets[0] == frame.slot_offsets[2]);
+  CHECK(frame.slot_offsets[1] != frame.slot_offsets[0]);
+  CHECK(frame.slot_offsets[3] == coro::FrameLayout::kNoSlot);
+
+  // state + value + two slots
+  CHECK(frame.frame.size == 32);
+  CHECK(frame.done == 2);
+  CHECK(frame.value_size == 8);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Coro: aggregates and no value", "[coro]") {
+  std::vector<coro::Local> locals = {
+      {"flag", 1, 1},
+      {"buffer", 64, 8, true},
+      {"count", 4, 4},
+  };
+  coro::SuspendPoint suspends[] = {
+      {.live = {0, 1}},
+      {.live = {1, 2}},
+  };
+
+  auto frame = coro::ComputeFrame(locals, {}, suspends, 0, 1);
+
+  // `flag` and `count` share a slot, wide enough for both
+  CHECK(frame.slot_offsets[0] == frame.slot_offsets[2]);
+  CHECK(frame.frame.size == 72);
+  CHECK(frame.frame.Find("value") == nullptr);
+  CHECK(frame.done == 3);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Coro: lowering", "[coro]") {
+  auto locals = RangeLocals();
+  size_t params[] = {0, 1};
+  coro::SuspendPoint suspends[] = {{.live = {1, 2}}};
+  auto frame = coro::ComputeFrame(locals, params, suspends, 8, 8);
+
+  size_t next = 0;
+  auto fresh = [&] {
+    return qbe::QbeValue::Temporary(next++);
+  };
+
+  qbe::IrEmitter out;
+  coro::CoroutineLowering lowering{"range", frame, locals, params,
+                                   suspends, out, fresh};
+
+  lowering.EmitInit();
+
+  std::vector<qbe::QbeValue> temps;
+  for (size_t i = 0; i < locals.size(); i++) {
+    temps.push_back(fresh());
+  }
+
+  lowering.EmitResumeHeader(temps);
+  out.EmitInstr("{} =l copy {}", temps[2], temps[0]);
+  out.Emit("@loop");
+  lowering.EmitSuspend(0, temps[2], temps);
+  lowering.EmitResumePoint(0, temps);
+  out.EmitInstr("{} =l add {}, 1", temps[2], temps[2]);
+  out.EmitInstr("jmp @loop");
+  lowering.EmitFinish();
+
+  // Value (align 8) first, then the two slots, then the state
+  CHECK(frame.value_offset == 0);
+  CHECK(frame.slot_offsets[0] == 8);
+  CHECK(frame.slot_offsets[1] == 16);
+  CHECK(frame.state_offset == 24);
+
+  CHECK(out.Contents() ==
+        "function $range.init(l %.0, l %.1, l %.2) {\n"
+        "@start\n"
+        "\t%.3 =l add %.0, 24\n"
+        "\tstorew 0, %.3\n"
+        "\t%.4 =l add %.0, 8\n"
+        "\tstorel %.1, %.4\n"
+        "\t%.5 =l add %.0, 16\n"
+        "\tstorel %.2, %.5\n"
+        "\tret\n"
+        "}\n"
+        "function w $range.resume(l %.10) {\n"
+        "@start\n"
+        "\t%.12 =l add %.10, 24\n"
+        "\t%.11 =w loadw %.12\n"
+        "\t%.13 =w ceqw %.11, 0\n"
+        "\tjnz %.13, @body, @dispatch.0\n"
+        "@dispatch.0\n"
+        "\t%.14 =w ceqw %.11, 1\n"
+        "\tjnz %.14, @resume.0, @dispatch.1\n"
+        "@dispatch.1\n"
+        "\tret 0\n"
+        "@body\n"
+        "\t%.15 =l add %.10, 8\n"
+        "\t%.6 =l loadl %.15\n"
+        "\t%.16 =l add %.10, 16\n"
+        "\t%.7 =l loadl %.16\n"
+        "\t%.8 =l copy %.6\n"
+        "@loop\n"
+        "\tstorel %.8, %.10\n"
+        "\t%.17 =l add %.10, 16\n"
+        "\tstorel %.7, %.17\n"
+        "\t%.18 =l add %.10, 8\n"
+        "\tstorel %.8, %.18\n"
+        "\t%.19 =l add %.10, 24\n"
+        "\tstorew 1, %.19\n"
+        "\tret 1\n"
+        "@resume.0\n"
+        "\t%.20 =l add %.10, 16\n"
+        "\t%.7 =l loadl %.20\n"
+        "\t%.21 =l add %.10, 8\n"
+        "\t%.8 =l loadl %.21\n"
+        "\t%.8 =l add %.8, 1\n"
+        "\tjmp @loop\n"
+        "@finish\n"
+        "\t%.22 =l add %.10, 24\n"
+        "\tstorew 2, %.22\n"
+        "\tret 0\n"
+        "}\n");
+
+  qbe::IrEmitter create;
+  coro::EmitCreate(create, qbe::QbeValue::Temporary(1), frame, true);
+  CHECK(create.Contents() == "\t%.1 =l alloc8 32\n");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Coro: aggregates keep their own slots", "[coro]") {
+  // `first` is dead at the second yield and `second` at the first,
+  // but both sit in the frame between them
+  std::vector<coro::Local> locals = {
+      {"first", 16, 8, true},
+      {"second", 16, 8, true},
+      {"n", 8, 8},
+  };
+  coro::SuspendPoint suspends[] = {
+      {.live = {0}},
+      {.live = {1, 2}},
+  };
+
+  auto frame = coro::ComputeFrame(locals, {}, suspends, 0, 1);
+
+  CHECK(frame.slot_offsets[0] != frame.slot_offsets[1]);
+  CHECK(frame.slot_offsets[2] != frame.slot_offsets[0]);
+  CHECK(frame.frame.size == 48);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Coro: small aggregates", "[coro]") {
+  // fun gen(pair: {i32, i32}, rgb: {u8, u8, u8}) = { yield pair; ... }
+  std::vector<coro::Local> locals = {
+      {"pair", 8, 4, true},
+      {"rgb", 3, 1, true},
+  };
+  size_t params[] = {0, 1};
+  coro::SuspendPoint suspends[] = {{.live = {0, 1}}};
+  auto frame = coro::ComputeFrame(locals, params, suspends, 8, 4, true);
+
+  size_t next = 0;
+  auto fresh = [&] {
+    return qbe::QbeValue::Temporary(next++);
+  };
+
+  qbe::IrEmitter out;
+  coro::CoroutineLowering lowering{"gen", frame, locals, params,
+                                   suspends, out, fresh};
+  lowering.EmitInit();
+
+  std::vector<qbe::QbeValue> temps = {fresh(), fresh()};
+  lowering.EmitResumeHeader(temps);
+  lowering.EmitSuspend(0, temps[0], temps);
+
+  // Copied in and out by address, never stored as a scalar
+  CHECK(out.Contents() ==
+        "function $gen.init(l %.0, l %.1, l %.2) {\n"
+        "@start\n"
+        "\tstorew 0, %.0\n"
+        "\t%.3 =l add %.0, 12\n"
+        "\tblit %.1, %.3, 8\n"
+        "\t%.4 =l add %.0, 20\n"
+        "\tblit %.2, %.4, 3\n"
+        "\tret\n"
+        "}\n"
+        "function w $gen.resume(l %.7) {\n"
+        "@start\n"
+        "\t%.8 =w loadw %.7\n"
+        "\t%.9 =w ceqw %.8, 0\n"
+        "\tjnz %.9, @body, @dispatch.0\n"
+        "@dispatch.0\n"
+        "\t%.10 =w ceqw %.8, 1\n"
+        "\tjnz %.10, @resume.0, @dispatch.1\n"
+        "@dispatch.1\n"
+        "\tret 0\n"
+        "@body\n"
+        "\t%.11 =l add %.7, 4\n"
+        "\tblit %.5, %.11, 8\n"
+        "\tstorew 1, %.7\n"
+        "\tret 1\n");
+}
+
+//////////////////////////////////////////////////////////////////////
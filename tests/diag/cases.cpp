@@ -0,0 +1,141 @@
+#include <diag/diagnostic_engine.hpp>
+#include <diag/diag_error.hpp>
+
+#include <parse/parse_error.hpp>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+
+using diag::DiagKind;
+using diag::Diagnostic;
+
+static Diagnostic At(DiagKind kind, diag::FileId file, size_t lineno,
+                     size_t columnno) {
+  auto diagnostic = Diagnostic::At(kind, lex::Location{lineno, columnno});
+  diagnostic.file = file;
+  return diagnostic;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Diagnostics: ordered by location", "[diag]") {
+  diag::DiagnosticEngine engine;
+  auto main = engine.AddFile("main.et");
+  auto util = engine.AddFile("util.et");
+
+  engine.Report(At(DiagKind::PARSE_TYPE, util, 0, 4));
+  engine.Report(At(DiagKind::PARSE_EXPORT, main, 9, 0));
+  engine.Report(At(DiagKind::PARSE_PRIMARY, main, 2, 7));
+
+  auto all = engine.Collect();
+  REQUIRE(all.size() == 3);
+  CHECK(all[0].kind == DiagKind::PARSE_PRIMARY);
+  CHECK(all[1].kind == DiagKind::PARSE_EXPORT);
+  CHECK(all[2].kind == DiagKind::PARSE_TYPE);
+
+  std::ostringstream out;
+  engine.Print(out);
+  CHECK(out.str() ==
+        "main.et:3:8: error: Could not match primary expression\n"
+        "main.et:10:1: error: Expected declaration after export\n"
+        "util.et:1:5: error: Could not parse the type\n"
+        "3 errors generated.\n");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Diagnostics: speculation rolls back", "[diag]") {
+  diag::DiagnosticEngine engine;
+
+  engine.Report(At(DiagKind::PARSE_TYPE, 0, 1, 0));
+
+  auto mark = engine.Mark();
+  engine.Report(At(DiagKind::PARSE_PRIMARY, 0, 2, 0));
+  engine.Report(At(DiagKind::PARSE_NON_LVALUE, 0, 3, 0));
+  engine.Rollback(mark);
+
+  engine.Report(At(DiagKind::PARSE_EXPORT, 0, 4, 0));
+
+  auto all = engine.Collect();
+  REQUIRE(all.size() == 2);
+  CHECK(all[0].kind == DiagKind::PARSE_TYPE);
+  CHECK(all[1].kind == DiagKind::PARSE_EXPORT);
+
+  // Nothing reported, nothing printed
+  diag::DiagnosticEngine quiet;
+  std::ostringstream out;
+  quiet.Print(out);
+  CHECK(out.str().empty());
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Diagnostics: reported from many threads", "[diag]") {
+  diag::DiagnosticEngine engine;
+
+  static constexpr size_t kThreads = 8;
+  static constexpr size_t kPerThread = 1000;
+
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < kThreads; t++) {
+    workers.emplace_back([&, t] {
+      for (size_t i = 0; i < kPerThread; i++) {
+        // Every other one is speculative and abandoned
+        auto mark = engine.Mark();
+        engine.Report(At(DiagKind::PARSE_TYPE, 0, i, t));
+        if (i % 2 == 1) {
+          engine.Rollback(mark);
+        }
+      }
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  auto all = engine.Collect();
+  REQUIRE(all.size() == kThreads * kPerThread / 2);
+  CHECK(engine.Count() == all.size());
+
+  CHECK(std::is_sorted(all.begin(), all.end(), [](auto& a, auto& b) {
+    return std::pair{a.lineno, a.columnno} < std::pair{b.lineno, b.columnno};
+  }));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Diagnostics: parse errors format lazily", "[diag]") {
+  try {
+    throw parse::errors::ParseNonLvalueError{lex::Location{4, 2}};
+  } catch (const parse::errors::ParseError& error) {
+    CHECK(error.diagnostic.kind == DiagKind::PARSE_NON_LVALUE);
+    CHECK(std::string{error.what()} ==
+          "Expected lvalue at location line = 5, column = 3\n");
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Diagnostics: file ids run out", "[diag]") {
+  diag::DiagnosticEngine engine;
+
+  diag::FileId last = 0;
+  for (size_t i = 0; i <= UINT16_MAX; i++) {
+    last = engine.AddFile("f.et");
+  }
+  CHECK(last == UINT16_MAX);
+
+  // Rather than wrapping around to file 0
+  CHECK_THROWS_AS(engine.AddFile("one-too-many.et"),
+                  diag::errors::TooManyFilesError);
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -0,0 +1,276 @@
+#include <driver/parallel_codegen.hpp>
+#include <driver/build.hpp>
+#include <driver/driver_error.hpp>
+#include <driver/import_scan.hpp>
+#include <driver/build_graph.hpp>
+#include <driver/task_graph.hpp>
+#include <driver/depfile.hpp>
+
+#include <qbe/qbe_value.hpp>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+#include <stdexcept>
+#include <atomic>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+
+static void LowerFake(size_t index, qbe::IrEmitter& out) {
+  out.Emit("function w $f{}() {{", index);
+  out.Emit("@start");
+  // Uneven sizes, so workers finish out of order
+  for (size_t i = 0; i < index % 7; i++) {
+    out.EmitInstr("{} =w copy {}", qbe::QbeValue::Temporary(i),
+                  qbe::QbeValue::Const(index));
+  }
+  out.EmitInstr("ret 0");
+  out.Emit("}}");
+}
+
+static std::string Render(size_t workers, size_t count) {
+  driver::ParallelCodegen codegen{workers};
+  codegen.LowerAll(count, LowerFake);
+
+  qbe::IrEmitter out;
+  codegen.Write(out);
+  return std::string{out.Contents()};
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parallel codegen: same output as serial", "[driver]") {
+  auto serial = Render(1, 500);
+
+  CHECK(serial.starts_with("function w $f0() {\n"));
+  CHECK(Render(2, 500) == serial);
+  CHECK(Render(8, 500) == serial);
+  CHECK(Render(64, 3) == Render(1, 3));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parallel codegen: partition", "[driver]") {
+  driver::ParallelCodegen codegen{4};
+  codegen.LowerAll(100, LowerFake);
+
+  auto ranges = codegen.Partition(3);
+  REQUIRE(ranges.size() == 3);
+
+  CHECK(ranges.front().begin == 0);
+  CHECK(ranges.back().end == 100);
+
+  qbe::IrEmitter joined;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    if (i > 0) {
+      CHECK(ranges[i].begin == ranges[i - 1].end);
+    }
+    codegen.Write(joined, ranges[i]);
+  }
+
+  qbe::IrEmitter whole;
+  codegen.Write(whole);
+  CHECK(joined.Contents() == whole.Contents());
+
+  // Hot functions first, as with --profile-use
+  std::vector<size_t> order(100);
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = 99 - i;
+  }
+
+  qbe::IrEmitter reordered;
+  codegen.WriteInOrder(reordered, order);
+  CHECK(reordered.Contents().starts_with("function w $f99() {\n"));
+  CHECK(reordered.Contents().size() == whole.Contents().size());
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parallel codegen: errors propagate", "[driver]") {
+  driver::ParallelCodegen codegen{4};
+
+  auto lower = [](size_t index, qbe::IrEmitter& out) {
+    if (index == 42) {
+      throw std::runtime_error{"boom"};
+    }
+    LowerFake(index, out);
+  };
+
+  CHECK_THROWS_AS(codegen.LowerAll(100, lower), std::runtime_error);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Import scan", "[driver]") {
+  auto imports = driver::ScanImports(
+      "# Vector utilities\n"
+      "import mem;\n"
+      "  import   io ;  # trailing comment\n"
+      "\n"
+      "import fmt;"
+      "export fun push v x = { import_count = 1 };\n"
+      "import late;\n");
+
+  CHECK(imports == std::vector<std::string>{"mem", "io", "fmt"});
+
+  CHECK(driver::ScanImports("").empty());
+  CHECK(driver::ScanImports("important = 1;").empty());
+  CHECK(driver::ScanImports("import ;").empty());
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Build graph", "[driver]") {
+  driver::BuildGraph graph;
+  graph.AddModule("src/main.et", {"vec", "io"});
+  graph.AddModule("src/vec.et", {"mem"});
+  graph.AddModule("lib/mem.et", {});
+
+  graph.Resolve();
+
+  auto& modules = graph.Modules();
+  CHECK(modules[0].name == "main");
+  CHECK(modules[0].external_deps == std::vector<std::string>{"io"});
+
+  auto order = graph.TopologicalOrder();
+  CHECK(order == std::vector<size_t>{2, 1, 0});
+
+  SECTION("cycle") {
+    graph.AddModule("mem2.et", {"main"});
+    graph.AddModule("io.et", {"mem2"});
+    CHECK_THROWS_AS(graph.Resolve(), driver::errors::ImportCycleError);
+  }
+
+  SECTION("duplicate") {
+    CHECK_THROWS_AS(graph.AddModule("other/vec.et", {}),
+                    driver::errors::DuplicateModuleError);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Task graph: dependencies are respected", "[driver]") {
+  driver::TaskGraph tasks;
+
+  std::atomic<int> clock{0};
+  std::vector<int> finished(200, -1);
+
+  // Layers of 20 tasks, each depending on a few of the layer before
+  for (size_t i = 0; i < finished.size(); i++) {
+    std::vector<driver::TaskGraph::TaskId> deps;
+    if (i >= 20) {
+      deps = {i - 20, (i - 20) / 20 * 20 + (i * 7) % 20};
+    }
+
+    tasks.Add(
+        [&, i, deps] {
+          for (auto dep : deps) {
+            CHECK(finished[dep] != -1);
+          }
+          finished[i] = clock.fetch_add(1);
+        },
+        deps);
+  }
+
+  tasks.Run(8);
+
+  for (auto time : finished) {
+    CHECK(time != -1);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Task graph: failure stops new jobs", "[driver]") {
+  driver::TaskGraph tasks;
+  bool ran_dependent = false;
+
+  auto broken = tasks.Add([] {
+    throw std::runtime_error{"cc failed"};
+  });
+  tasks.Add(
+      [&] {
+        ran_dependent = true;
+      },
+      {broken});
+
+  CHECK_THROWS_AS(tasks.Run(4), std::runtime_error);
+  CHECK_FALSE(ran_dependent);
+
+  driver::TaskGraph empty;
+  empty.Run(4);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Depfile", "[driver]") {
+  CHECK(driver::FormatDepfile({"app"}, {"main.et", "my lib/io.eti"}) ==
+        "app: \\\n"
+        "  main.et \\\n"
+        "  my\\ lib/io.eti\n");
+
+  CHECK(driver::FormatDepfile({"a.eti", "b.eti"}, {}) == "a.eti b.eti:\n");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Build options", "[driver]") {
+  std::vector<std::string> args{"-I", "lib", "-o", "bin/app", "-j", "2",
+                                "main.et", "/abs/util.et"};
+
+  driver::BuildOptions options;
+  REQUIRE(driver::ParseBuildOptions(args, options));
+
+  options.MakeAbsolute("/home/user/project");
+
+  CHECK(options.inputs == std::vector<std::filesystem::path>{
+                              "/home/user/project/main.et", "/abs/util.et"});
+  CHECK(options.include_dirs ==
+        std::vector<std::filesystem::path>{"/home/user/project/lib"});
+  CHECK(options.output == "/home/user/project/bin/app");
+  CHECK(options.build_dir == "/home/user/project/");
+  CHECK(options.depfile.empty());
+  CHECK(options.jobs == 2);
+  CHECK_FALSE(options.codegen.instrument);
+
+  driver::BuildOptions pgo;
+  std::vector<std::string> profiled{"--instrument",
+                                    "--profile-use=runs/app.profile",
+                                    "--runtime=lib/libetude_rt.a",
+                                    "main.et"};
+  REQUIRE(driver::ParseBuildOptions(profiled, pgo));
+  pgo.MakeAbsolute("/home/user/project");
+  CHECK(pgo.codegen.instrument);
+  CHECK(pgo.codegen.profile_use == "/home/user/project/runs/app.profile");
+  CHECK(pgo.runtime == "/home/user/project/lib/libetude_rt.a");
+  CHECK(options.runtime.empty());
+
+  driver::BuildOptions generic;
+  std::vector<std::string> strategies{"--generics=dictionary",
+                                      "--generics-for=id=specialize",
+                                      "main.et"};
+  REQUIRE(driver::ParseBuildOptions(strategies, generic));
+  CHECK(generic.codegen.generics.For("id") == mono::Strategy::SPECIALIZE);
+  CHECK(generic.codegen.generics.For("map") == mono::Strategy::DICTIONARY);
+
+  for (auto spec : {"--generics-for=id", "--generics-for==specialize",
+                    "--generics-for=id=inline"}) {
+    driver::BuildOptions rejected;
+    std::vector<std::string> args{spec, "main.et"};
+    CHECK_FALSE(driver::ParseBuildOptions(args, rejected));
+  }
+
+  driver::BuildOptions bad;
+  std::vector<std::string> unknown{"--frobnicate", "main.et"};
+  CHECK_FALSE(driver::ParseBuildOptions(unknown, bad));
+
+  for (auto jobs : {"", "four", "4x", "-1", "99999999999999999999999"}) {
+    driver::BuildOptions rejected;
+    std::vector<std::string> args{"-j", jobs, "main.et"};
+    CHECK_FALSE(driver::ParseBuildOptions(args, rejected));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -0,0 +1,96 @@
+#include <layout/struct_layout.hpp>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+//////////////////////////////////////////////////////////////////////
+
+static std::vector<layout::FieldSpec> MixedRecord() {
+  return {
+      {"alive", 1, 1, "b"},
+      {"id", 8, 8, "l"},
+      {"visible", 1, 1, "b"},
+      {"next", 8, 8, "l"},
+      {"score", 4, 4, "w"},
+  };
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Layout: declared order", "[layout]") {
+  auto fields = MixedRecord();
+  auto record = layout::ComputeLayout(fields, layout::Repr::DECLARED);
+
+  CHECK(record.fields[0].offset == 0);
+  CHECK(record.fields[1].offset == 8);
+  CHECK(record.fields[2].offset == 16);
+  CHECK(record.fields[3].offset == 24);
+  CHECK(record.fields[4].offset == 32);
+
+  CHECK(record.size == 40);
+  CHECK(record.align == 8);
+  CHECK(record.Padding() == 18);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Layout: reordered", "[layout]") {
+  auto fields = MixedRecord();
+  auto record = layout::ComputeLayout(fields);
+
+  // Fields are still reported in declaration order
+  CHECK(record.fields[0].name == "alive");
+
+  CHECK(record.Find("id")->offset == 0);
+  CHECK(record.Find("next")->offset == 8);
+  CHECK(record.Find("score")->offset == 16);
+  CHECK(record.Find("alive")->offset == 20);
+  CHECK(record.Find("visible")->offset == 21);
+  CHECK(record.Find("missing") == nullptr);
+
+  CHECK(record.size == 24);
+  CHECK(record.Padding() == 2);
+
+  qbe::IrEmitter out;
+  record.EmitQbeType("Record", out);
+  CHECK(out.Contents() == "type :Record = align 8 { l, l, w, b, b }\n");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Layout: edge cases", "[layout]") {
+  auto empty = layout::ComputeLayout({});
+  CHECK(empty.size == 0);
+  CHECK(empty.align == 1);
+
+  // Nested struct of size 12, align 4, followed by a Bool
+  std::vector<layout::FieldSpec> fields = {
+      {"flag", 1, 1, "b"},
+      {"inner", 12, 4, ":Inner"},
+  };
+  auto outer = layout::ComputeLayout(fields);
+  CHECK(outer.Find("inner")->offset == 0);
+  CHECK(outer.Find("flag")->offset == 12);
+  CHECK(outer.size == 16);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Layout: field access", "[layout]") {
+  auto fields = MixedRecord();
+  auto record = layout::ComputeLayout(fields);
+
+  auto base = qbe::QbeValue::Temporary(1);
+
+  qbe::IrEmitter out;
+  layout::EmitFieldAddress(out, qbe::QbeValue::Temporary(2), base,
+                           *record.Find("score"));
+  layout::EmitFieldAddress(out, qbe::QbeValue::Temporary(3), base,
+                           *record.Find("id"));
+
+  CHECK(out.Contents() ==
+        "\t%.2 =l add %.1, 16\n"
+        "\t%.3 =l copy %.1\n");
+}
+
+//////////////////////////////////////////////////////////////////////
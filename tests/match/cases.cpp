@@ -0,0 +1,199 @@
+#include <match/decision_tree.hpp>
+#include <match/match_error.hpp>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+//////////////////////////////////////////////////////////////////////
+
+using match::Pattern;
+using match::Shape;
+
+// type Message = .ping | .pong | .data Int
+// Maybe(Message) = .none | .some Message
+
+static Shape MaybeMessage() {
+  Shape message;
+  message.constructors = {
+      {"ping", {}},
+      {"pong", {}},
+      {"data", {Shape::Open()}},
+  };
+
+  Shape maybe;
+  maybe.constructors = {
+      {"none", {}},
+      {"some", {message}},
+  };
+  return maybe;
+}
+
+enum { NONE = 0, SOME = 1 };
+enum { PING = 0, PONG = 1, DATA = 2 };
+
+static size_t CountSwitches(const match::Decision& node,
+                            const match::Occurrence& occurrence) {
+  if (node.kind != match::Decision::Kind::SWITCH) {
+    return 0;
+  }
+
+  size_t deepest = 0;
+  for (auto& c : node.cases) {
+    deepest = std::max(deepest, CountSwitches(*c.next, occurrence));
+  }
+  if (node.fallback) {
+    deepest = std::max(deepest, CountSwitches(*node.fallback, occurrence));
+  }
+
+  return deepest + (node.occurrence == occurrence);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Match: each tag is tested once", "[match]") {
+  // | .some .ping: ...
+  // | .some msg: ...
+  // | .none: ...
+  std::vector<Pattern> arms = {
+      Pattern::Constructor(SOME, {Pattern::Constructor(PING)}),
+      Pattern::Constructor(SOME, {Pattern::Any("msg")}),
+      Pattern::Constructor(NONE),
+  };
+
+  auto shape = MaybeMessage();
+  auto result = match::Compile(shape, arms);
+
+  CHECK_FALSE(result.missing);
+  CHECK(result.redundant_arms.empty());
+  CHECK(result.depth == 2);
+
+  // On every path `.some` is tested once, and so is the message
+  CHECK(CountSwitches(*result.tree, {}) == 1);
+  CHECK(CountSwitches(*result.tree, {0}) == 1);
+
+  // .some goes on to the message; msg is bound to field 0
+  auto& some = *result.tree->cases[0].next;
+  REQUIRE(some.kind == match::Decision::Kind::SWITCH);
+  CHECK(some.occurrence == match::Occurrence{0});
+
+  auto& other = *some.fallback;
+  REQUIRE(other.kind == match::Decision::Kind::LEAF);
+  CHECK(other.arm == 1);
+  CHECK(other.bindings[0].first == "msg");
+  CHECK(other.bindings[0].second == match::Occurrence{0});
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Match: exhaustiveness and redundancy", "[match]") {
+  auto shape = MaybeMessage();
+
+  SECTION("missing constructor") {
+    std::vector<Pattern> arms = {
+        Pattern::Constructor(SOME, {Pattern::Constructor(PING)}),
+        Pattern::Constructor(SOME,
+                             {Pattern::Constructor(DATA, {Pattern::Any()})}),
+        Pattern::Constructor(NONE),
+    };
+
+    auto result = match::Compile(shape, arms);
+    CHECK(result.missing == ".some(.pong)");
+    CHECK_THROWS_AS(match::RequireExhaustive(result),
+                    match::errors::NonExhaustiveMatchError);
+  }
+
+  SECTION("missing literal") {
+    std::vector<Pattern> arms = {
+        Pattern::Constructor(
+            SOME, {Pattern::Constructor(DATA, {Pattern::Constructor(42)})}),
+        Pattern::Constructor(NONE),
+    };
+
+    auto result = match::Compile(shape, arms);
+    CHECK(result.missing == ".some(.data(_))");
+  }
+
+  SECTION("redundant arms") {
+    std::vector<Pattern> arms = {
+        Pattern::Constructor(SOME, {Pattern::Any("msg")}),
+        Pattern::Constructor(SOME, {Pattern::Constructor(PING)}),
+        Pattern::Any(),
+        Pattern::Constructor(NONE),
+    };
+
+    auto result = match::Compile(shape, arms);
+    CHECK_FALSE(result.missing);
+    CHECK(result.redundant_arms == std::vector<size_t>{1, 3});
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Match: lowering", "[match]") {
+  auto shape = MaybeMessage();
+
+  std::vector<Pattern> arms = {
+      Pattern::Constructor(SOME, {Pattern::Constructor(PING)}),
+      Pattern::Constructor(SOME, {Pattern::Any("msg")}),
+      Pattern::Constructor(NONE),
+  };
+  auto result = match::Compile(shape, arms);
+
+  size_t next = 1;
+  size_t tag_loads = 0;
+  size_t field_loads = 0;
+
+  qbe::IrEmitter out;
+
+  match::Access access;
+  access.fresh = [&] {
+    return qbe::QbeValue::Temporary(next++);
+  };
+  access.load_tag = [&](qbe::QbeValue value, const Shape&) {
+    tag_loads += 1;
+    auto tag = access.fresh();
+    out.EmitInstr("{} =w loadw {}", tag, value);
+    return tag;
+  };
+  access.load_field = [&](qbe::QbeValue value, const Shape&, size_t,
+                          size_t) {
+    field_loads += 1;
+    auto field = access.fresh();
+    out.EmitInstr("{} =l add {}, 8", field, value);
+    return field;
+  };
+  access.emit_arm = [&](size_t arm, auto bound) {
+    for (auto& [name, value] : bound) {
+      out.EmitInstr("%{} =l copy {}", name, value);
+    }
+    out.EmitInstr("jmp @arm.{}", arm);
+  };
+  access.emit_fail = [&] {
+    out.EmitInstr("hlt");
+  };
+
+  match::EmitDecisionTree(out, *result.tree, shape,
+                          qbe::QbeValue::Temporary(0), access, "m0");
+
+  CHECK(tag_loads == 2);
+  CHECK(field_loads == 1);
+
+  CHECK(out.Contents() ==
+        "\t%.1 =w loadw %.0\n"
+        "\t%.2 =w ceqw %.1, 1\n"
+        "\tjnz %.2, @m0.0, @m0.1\n"
+        "@m0.0\n"
+        "\t%.3 =l add %.0, 8\n"
+        "\t%.4 =w loadw %.3\n"
+        "\t%.5 =w ceqw %.4, 0\n"
+        "\tjnz %.5, @m0.3, @m0.4\n"
+        "@m0.3\n"
+        "\tjmp @arm.0\n"
+        "@m0.4\n"
+        "\t%msg =l copy %.3\n"
+        "\tjmp @arm.1\n"
+        "@m0.1\n"
+        "\tjmp @arm.2\n");
+}
+
+//////////////////////////////////////////////////////////////////////
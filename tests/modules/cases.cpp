@@ -0,0 +1,179 @@
+#include <modules/interface.hpp>
+#include <modules/module_error.hpp>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+
+//////////////////////////////////////////////////////////////////////
+
+static modules::ModuleInterface MakeVec() {
+  modules::ModuleInterface vec;
+  vec.name = "vec";
+  vec.imports = {"mem", "io"};
+
+  auto& push = vec.exports.emplace_back();
+  push.name = "push";
+  push.type = "*Vec -> Int -> Unit";
+
+  auto& type = vec.exports.emplace_back();
+  type.kind = modules::ExportedSymbol::Kind::TYPE;
+  type.name = "Vec";
+  type.type = std::string(300, 'x');  // length needs a 2-byte varint
+
+  return vec;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Interface: round trip", "[modules]") {
+  auto vec = MakeVec();
+  auto bytes = modules::Serialize(vec);
+
+  CHECK(bytes.starts_with("ETI"));
+  CHECK(modules::Deserialize(bytes) == vec);
+
+  REQUIRE(vec.Find("push") != nullptr);
+  CHECK(vec.Find("push")->kind == modules::ExportedSymbol::Kind::FUNCTION);
+  CHECK(vec.Find("pop") == nullptr);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Interface: malformed files", "[modules]") {
+  auto bytes = modules::Serialize(MakeVec());
+
+  CHECK_THROWS_AS(modules::Deserialize("ELF"),
+                  modules::errors::InterfaceFormatError);
+  CHECK_THROWS_AS(modules::Deserialize(bytes.substr(0, bytes.size() - 1)),
+                  modules::errors::InterfaceFormatError);
+  CHECK_THROWS_AS(modules::Deserialize(bytes + "!"),
+                  modules::errors::InterfaceFormatError);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Interface: rewritten only when changed", "[modules]") {
+  auto dir = std::filesystem::temp_directory_path() / "etude-rewrite";
+  std::filesystem::create_directories(dir);
+  auto path = dir / "vec.eti";
+
+  auto vec = MakeVec();
+  modules::WriteInterface(vec, path);
+
+  auto old_time =
+      std::filesystem::last_write_time(path) - std::chrono::seconds{10};
+  std::filesystem::last_write_time(path, old_time);
+
+  // Same interface: same file, same timestamp
+  modules::WriteInterface(vec, path);
+  CHECK(std::filesystem::last_write_time(path) == old_time);
+
+  vec.exports.pop_back();
+  modules::WriteInterface(vec, path);
+  CHECK(std::filesystem::last_write_time(path) != old_time);
+  CHECK(modules::ReadInterface(path) == vec);
+  CHECK_FALSE(std::filesystem::exists(dir / "vec.eti.tmp"));
+
+  std::filesystem::remove_all(dir);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Interface: loader", "[modules]") {
+  auto dir = std::filesystem::temp_directory_path() / "etude-interfaces";
+  std::filesystem::create_directories(dir);
+
+  auto vec = MakeVec();
+  modules::WriteInterface(vec, dir / "vec.eti");
+
+  modules::InterfaceLoader loader{{"/nonexistent", dir}};
+
+  auto& loaded = loader.Load("vec");
+  CHECK(loaded == vec);
+
+  // Cached: same object, file not read again
+  std::filesystem::remove(dir / "vec.eti");
+  CHECK(&loader.Load("vec") == &loaded);
+
+  CHECK_THROWS_AS(loader.Load("missing"),
+                  modules::errors::InterfaceNotFoundError);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Interface: revalidating loader", "[modules]") {
+  auto dir = std::filesystem::temp_directory_path() / "etude-revalidate";
+  std::filesystem::create_directories(dir);
+
+  auto vec = MakeVec();
+  modules::WriteInterface(vec, dir / "vec.eti");
+
+  modules::InterfaceLoader loader{{dir}, /*revalidate=*/true};
+
+  auto& first = loader.Load("vec");
+  CHECK(&loader.Load("vec") == &first);
+  CHECK(loader.ReadCount() == 1);
+
+  // Rewritten between two compilations
+  vec.exports.pop_back();
+  modules::WriteInterface(vec, dir / "vec.eti");
+  std::filesystem::last_write_time(
+      dir / "vec.eti",
+      std::filesystem::last_write_time(dir / "vec.eti") +
+          std::chrono::seconds{1});
+
+  auto& second = loader.Load("vec");
+  CHECK(second == vec);
+  CHECK(loader.ReadCount() == 2);
+
+  // The old one is still there for whoever holds it
+  CHECK(first.exports.size() == 2);
+
+  std::filesystem::remove_all(dir);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Interface: failed reads", "[modules]") {
+  auto dir = std::filesystem::temp_directory_path() / "etude-failed-reads";
+  std::filesystem::create_directories(dir);
+
+  auto corrupt = [&](const char* file) {
+    std::ofstream{dir / file, std::ios::binary} << "ELF";
+  };
+
+  modules::InterfaceLoader loader{{dir}, /*revalidate=*/true};
+
+  // Never loaded: the failure leaves no entry behind
+  corrupt("bad.eti");
+  CHECK_THROWS_AS(loader.Load("bad"), modules::errors::InterfaceFormatError);
+  CHECK_THROWS_AS(loader.Load("bad"), modules::errors::InterfaceFormatError);
+
+  // Loaded before: the old version stays until a good one replaces it
+  auto vec = MakeVec();
+  modules::WriteInterface(vec, dir / "vec.eti");
+  auto& first = loader.Load("vec");
+
+  corrupt("vec.eti");
+  std::filesystem::last_write_time(
+      dir / "vec.eti",
+      std::filesystem::last_write_time(dir / "vec.eti") +
+          std::chrono::seconds{1});
+  CHECK_THROWS_AS(loader.Load("vec"), modules::errors::InterfaceFormatError);
+  CHECK(first == vec);
+
+  modules::WriteInterface(vec, dir / "vec.eti");
+  std::filesystem::last_write_time(
+      dir / "vec.eti",
+      std::filesystem::last_write_time(dir / "vec.eti") +
+          std::chrono::seconds{2});
+  CHECK(loader.Load("vec") == vec);
+
+  std::filesystem::remove_all(dir);
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -0,0 +1,191 @@
+#include <mono/instantiation_cache.hpp>
+#include <mono/type_descriptor.hpp>
+#include <mono/mono_error.hpp>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+#include <filesystem>
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Mono: interner", "[mono]") {
+  mono::TypeInterner types;
+
+  auto int_id = types.Intern("Int");
+  auto vec_id = types.Intern("*Vec(Int)");
+
+  CHECK(types.Intern("Int") == int_id);
+  CHECK(int_id != vec_id);
+  CHECK(types.Spelling(vec_id) == "*Vec(Int)");
+  CHECK(types.Size() == 2);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Mono: mangling", "[mono]") {
+  std::string_view ints[] = {"Int"};
+  CHECK(mono::Mangle("main", {}) == "main");
+  CHECK(mono::Mangle("id", ints) == "id.3Int");
+
+  std::string_view vec[] = {"*Vec(Int)", "Bool"};
+  CHECK(mono::Mangle("append", vec) == "append.15_2aVec_28Int_294Bool");
+
+  // Underscores are escaped too, so these do not collide
+  std::string_view a[] = {"A_2a"};
+  std::string_view b[] = {"A*"};
+  CHECK(mono::Mangle("f", a) != mono::Mangle("f", b));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Mono: each specialization is lowered once", "[mono]") {
+  mono::TypeInterner types;
+  mono::InstantiationCache cache{types};
+
+  mono::TypeId int_args[] = {types.Intern("Int")};
+  mono::TypeId bool_args[] = {types.Intern("Bool")};
+
+  // A thousand call sites of `id` at two types
+  for (int i = 0; i < 1000; i++) {
+    auto symbol = cache.Request("id", i % 2 ? int_args : bool_args);
+    CHECK(symbol == (i % 2 ? "id.3Int" : "id.4Bool"));
+  }
+
+  auto pending = cache.TakePending();
+  REQUIRE(pending.size() == 2);
+  CHECK(pending[0]->symbol == "id.4Bool");
+  CHECK(pending[1]->function == "id");
+
+  CHECK(cache.Lowered() == 2);
+  CHECK(cache.Hits() == 998);
+
+  // Lowering `id` at Int requests nothing new
+  cache.Request("id", int_args);
+  CHECK(cache.TakePending().empty());
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Mono: cache shared between modules", "[mono]") {
+  auto path = std::filesystem::temp_directory_path() / "mono-test.inst";
+
+  mono::TypeInterner types;
+  mono::TypeId int_args[] = {types.Intern("Int")};
+
+  {
+    mono::InstantiationCache first{types};
+    first.Request("main", {});
+    first.Request("id", int_args);
+    first.Save(path);
+  }
+
+  // The other module interns in a different order
+  mono::TypeInterner other_types;
+  mono::TypeId other_bool[] = {other_types.Intern("Bool")};
+  mono::TypeId other_int[] = {other_types.Intern("Int")};
+
+  mono::InstantiationCache second{other_types};
+  second.Load(path);
+
+  CHECK(second.Request("id", other_int) == "id.3Int");
+  CHECK(second.Request("id", other_bool) == "id.4Bool");
+
+  auto pending = second.TakePending();
+  REQUIRE(pending.size() == 1);
+  CHECK(pending[0]->symbol == "id.4Bool");
+
+  std::filesystem::remove(path);
+
+  CHECK_THROWS_AS(second.Load(path), mono::errors::CacheFileError);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Mono: dictionary passing", "[mono]") {
+  mono::TypeInterner types;
+
+  mono::StrategyPolicy policy{mono::Strategy::DICTIONARY};
+  policy.Override("id", mono::Strategy::SPECIALIZE);
+
+  mono::InstantiationCache cache{types, policy};
+
+  mono::TypeId int_args[] = {types.Intern("Int")};
+  mono::TypeId vec_args[] = {types.Intern("Vec(Bool)")};
+
+  // One shared copy of `append`, whatever the element type
+  CHECK(cache.Request("append", int_args) == "append");
+  CHECK(cache.Request("append", vec_args) == "append");
+  CHECK(cache.StrategyFor("append") == mono::Strategy::DICTIONARY);
+
+  // ...while `id` is still specialized
+  CHECK(cache.Request("id", int_args) == "id.3Int");
+  CHECK(cache.StrategyFor("id") == mono::Strategy::SPECIALIZE);
+
+  auto pending = cache.TakePending();
+  REQUIRE(pending.size() == 2);
+  CHECK(pending[0]->strategy == mono::Strategy::DICTIONARY);
+  CHECK(pending[0]->type_args.empty());
+
+  CHECK(mono::ParseStrategy("dictionary") == mono::Strategy::DICTIONARY);
+  CHECK_FALSE(mono::ParseStrategy("templates"));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Mono: type descriptors", "[mono]") {
+  mono::TypeInterner types;
+  mono::DescriptorTable table{types};
+
+  auto vec = types.Intern("Vec(Int)");
+  auto int_type = types.Intern("Int");
+
+  mono::TypeDescriptor vec_layout;
+  vec_layout.size = 24;
+  vec_layout.align = 8;
+  vec_layout.copy = "vec_copy";
+
+  mono::TypeDescriptor int_layout;
+  int_layout.size = 8;
+  int_layout.align = 8;
+
+  auto vec_td = table.Require(vec, vec_layout);
+  CHECK(vec_td == ".td.12Vec_28Int_29");
+  CHECK(table.Require(int_type, int_layout) == ".td.3Int");
+
+  // A generic user function called `td` does not collide
+  std::string_view int_spelling[] = {"Int"};
+  CHECK(mono::Mangle("td", int_spelling) != ".td.3Int");
+  CHECK(table.Require(vec, vec_layout) == vec_td);
+  CHECK(table.Size() == 2);
+
+  qbe::IrEmitter out;
+  table.Emit(out);
+
+  CHECK(out.Contents() ==
+        "data $.td.12Vec_28Int_29 = { l 24, l 8, l $vec_copy }\n"
+        "data $.td.3Int = { l 8, l 8, l 0 }\n");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Mono: descriptor order does not follow interning", "[mono]") {
+  auto emit = [](std::vector<std::string_view> intern_order) {
+    mono::TypeInterner types;
+    for (auto spelling : intern_order) {
+      types.Intern(spelling);
+    }
+
+    mono::DescriptorTable table{types};
+    table.Require(types.Intern("Bool"), {1, 1, ""});
+    table.Require(types.Intern("Int"), {8, 8, ""});
+
+    qbe::IrEmitter out;
+    table.Emit(out);
+    return out.Contents();
+  };
+
+  CHECK(emit({"Int", "Bool"}) == emit({"Bool", "Int"}));
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -0,0 +1,528 @@
+#include <opt/escape_analysis.hpp>
+#include <opt/switch_lowering.hpp>
+#include <opt/stack_slots.hpp>
+#include <opt/dead_code.hpp>
+#include <opt/opt_error.hpp>
+
+#include <stats/stats.hpp>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+#include <string_view>
+#include <string>
+#include <vector>
+#include <array>
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Escape: local temporaries", "[opt]") {
+  opt::EscapeAnalysis escape;
+
+  // var t = new Pair; var p = t; p->left = g(); return p->right;
+  auto tmp = escape.NewAllocation(16);
+  auto ptr = escape.NewValue();
+  escape.Copy(ptr, tmp);
+  escape.Store(ptr, escape.NewUnknown());
+
+  auto right = escape.NewValue();
+  escape.Load(right, ptr);
+  escape.Escape(right);
+
+  CHECK(escape.OnStack(tmp));
+  CHECK(escape.StackAllocations() == 1);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Escape: returned and stored", "[opt]") {
+  opt::EscapeAnalysis escape;
+
+  // return new Int;
+  auto returned = escape.NewAllocation(16);
+  escape.Escape(returned);
+
+  // global->next = new Node;
+  auto stored = escape.NewAllocation(16);
+  escape.Store(escape.NewUnknown(), stored);
+
+  // var box = new Box; box->item = new Item; consume(box);
+  auto box = escape.NewAllocation(16);
+  auto item = escape.NewAllocation(16);
+  escape.Store(box, item);
+  escape.Escape(box);
+
+  // var a = new A; a->b = new B; return a->b;
+  auto a = escape.NewAllocation(16);
+  auto b = escape.NewAllocation(16);
+  escape.Store(a, b);
+  auto loaded = escape.NewValue();
+  escape.Load(loaded, a);
+  escape.Escape(loaded);
+
+  CHECK_FALSE(escape.OnStack(returned));
+  CHECK_FALSE(escape.OnStack(stored));
+  CHECK_FALSE(escape.OnStack(box));
+  CHECK_FALSE(escape.OnStack(item));
+  CHECK_FALSE(escape.OnStack(b));
+
+  // `a` itself is never handed out
+  CHECK(escape.OnStack(a));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Escape: aliasing through parameters", "[opt]") {
+  opt::EscapeAnalysis escape;
+
+  // fun f out = { var p = out; var n = new Node; p->next = n; }
+  auto out = escape.NewUnknown();
+  auto p = escape.NewValue();
+  auto n = escape.NewAllocation(16);
+
+  escape.Store(p, n);
+  CHECK(escape.OnStack(n));
+
+  // Learned after the store: p aliases the parameter
+  escape.Copy(p, out);
+  CHECK_FALSE(escape.OnStack(n));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Escape: loops and long chains", "[opt]") {
+  opt::EscapeAnalysis escape;
+
+  // var head = 0; while ... { head = new Node { .next = head } }
+  auto head = escape.NewValue();
+  auto node = escape.NewAllocation(16, /*in_loop=*/true);
+  escape.Store(node, head);
+  escape.Copy(head, node);
+  CHECK_FALSE(escape.OnStack(node));
+
+  // A literal list a0 -> a1 -> ... -> a9999, the last one escapes
+  std::vector<opt::EscapeAnalysis::ValueId> chain;
+  for (int i = 0; i < 10000; i++) {
+    chain.push_back(escape.NewAllocation(16));
+    if (i > 0) {
+      escape.Store(chain[i - 1], chain[i]);
+    }
+  }
+  escape.Escape(chain[5000]);
+
+  CHECK(escape.OnStack(chain[0]));
+  CHECK(escape.OnStack(chain[4999]));
+  CHECK_FALSE(escape.OnStack(chain[5000]));
+  CHECK_FALSE(escape.OnStack(chain[9999]));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Escape: large objects", "[opt]") {
+  opt::EscapeAnalysis escape;
+
+  // None of these escape; only the first fits a stack slot
+  auto page = escape.NewAllocation(opt::kMaxStackAllocation);
+  auto larger = escape.NewAllocation(opt::kMaxStackAllocation + 1);
+  auto array = escape.NewAllocation(opt::EscapeAnalysis::kUnknownSize);
+
+  CHECK(escape.OnStack(page));
+  CHECK_FALSE(escape.OnStack(larger));
+  CHECK_FALSE(escape.OnStack(array));
+  CHECK(escape.StackAllocations() == 1);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Escape: lowering of new", "[opt]") {
+  qbe::IrEmitter out;
+
+  auto dst = qbe::QbeValue::Temporary(1);
+  opt::EmitNew(out, dst, 24, 8, true);
+  opt::EmitNew(out, dst, 24, 8, false);
+  opt::EmitNew(out, dst, 1 << 20, 8, true);
+  opt::EmitNew(out, dst, 24, 8, false, opt::Allocator::BUMP);
+
+  CHECK(out.Contents() ==
+        "\t%.1 =l alloc8 24\n"
+        "\t%.1 =l call $malloc(l 24)\n"
+        "\t%.1 =l call $malloc(l 1048576)\n"
+        "\t%.1 =l call $etude_alloc(l 24)\n");
+
+  CHECK(opt::ParseAllocator("bump") == opt::Allocator::BUMP);
+  CHECK_FALSE(opt::ParseAllocator("arena"));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static std::vector<opt::ChainLink> CharChain(std::string_view letters) {
+  std::vector<opt::ChainLink> chain;
+  for (char c : letters) {
+    opt::ChainLink link;
+    link.is_equality = true;
+    link.variable = "c";
+    link.literal = c;
+    link.target = fmt::format("is_{}", c);
+    link.result = c - 'a';
+    chain.push_back(link);
+  }
+  return chain;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Switch: chain recognition", "[opt]") {
+  // if c == 'd' ... else if c == 'a' ... else if c == 'b' ... 'c' 'a'
+  auto chain = CharChain("dabca");
+
+  opt::ChainLink other;
+  other.variable = "c";
+  other.target = "is_upper";  // c >= 'A' && c <= 'Z'
+  chain.push_back(other);
+
+  auto plan = opt::RecognizeChain(chain);
+  REQUIRE(plan);
+
+  CHECK(plan->variable == "c");
+  CHECK(plan->consumed == 5);
+  CHECK(plan->cases.size() == 4);  // the second 'a' is dead
+  CHECK(plan->Min() == 'a');
+  CHECK(plan->cases[0].label == "is_a");
+  CHECK(plan->strategy == opt::SwitchPlan::Strategy::TABLE);
+
+  // Too short, or another variable in between
+  CHECK_FALSE(opt::RecognizeChain(CharChain("abc")));
+
+  auto mixed = CharChain("abcd");
+  mixed[2].variable = "d";
+  CHECK_FALSE(opt::RecognizeChain(mixed));
+
+  // Sparse
+  auto sparse = CharChain("aeimqu");
+  CHECK(opt::RecognizeChain(sparse)->strategy ==
+        opt::SwitchPlan::Strategy::BINARY_SEARCH);
+
+  // The whole int64 range: its size does not fit, so no table
+  auto extremes = CharChain("abcd");
+  extremes[0].literal = INT64_MIN;
+  extremes[3].literal = INT64_MAX;
+  CHECK(opt::RecognizeChain(extremes)->strategy ==
+        opt::SwitchPlan::Strategy::BINARY_SEARCH);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Switch: lookup table", "[opt]") {
+  auto plan = opt::RecognizeChain(CharChain("abde"));
+  REQUIRE(plan);
+
+  size_t next = 1;
+  auto fresh = [&] {
+    return qbe::QbeValue::Temporary(next++);
+  };
+
+  qbe::IrEmitter out;
+  qbe::IrEmitter data;
+  auto dst = qbe::QbeValue::Temporary(100);
+
+  REQUIRE(opt::EmitLookupTable(out, data, *plan, qbe::QbeValue::Temporary(0),
+                               -1, dst, "letters", fresh));
+
+  CHECK(data.Contents() == "data $letters = { l 0, l 1, l -1, l 3, l 4 }\n");
+  CHECK(out.Contents() ==
+        "\t%.1 =l sub %.0, 97\n"
+        "\t%.2 =w cultl %.1, 5\n"
+        "\t%.100 =l copy -1\n"
+        "\tjnz %.2, @letters.hit, @letters.done\n"
+        "@letters.hit\n"
+        "\t%.3 =l mul %.1, 8\n"
+        "\t%.4 =l add $letters, %.3\n"
+        "\t%.100 =l loadl %.4\n"
+        "@letters.done\n");
+
+  // A branch that does more than produce a constant
+  auto control = *plan;
+  control.results[1].reset();
+  CHECK_FALSE(opt::EmitLookupTable(out, data, control,
+                                   qbe::QbeValue::Temporary(0), -1, dst,
+                                   "letters", fresh));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Stack slots: scalar promotion", "[opt]") {
+  auto function =
+      "function w $f(w %.0) {\n"
+      "@start\n"
+      "\t%x =l alloc4 4\n"
+      "\tstorew %.0, %x\n"
+      "\t%.1 =w loadw %x\n"
+      "\t%.2 =w add %.1, 1\n"
+      "\tstorew %.2, %x\n"
+      "\t%.3 =w loadw %x\n"
+      "\tret %.3\n"
+      "}";
+
+  opt::SlotReport report;
+  CHECK(opt::OptimizeStackSlots(function, &report) ==
+        "function w $f(w %.0) {\n"
+        "@start\n"
+        "\t%x.v =w copy 0\n"
+        "\t%x.v =w copy %.0\n"
+        "\t%.1 =w copy %x.v\n"
+        "\t%.2 =w add %.1, 1\n"
+        "\t%x.v =w copy %.2\n"
+        "\t%.3 =w copy %x.v\n"
+        "\tret %.3\n"
+        "}");
+
+  CHECK(report.promoted == 1);
+  CHECK(report.frame_before == 4);
+  CHECK(report.frame_after == 0);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Stack slots: address taken", "[opt]") {
+  auto function =
+      "function w $f() {\n"
+      "@start\n"
+      "\t%x =l alloc4 4\n"
+      "\t%y =l alloc8 8\n"
+      "\tstorew 1, %x\n"
+      "\tcall $g(l %x)\n"
+      "\tstorew 2, %y\n"
+      "\t%.1 =w loadw %y\n"
+      "\tret %.1\n"
+      "}";
+
+  opt::SlotReport report;
+  auto result = opt::OptimizeStackSlots(function, &report);
+
+  // %x escapes into the call, %y is read narrower than its size
+  CHECK(result == function);
+  CHECK(report.promoted == 0);
+  CHECK(report.merged == 0);
+  CHECK(report.frame_after == 12);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Stack slots: disjoint aggregates share", "[opt]") {
+  auto function =
+      "function l $f() {\n"
+      "@start\n"
+      "\t%a =l alloc8 16\n"
+      "\t%b =l alloc8 16\n"
+      "\t%c =l alloc8 16\n"
+      "\tstorel 1, %a\n"
+      "\t%a.1 =l add %a, 8\n"
+      "\tstorel 2, %a.1\n"
+      "\t%.1 =l loadl %a.1\n"
+      "\tstorel 3, %b\n"
+      "\t%b.1 =l add %b, 8\n"
+      "\tstorel %.1, %b.1\n"
+      "\tstorel 4, %c\n"
+      "\t%c.1 =l add %c, 8\n"
+      "\tstorel 5, %c.1\n"
+      "\t%.2 =l loadl %b\n"
+      "\t%.3 =l loadl %c.1\n"
+      "\t%.4 =l add %.2, %.3\n"
+      "\tret %.4\n"
+      "}";
+
+  opt::SlotReport report;
+  auto result = opt::OptimizeStackSlots(function, &report);
+
+  // %a is dead once %b starts; %b and %c overlap
+  CHECK(result ==
+        "function l $f() {\n"
+        "@start\n"
+        "\t%a =l alloc8 16\n"
+        "\t%c =l alloc8 16\n"
+        "\tstorel 1, %a\n"
+        "\t%a.1 =l add %a, 8\n"
+        "\tstorel 2, %a.1\n"
+        "\t%.1 =l loadl %a.1\n"
+        "\tstorel 3, %a\n"
+        "\t%b.1 =l add %a, 8\n"
+        "\tstorel %.1, %b.1\n"
+        "\tstorel 4, %c\n"
+        "\t%c.1 =l add %c, 8\n"
+        "\tstorel 5, %c.1\n"
+        "\t%.2 =l loadl %a\n"
+        "\t%.3 =l loadl %c.1\n"
+        "\t%.4 =l add %.2, %.3\n"
+        "\tret %.4\n"
+        "}");
+
+  CHECK(report.merged == 1);
+  CHECK(report.frame_before == 48);
+  CHECK(report.frame_after == 32);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Stack slots: liveness across loops", "[opt]") {
+  auto function = std::string{
+      "function l $f(l %.0) {\n"
+      "@start\n"
+      "\t%a =l alloc8 16\n"
+      "\t%b =l alloc8 16\n"
+      "\tstorel %.0, %a\n"
+      "@loop\n"
+      "\t%.1 =l loadl %a\n"
+      "\tstorel %.1, %b\n"
+      "\t%.2 =l loadl %b\n"
+      "\t%.3 =l sub %.2, 1\n"
+      "\tstorel %.3, %a\n"
+      "\tjnz %.3, @loop, @done\n"
+      "@done\n"
+      "\tret 0\n"
+      "}"};
+
+  // %a is read again on the back edge while %b is in use
+  opt::SlotReport report;
+  CHECK(opt::OptimizeStackSlots(function, &report) == function);
+  CHECK(report.merged == 0);
+
+  // Without the back edge %a is dead once copied into %b
+  auto straight = function;
+  straight.replace(straight.find("@loop, @done"), 12, "@done, @done");
+
+  auto result = opt::OptimizeStackSlots(straight, &report);
+  CHECK(report.merged == 1);
+  CHECK(result.find("%b") == std::string::npos);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Stack slots: dead stores", "[opt]") {
+  auto function =
+      "function w $f() {\n"
+      "@start\n"
+      "\t%b =l alloc4 4\n"
+      "\t%a =l alloc4 4\n"
+      "\tstorew 7, %b\n"
+      "\tstoreb 1, %a\n"
+      "\t%x =w loadub %b\n"
+      "\tret %x\n"
+      "}";
+
+  // %a is never read, but storing into it while %b holds the 7 must
+  // not land in %b
+  opt::SlotReport report;
+  CHECK(opt::OptimizeStackSlots(function, &report) == function);
+  CHECK(report.merged == 0);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Dead code: call graph", "[opt]") {
+  FlatTree tree;
+  std::vector<FlatIndex> decls;
+
+  auto call = [&](std::string_view callee) {
+    return tree.AddExprStatement(
+        tree.AddCall(tree.AddVar(callee), std::span<const FlatIndex>{}));
+  };
+  auto fun = [&](std::string_view name, std::vector<FlatIndex> body) {
+    decls.push_back(tree.AddFunDecl(name, {}, tree.AddBlock(body)));
+  };
+
+  // var limit = 10; var unused_global = 0;
+  decls.push_back(tree.AddVarDecl("limit", tree.AddInt(10)));
+  decls.push_back(tree.AddVarDecl("unused_global", tree.AddInt(0)));
+
+  // fun helper() { limit; }      fun main() { helper(); }
+  // fun api() { if limit < 1 { twin() } }   (exported)
+  // fun twin() { api(); }        fun orphan() { orphan2(); }
+  // fun orphan2() { orphan(); }
+  fun("helper", {tree.AddExprStatement(tree.AddVar("limit"))});
+  fun("main", {call("helper")});
+  fun("api", {tree.AddIf(tree.AddBinary(FlatOp::LT, tree.AddVar("limit"),
+                                        tree.AddInt(1)),
+                         call("twin"), kNoNode)});
+  fun("twin", {call("api")});
+  fun("orphan", {call("orphan2")});
+  fun("orphan2", {call("orphan")});
+
+  std::array<std::string_view, 1> exported{"api"};
+
+  auto graph = opt::BuildCallGraph(tree, decls, exported);
+  CHECK(graph.Size() == 8);
+  CHECK(graph.Find("twin") == 5u);
+  CHECK(graph.KindOf(0) == opt::CallGraph::Kind::GLOBAL);
+
+  auto dead_before = stats::Value(stats::Counter::DEAD_FUNCTIONS);
+
+  opt::DeadCodeReport report;
+  auto live = opt::RemoveDeadDeclarations(tree, decls, exported, &report);
+
+  if (stats::kEnabled) {
+    CHECK(stats::Value(stats::Counter::DEAD_FUNCTIONS) - dead_before == 2);
+  }
+
+  CHECK(report.functions == std::vector<std::string>{"orphan", "orphan2"});
+  CHECK(report.globals == std::vector<std::string>{"unused_global"});
+
+  std::vector<std::string_view> kept;
+  for (auto decl : live) {
+    kept.push_back(tree.Name(decl));
+  }
+  CHECK(kept == std::vector<std::string_view>{"limit", "helper", "main",
+                                              "api", "twin"});
+
+  // Nothing exported: only main and what it uses
+  auto program = opt::RemoveDeadDeclarations(tree, decls, {}, &report);
+  CHECK(program.size() == 3);
+  CHECK(report.functions ==
+        std::vector<std::string>{"api", "twin", "orphan", "orphan2"});
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Dead code: initializers and duplicates", "[opt]") {
+  FlatTree tree;
+  std::vector<FlatIndex> decls;
+
+  auto fun = [&](std::string_view name) {
+    decls.push_back(tree.AddFunDecl(name, {}, tree.AddBlock({})));
+  };
+
+  // var seed = init(); var mask = -(1 + 2); var copy = mask;
+  // fun init() {}  fun main() {}
+  decls.push_back(tree.AddVarDecl(
+      "seed", tree.AddCall(tree.AddVar("init"), std::span<const FlatIndex>{})));
+  decls.push_back(tree.AddVarDecl(
+      "mask", tree.AddUnary(FlatOp::NEG, tree.AddBinary(FlatOp::ADD,
+                                                        tree.AddInt(1),
+                                                        tree.AddInt(2)))));
+  decls.push_back(tree.AddVarDecl("copy", tree.AddVar("mask")));
+  fun("init");
+  fun("main");
+
+  // Unused, but the initializers of `seed` and `copy` are not
+  // constants: they stay, and `init` and `mask` with them
+  opt::DeadCodeReport report;
+  auto live = opt::RemoveDeadDeclarations(tree, decls, {}, &report);
+  CHECK(live.size() == 5);
+  CHECK(report.globals.empty());
+  CHECK(report.functions.empty());
+
+  // With constant initializers all three go, and `init` with them
+  decls[0] = tree.AddVarDecl("seed", tree.AddInt(7));
+  decls[2] = tree.AddVarDecl("copy", tree.AddInt(8));
+  opt::RemoveDeadDeclarations(tree, decls, {}, &report);
+  CHECK(report.globals ==
+        std::vector<std::string>{"seed", "mask", "copy"});
+  CHECK(report.functions == std::vector<std::string>{"init"});
+
+  // fun main() {} declared twice
+  decls.push_back(tree.AddFunDecl("main", {}, tree.AddBlock({}),
+                                  lex::Location{9, 0}));
+  CHECK_THROWS_AS(opt::BuildCallGraph(tree, decls, {}),
+                  opt::errors::DuplicateSymbolError);
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -0,0 +1,340 @@
+#include <parse/operator_precedence.hpp>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+#include <string_view>
+#include <optional>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+
+// Arithmetic over single characters, printed as s-expressions:
+// digits and letters are operands, `-` `!` prefixes, `+ - * / ^`
+// binary (`^` right-associative), `.x` postfix field access.
+
+class CharSource {
+ public:
+  explicit CharSource(std::string_view text) : text_{text} {
+  }
+
+  std::optional<int> MatchPrefix() {
+    if (Peek() == '-' || Peek() == '!') {
+      return text_[pos_++];
+    }
+    return std::nullopt;
+  }
+
+  bool MatchOpenParen() {
+    return Match('(');
+  }
+
+  bool MatchCloseParen() {
+    return Match(')');
+  }
+
+  std::optional<parse::BinaryOperator> PeekBinary() {
+    switch (Peek()) {
+      case '+':
+      case '-':
+        return parse::BinaryOperator{Peek(), 1, false};
+      case '*':
+      case '/':
+        return parse::BinaryOperator{Peek(), 2, false};
+      case '^':
+        return parse::BinaryOperator{Peek(), 3, true};
+      default:
+        return std::nullopt;
+    }
+  }
+
+  void ConsumeBinary() {
+    pos_ += 1;
+  }
+
+  std::string ParseOperand() {
+    if (!std::isalnum(static_cast<unsigned char>(Peek()))) {
+      throw parse::errors::ParsePrimaryError{lex::Location{0, pos_}};
+    }
+    return std::string(1, text_[pos_++]);
+  }
+
+  std::string ParsePostfix(std::string node) {
+    while (Peek() == '.' && pos_ + 1 < text_.size()) {
+      node = "(. " + node + " " + text_[pos_ + 1] + ")";
+      pos_ += 2;
+    }
+    return node;
+  }
+
+  std::string MakeUnary(int op, std::string operand) {
+    return std::string{"("} + static_cast<char>(op) + " " + operand + ")";
+  }
+
+  std::string MakeBinary(const parse::BinaryOperator& op, std::string lhs,
+                         std::string rhs) {
+    return std::string{"("} + static_cast<char>(op.token) + " " + lhs + " " +
+           rhs + ")";
+  }
+
+  [[noreturn]] void MissingCloseParen() {
+    throw parse::errors::ParseTokenError{lex::TokenType{},
+                                         lex::Location{0, pos_}};
+  }
+
+  size_t Position() const {
+    return pos_;
+  }
+
+ private:
+  char Peek() const {
+    return pos_ < text_.size() ? text_[pos_] : '\0';
+  }
+
+  bool Match(char ch) {
+    if (Peek() == ch) {
+      pos_ += 1;
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  std::string_view text_;
+  size_t pos_ = 0;
+};
+
+static std::string Parse(std::string_view text) {
+  CharSource source{text};
+  return parse::ParseOperatorExpression<std::string>(source);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Operator precedence: shapes", "[parse]") {
+  CHECK(Parse("1") == "1");
+  CHECK(Parse("1+2*3") == "(+ 1 (* 2 3))");
+  CHECK(Parse("1*2+3") == "(+ (* 1 2) 3)");
+  CHECK(Parse("1-2-3") == "(- (- 1 2) 3)");
+  CHECK(Parse("2^3^4") == "(^ 2 (^ 3 4))");
+  CHECK(Parse("(1+2)*3") == "(* (+ 1 2) 3)");
+  CHECK(Parse("-a*b") == "(* (- a) b)");
+  CHECK(Parse("--a") == "(- (- a))");
+  CHECK(Parse("-a.b.c") == "(- (. (. a b) c))");
+  CHECK(Parse("-(a+b).c") == "(- (. (+ a b) c))");
+  CHECK(Parse("!(((a)))") == "(! a)");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Operator precedence: boundaries", "[parse]") {
+  // A `)` it did not open is left for the caller: `f(a + b)`
+  CharSource call{"a+b)"};
+  CHECK(parse::ParseOperatorExpression<std::string>(call) == "(+ a b)");
+  CHECK(call.Position() == 3);
+
+  CHECK_THROWS_AS(Parse("(a+b"), parse::errors::ParseTokenError);
+  CHECK_THROWS_AS(Parse("a+"), parse::errors::ParsePrimaryError);
+  CHECK_THROWS_AS(Parse("(+a)"), parse::errors::ParsePrimaryError);
+
+  // Weaker operators outside its own parens are left for the caller
+  parse::ExpressionStacks<std::string> stacks;
+
+  CharSource unary{"-a.b*c"};
+  CHECK(parse::ParseOperatorExpression(unary, stacks, parse::kNoOperators) ==
+        "(- (. a b))");
+  CHECK(unary.Position() == 4);
+
+  CharSource grouped{"(a+b)*c+d"};
+  CHECK(parse::ParseOperatorExpression(grouped, stacks, 2) ==
+        "(* (+ a b) c)");
+  CHECK(grouped.Position() == 7);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Operator precedence: shared stacks", "[parse]") {
+  parse::ExpressionStacks<std::string> stacks;
+  stacks.operands.push_back("caller");
+
+  CharSource broken{"(a*(b+c"};
+  CHECK_THROWS(parse::ParseOperatorExpression(broken, stacks));
+  CHECK(stacks.operands.size() == 1);
+  CHECK(stacks.pending.empty());
+
+  CharSource fine{"a*(b+c)"};
+  CHECK(parse::ParseOperatorExpression(fine, stacks) == "(* a (+ b c))");
+  CHECK(stacks.operands == std::vector<std::string>{"caller"});
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Operator precedence: deep nesting", "[parse]") {
+  static constexpr size_t kDepth = 100'000;
+
+  // Counting nodes rather than printing a 100k-deep string
+  struct Counter : CharSource {
+    using CharSource::CharSource;
+
+    size_t ParseOperand() {
+      CharSource::ParseOperand();
+      return 1;
+    }
+    size_t ParsePostfix(size_t node) {
+      return node;
+    }
+    size_t MakeUnary(int, size_t operand) {
+      return operand + 1;
+    }
+    size_t MakeBinary(const parse::BinaryOperator&, size_t lhs, size_t rhs) {
+      return lhs + rhs + 1;
+    }
+  };
+
+  auto parens = std::string(kDepth, '(') + "1" + std::string(kDepth, ')');
+  Counter grouped{parens};
+  CHECK(parse::ParseOperatorExpression<size_t>(grouped) == 1);
+
+  auto unary = std::string(kDepth, '-') + "1";
+  Counter negated{unary};
+  CHECK(parse::ParseOperatorExpression<size_t>(negated) == kDepth + 1);
+
+  std::string right;
+  for (size_t i = 0; i < kDepth; i++) {
+    right += "1^";
+  }
+  right += "1";
+  Counter chain{right};
+  CHECK(parse::ParseOperatorExpression<size_t>(chain) == 2 * kDepth + 1);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// How a recursive-descent parser uses it: its own recursion for
+// ordinary input, the explicit stacks once the depth runs out
+
+class Descent {
+ public:
+  explicit Descent(CharSource& source) : source_{source} {
+  }
+
+  std::string Expression(size_t depth = 0, int level = 1) {
+    if (level == 3) {
+      return Power(depth);
+    }
+
+    auto lhs = Expression(depth, level + 1);
+    while (auto op = source_.PeekBinary()) {
+      if (op->precedence != level) {
+        break;
+      }
+      source_.ConsumeBinary();
+      lhs = source_.MakeBinary(*op, lhs, Expression(depth, level + 1));
+    }
+    return lhs;
+  }
+
+ private:
+  // Right-associative: the right operand is the same level again
+  std::string Power(size_t depth) {
+    auto lhs = Unary(depth);
+
+    auto op = source_.PeekBinary();
+    if (!op || op->precedence != 3) {
+      return lhs;
+    }
+    source_.ConsumeBinary();
+
+    auto rhs = depth < parse::kRecursionDepth
+                   ? Power(depth + 1)
+                   : parse::ParseOperatorExpression(source_, stacks_, 3);
+    return source_.MakeBinary(*op, lhs, rhs);
+  }
+
+  std::string Unary(size_t depth) {
+    if (auto prefix = source_.MatchPrefix()) {
+      auto operand = depth < parse::kRecursionDepth
+                         ? Unary(depth + 1)
+                         : parse::ParseOperatorExpression(
+                               source_, stacks_, parse::kNoOperators);
+      return source_.MakeUnary(*prefix, operand);
+    }
+
+    if (source_.MatchOpenParen()) {
+      auto inner = depth < parse::kRecursionDepth
+                       ? Expression(depth + 1)
+                       : parse::ParseOperatorExpression(source_, stacks_);
+      if (!source_.MatchCloseParen()) {
+        source_.MissingCloseParen();
+      }
+      return source_.ParsePostfix(inner);
+    }
+
+    return source_.ParsePostfix(source_.ParseOperand());
+  }
+
+ private:
+  CharSource& source_;
+  parse::ExpressionStacks<std::string> stacks_;
+};
+
+static std::string ParseDescent(std::string_view text) {
+  CharSource source{text};
+  return Descent{source}.Expression();
+}
+
+TEST_CASE("Operator precedence: past the recursion limit", "[parse]") {
+  static constexpr size_t kLevels = 4 * parse::kRecursionDepth;
+
+  for (auto text : {"1+2*3", "1-2-3", "2^3^4", "(1+2)*3", "-a.b.c",
+                    "-(a+b).c", "!(((a)))", "a*-b^c.d"}) {
+    CHECK(ParseDescent(text) == Parse(text));
+  }
+
+  // Prefixes and parens, then operators of every level closing them
+  std::string nested;
+  for (size_t i = 0; i < kLevels; i++) {
+    nested += "-(";
+  }
+  nested += "a";
+  for (size_t i = 0; i < kLevels; i++) {
+    nested += "+b^c*d)";
+  }
+  nested += "-e";
+  CHECK(ParseDescent(nested) == Parse(nested));
+
+  // A right-associative chain, then weaker operators after it
+  std::string chain;
+  for (size_t i = 0; i < kLevels; i++) {
+    chain += "b^";
+  }
+  chain += "a*c+d";
+  CHECK(ParseDescent(chain) == Parse(chain));
+
+  // Errors past the limit surface the same way
+  auto broken = std::string(kLevels, '(') + "a+";
+  CHECK_THROWS_AS(ParseDescent(broken), parse::errors::ParsePrimaryError);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Nesting guard", "[parse]") {
+  size_t depth = 0;
+
+  auto descend = [&](auto& self, size_t levels) -> void {
+    parse::NestingGuard guard{depth, lex::Location{}};
+    if (levels > 0) {
+      self(self, levels - 1);
+    }
+  };
+
+  descend(descend, parse::NestingGuard::kMaxDepth - 1);
+  CHECK(depth == 0);
+
+  CHECK_THROWS_AS(descend(descend, parse::NestingGuard::kMaxDepth),
+                  parse::errors::ParseNestingError);
+  CHECK(depth == 0);
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -0,0 +1,194 @@
+#include <pgo/decisions.hpp>
+#include <pgo/pgo_error.hpp>
+#include <pgo/counters.hpp>
+
+#include <driver/process.hpp>
+
+#include <etude_rt.h>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <cstdlib>
+#include <unistd.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("PGO: counters", "[pgo]") {
+  pgo::CounterTable table{"my-app"};
+  table.AddFunction("main");
+  table.AddFunction("fib");
+
+  auto& fib = table.Function(1);
+  CHECK(fib.AddSite(2) == 0);
+  CHECK(fib.AddSite(3) == 1);
+  CHECK(fib.CounterCount() == 6);
+  CHECK(table.Function(0).CounterCount() == 1);
+
+  qbe::IrEmitter code;
+  fib.EmitArm(code, 1, 2);
+  CHECK(code.Contents() ==
+        "\t%.prof =l add $etude_prof.my_app.1.counters, 40\n"
+        "\t%.prof.n =l loadl %.prof\n"
+        "\t%.prof.n =l add %.prof.n, 1\n"
+        "\tstorel %.prof.n, %.prof\n");
+
+  qbe::IrEmitter data;
+  table.EmitData(data);
+  std::string text{data.Contents()};
+
+  CHECK(text.find("data $etude_prof.my_app.1.counters = align 8 { z 48 }") !=
+        text.npos);
+  CHECK(text.find("data $etude_prof.my_app.1.arms = align 4 { w 2 3 }") !=
+        text.npos);
+  CHECK(text.find("export data $etude_prof.my_app = align 8 { "
+                  "l $etude_prof.my_app.0, l $etude_prof.my_app.1, l 0 }") !=
+        text.npos);
+
+  qbe::IrEmitter list;
+  std::vector<std::string> modules{"my-app", "util"};
+  pgo::EmitModuleList(list, modules);
+  CHECK(list.Contents() ==
+        "export data $etude_prof_modules = align 8 { "
+        "l $etude_prof.my_app, l $etude_prof.util, l 0 }\n"
+        "data $etude_prof.init = align 8 { l $etude_prof_init }\n");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("PGO: runtime dump and profile", "[pgo]") {
+  auto path = std::filesystem::temp_directory_path() /
+              fmt::format("etude-{}.profile", ::getpid());
+  std::filesystem::remove(path);
+
+  // What the generated data looks like for
+  //   fun main() { ... }           (ran once)
+  //   fun fib(n) { if ... match }  (ran 10 times)
+  //   fun unused() { ... }
+  uint64_t main_counters[] = {1};
+  uint64_t fib_counters[] = {10, 3, 7, 0, 1, 9};
+  uint64_t unused_counters[] = {0};
+  uint32_t fib_arms[] = {2, 3};
+
+  EtudeProfFunction main_fun{"app", "main", main_counters, nullptr, 0};
+  EtudeProfFunction fib_fun{"app", "fib", fib_counters, fib_arms, 2};
+  EtudeProfFunction unused_fun{"app", "unused", unused_counters, nullptr, 0};
+
+  const EtudeProfFunction* app[] = {&main_fun, &fib_fun, &unused_fun,
+                                    nullptr};
+  const EtudeProfFunction* const* modules[] = {app, nullptr};
+
+  // Two runs
+  REQUIRE(etude_prof_write(path.c_str(), modules) == 0);
+  REQUIRE(etude_prof_write(path.c_str(), modules) == 0);
+
+  auto profile = pgo::ReadProfile(path);
+  std::filesystem::remove(path);
+
+  CHECK(profile.FunctionCount() == 2);
+  CHECK(profile.EntryCount("app", "fib") == 20);
+  CHECK(profile.MaxEntryCount() == 20);
+  CHECK(profile.ArmCounts("app", "fib", 0) == std::vector<uint64_t>{6, 14});
+  CHECK(profile.ArmCounts("app", "fib", 1) ==
+        std::vector<uint64_t>{0, 2, 18});
+  CHECK(profile.ArmCounts("app", "fib", 2).empty());
+  CHECK(profile.Find("app", "unused") == nullptr);
+
+  CHECK_THROWS_AS(pgo::ReadProfile(path), pgo::errors::ProfileReadError);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+#ifdef ETUDE_RUNTIME
+
+TEST_CASE("PGO: dump linked from the runtime archive", "[pgo]") {
+  auto dir = std::filesystem::temp_directory_path() /
+             fmt::format("etude-{}-archive", ::getpid());
+  std::filesystem::create_directories(dir);
+  auto source = dir / "main.c";
+  auto binary = dir / "main";
+  auto path = dir / "etude.profile";
+
+  // The C spelling of an instrumented program plus the list from
+  // pgo::EmitModuleList; nothing in it calls into the runtime
+  std::ofstream{source} << R"(
+    #include <stdint.h>
+    extern void etude_prof_init(void);
+    struct Fun { const char* m; const char* f; uint64_t* c;
+                 const uint32_t* a; uint32_t n; };
+    static uint64_t counters[] = {0};
+    static struct Fun fun = {"app", "main", counters, 0, 0};
+    static const struct Fun* app[] = {&fun, 0};
+    const struct Fun* const* const etude_prof_modules[] = {app, 0};
+    __attribute__((used)) static void (*const init)(void) = etude_prof_init;
+    int main(void) { counters[0]++; return 0; }
+  )";
+
+  REQUIRE(driver::RunProcess({"cc", source.string(), ETUDE_RUNTIME, "-o",
+                              binary.string()}) == 0);
+  ::setenv("ETUDE_PROFILE", path.c_str(), 1);
+  int status = driver::RunProcess({binary.string()});
+  ::unsetenv("ETUDE_PROFILE");
+  REQUIRE(status == 0);
+
+  auto profile = pgo::ReadProfile(path);
+  std::filesystem::remove_all(dir);
+  CHECK(profile.EntryCount("app", "main") == 1);
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("PGO: malformed profiles", "[pgo]") {
+  pgo::Profile profile;
+  profile.Merge("# comment\n\napp main entry 5\n");
+  CHECK(profile.EntryCount("app", "main") == 5);
+
+  for (auto bad : {"app main entry\n", "app main entry five\n",
+                   "app main 1 5\n", "app main 1.x 5\n",
+                   "app  main entry 5\n", "app main entry 5 6\n"}) {
+    CHECK_THROWS_AS(profile.Merge(bad), pgo::errors::ProfileFormatError);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("PGO: decisions", "[pgo]") {
+  pgo::Profile profile;
+  profile.Merge(
+      "app main entry 1\n"
+      "app fib entry 1000\n"
+      "app log entry 5\n");
+
+  std::vector<std::string> funs{"main", "unused", "log", "fib", "init"};
+  CHECK(pgo::HotFirstOrder(profile, "app", funs) ==
+        std::vector<size_t>{3, 2, 0, 1, 4});
+  CHECK(pgo::HotFirstOrder(profile, "other", funs) ==
+        std::vector<size_t>{0, 1, 2, 3, 4});
+
+  std::vector<uint64_t> counts{3, 90, 7};
+  CHECK(pgo::ArmLayout(counts, 3) == std::vector<uint32_t>{1, 2, 0});
+  CHECK(pgo::ArmLayout({}, 2) == std::vector<uint32_t>{0, 1});
+  CHECK(pgo::ArmLayout(counts, 2) == std::vector<uint32_t>{0, 1});
+
+  pgo::InlineAdvisor advisor{&profile};
+  CHECK(advisor.ShouldInline(500, 50));   // hot
+  CHECK_FALSE(advisor.ShouldInline(5, 50));
+  CHECK(advisor.ShouldInline(5, 10));
+  CHECK_FALSE(advisor.ShouldInline(0, 10));  // never ran
+  CHECK(advisor.ShouldInline(0, 3));
+  CHECK(advisor.ShouldInline(std::nullopt, 16));  // no counts
+  CHECK_FALSE(advisor.ShouldInline(std::nullopt, 17));
+
+  pgo::InlineAdvisor blind{nullptr};
+  CHECK(blind.ShouldInline(0, 16));
+  CHECK_FALSE(blind.ShouldInline(1000, 17));
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -0,0 +1,148 @@
+#include <qbe/ir_emitter.hpp>
+#include <qbe/qbe_process.hpp>
+#include <qbe/qbe_value.hpp>
+#include <qbe/switch.hpp>
+
+#include <unistd.h>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+
+static std::string ReadAll(int fd) {
+  std::string result;
+  char chunk[256];
+
+  ssize_t n;
+  while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) {
+    result.append(chunk, n);
+  }
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("QbeValue formatting", "[qbe]") {
+  CHECK(fmt::format("{}", qbe::QbeValue::Temporary(3)) == "%.3");
+  CHECK(fmt::format("{}", qbe::QbeValue::Global("main")) == "$main");
+  CHECK(fmt::format("{}", qbe::QbeValue::Const(-5)) == "-5");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Emitter: in memory", "[qbe]") {
+  qbe::IrEmitter out;
+
+  out.Emit("function w ${}() {{", "main");
+  out.Emit("@start");
+  out.EmitInstr("{} =w add {}, {}", qbe::QbeValue::Temporary(1),
+                qbe::QbeValue::Const(1), qbe::QbeValue::Const(2));
+  out.EmitInstr("ret {}", qbe::QbeValue::Temporary(1));
+  out.Emit("}}");
+
+  CHECK(out.Contents() ==
+        "function w $main() {\n"
+        "@start\n"
+        "\t%.1 =w add 1, 2\n"
+        "\tret %.1\n"
+        "}\n");
+
+  out.Clear();
+  CHECK(out.Contents().empty());
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Emitter: flushes to fd", "[qbe]") {
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+
+  {
+    // Tiny threshold: every line goes out on its own
+    qbe::IrEmitter out{fds[1], 8};
+    for (int i = 0; i < 10; i++) {
+      out.EmitInstr("{} =w copy {}", qbe::QbeValue::Temporary(i),
+                    qbe::QbeValue::Const(i));
+    }
+    out.Flush();
+    CHECK(out.Contents().empty());
+    CHECK(out.BytesWritten() > 0);
+  }
+
+  ::close(fds[1]);
+  auto text = ReadAll(fds[0]);
+  ::close(fds[0]);
+
+  CHECK(text.starts_with("\t%.0 =w copy 0\n"));
+  CHECK(text.ends_with("\t%.9 =w copy 9\n"));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Emitter: pipes into a child process", "[qbe]") {
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+
+  // `cat` stands in for `qbe` here
+  qbe::QbeProcess child{{"cat"}, fds[1]};
+  ::close(fds[1]);
+
+  {
+    qbe::IrEmitter out{child.InputFd()};
+    out.Emit("data $str = {{ b \"{}\", b 0 }}", "hello");
+  }
+
+  CHECK(child.Wait() == 0);
+
+  auto text = ReadAll(fds[0]);
+  ::close(fds[0]);
+
+  CHECK(text == "data $str = { b \"hello\", b 0 }\n");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Switch: binary search", "[qbe]") {
+  size_t next = 1;
+  auto fresh = [&] {
+    return qbe::QbeValue::Temporary(next++);
+  };
+
+  std::vector<qbe::SwitchCase> cases;
+  for (int64_t value : {40, 10, 30, 20, 50}) {
+    cases.push_back({.value = value, .label = fmt::format("case{}", value)});
+  }
+
+  qbe::IrEmitter out;
+  qbe::EmitSwitch(out, qbe::QbeValue::Temporary(0), cases, "other", "sw",
+                  fresh);
+
+  CHECK(out.Contents() ==
+        "\t%.1 =w csltw %.0, 30\n"
+        "\tjnz %.1, @sw.0, @sw.1\n"
+        "@sw.0\n"
+        "\t%.2 =w ceqw %.0, 10\n"
+        "\tjnz %.2, @case10, @sw.2\n"
+        "@sw.2\n"
+        "\t%.3 =w ceqw %.0, 20\n"
+        "\tjnz %.3, @case20, @other\n"
+        "@sw.1\n"
+        "\t%.4 =w csltw %.0, 40\n"
+        "\tjnz %.4, @sw.3, @sw.4\n"
+        "@sw.3\n"
+        "\t%.5 =w ceqw %.0, 30\n"
+        "\tjnz %.5, @case30, @other\n"
+        "@sw.4\n"
+        "\t%.6 =w ceqw %.0, 40\n"
+        "\tjnz %.6, @case40, @sw.5\n"
+        "@sw.5\n"
+        "\t%.7 =w ceqw %.0, 50\n"
+        "\tjnz %.7, @case50, @other\n");
+}
+
+//////////////////////////////////////////////////////////////////////
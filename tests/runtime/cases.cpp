@@ -0,0 +1,127 @@
+#include <etude_rt.h>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+
+static bool Aligned(void* ptr) {
+  return reinterpret_cast<uintptr_t>(ptr) % ETUDE_ALLOC_ALIGN == 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Runtime: bump allocation", "[runtime]") {
+  auto before = etude_alloc_in_use();
+  etude_region_enter();
+  auto entered = etude_alloc_in_use();
+
+  auto* a = static_cast<char*>(etude_alloc(24));
+  auto* b = static_cast<char*>(etude_alloc(1));
+  auto* c = static_cast<char*>(etude_alloc(0));
+
+  CHECK(Aligned(a));
+  CHECK(Aligned(b));
+  CHECK(b == a + 32);  // rounded up to the alignment
+  CHECK(c == b + 16);
+
+  // Objects spill over many chunks, and big ones get their own
+  std::vector<char*> objects;
+  for (int i = 0; i < 100000; i++) {
+    auto* object = static_cast<char*>(etude_alloc(40));
+    std::memset(object, i & 0xff, 40);
+    objects.push_back(object);
+  }
+  auto* big = static_cast<char*>(etude_alloc(3 << 20));
+  std::memset(big, 0, 3 << 20);
+
+  for (int i = 0; i < 100000; i += 997) {
+    CHECK(objects[i][39] == static_cast<char>(i & 0xff));
+  }
+
+  CHECK(etude_alloc_in_use() - entered == 64 + 100000 * 48 + (3 << 20));
+
+  etude_region_exit();
+  CHECK(etude_alloc_in_use() == before);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Runtime: huge sizes abort", "[runtime]") {
+  // Rounding these up used to wrap around to a tiny allocation
+  for (size_t size : {SIZE_MAX, SIZE_MAX - 8, SIZE_MAX - (1 << 20) + 1}) {
+    auto child = ::fork();
+    REQUIRE(child >= 0);
+
+    if (child == 0) {
+      ::close(STDERR_FILENO);  // the "out of memory" message
+      etude_alloc(size);
+      ::_exit(0);
+    }
+
+    int status = 0;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+    CHECK(WIFSIGNALED(status));
+    CHECK(WTERMSIG(status) == SIGABRT);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Runtime: nested regions", "[runtime]") {
+  auto start = etude_alloc_in_use();
+
+  etude_region_enter();
+  auto* outer = static_cast<int*>(etude_alloc(sizeof(int)));
+  *outer = 42;
+
+  for (int round = 0; round < 100; round++) {
+    etude_region_enter();
+    for (int i = 0; i < 50000; i++) {
+      etude_alloc(32);
+    }
+    etude_region_exit();
+  }
+
+  CHECK(*outer == 42);
+
+  // The next object reuses the memory released by the inner regions
+  etude_region_enter();
+  auto* first = etude_alloc(8);
+  etude_region_exit();
+  etude_region_enter();
+  CHECK(etude_alloc(8) == first);
+  etude_region_exit();
+
+  etude_region_exit();
+  CHECK(etude_alloc_in_use() == start);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Runtime: allocators are per thread", "[runtime]") {
+  void* mine = etude_alloc(16);
+  void* theirs = nullptr;
+  size_t their_use = 0;
+
+  std::thread other([&] {
+    etude_region_enter();
+    theirs = etude_alloc(16);
+    their_use = etude_alloc_in_use();
+    etude_region_exit();
+  });
+  other.join();
+
+  CHECK(theirs != mine);
+  CHECK(their_use == 16 + 32);  // and the region mark
+}
+
+//////////////////////////////////////////////////////////////////////
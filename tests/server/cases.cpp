@@ -0,0 +1,126 @@
+#include <server/compile_server.hpp>
+#include <server/server_error.hpp>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+#include <filesystem>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+
+static std::filesystem::path TestSocket(const char* name) {
+  return std::filesystem::temp_directory_path() /
+         fmt::format("etude-{}-{}.sock", name, ::getpid());
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Server: protocol round trip", "[server]") {
+  server::CompileRequest request;
+  request.cwd = "/home/build";
+  request.args = {"-o", "app", "main.et", ""};
+
+  CHECK(server::DecodeRequest(server::Encode(request)) == request);
+
+  server::CompileResponse response;
+  response.status = 1;
+  response.output = "etudec: Import cycle: a -> b -> a\n";
+
+  CHECK(server::DecodeResponse(server::Encode(response)) == response);
+
+  auto bytes = server::Encode(request);
+  CHECK_THROWS_AS(server::DecodeRequest(bytes.substr(0, bytes.size() - 1)),
+                  server::errors::ProtocolError);
+  CHECK_THROWS_AS(server::DecodeRequest(bytes + "x"),
+                  server::errors::ProtocolError);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Server: serves concurrent clients", "[server]") {
+  auto socket = TestSocket("serve");
+  std::atomic<size_t> handled{0};
+
+  server::CompileServer compile_server{
+      socket, [&](const server::CompileRequest& request) {
+        handled += 1;
+
+        server::CompileResponse response;
+        response.status = static_cast<int>(request.args.size());
+        response.output = request.cwd + ":" + request.args.front();
+        return response;
+      }};
+
+  std::thread serving{[&] {
+    compile_server.Serve();
+  }};
+
+  static constexpr size_t kClients = 8;
+  static constexpr size_t kRequests = 20;
+
+  std::vector<std::thread> clients;
+  std::atomic<size_t> correct{0};
+
+  for (size_t c = 0; c < kClients; c++) {
+    clients.emplace_back([&, c] {
+      for (size_t r = 0; r < kRequests; r++) {
+        server::CompileRequest request;
+        request.cwd = fmt::format("/client/{}", c);
+        request.args = {fmt::format("m{}.et", r), "-o", "out"};
+
+        auto response = server::SendCompileRequest(socket, request);
+        if (response.status == 3 &&
+            response.output == fmt::format("/client/{}:m{}.et", c, r)) {
+          correct += 1;
+        }
+      }
+    });
+  }
+
+  for (auto& client : clients) {
+    client.join();
+  }
+
+  compile_server.Stop();
+  serving.join();
+
+  CHECK(correct == kClients * kRequests);
+  CHECK(handled == kClients * kRequests);
+  CHECK(compile_server.RequestsServed() == kClients * kRequests);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Server: errors and missing servers", "[server]") {
+  auto socket = TestSocket("errors");
+
+  CHECK_THROWS_AS(server::SendCompileRequest(socket, {}),
+                  server::errors::SocketError);
+
+  server::CompileServer compile_server{
+      socket, [](const server::CompileRequest&) -> server::CompileResponse {
+        throw std::runtime_error{"boom\n"};
+      }};
+
+  // Only one server per socket
+  CHECK_THROWS_AS(server::CompileServer(socket, {}),
+                  server::errors::SocketError);
+
+  std::thread serving{[&] {
+    compile_server.Serve();
+  }};
+
+  auto response = server::SendCompileRequest(socket, {});
+  CHECK(response.status == 1);
+  CHECK(response.output == "boom\n");
+
+  compile_server.Stop();
+  serving.join();
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -0,0 +1,156 @@
+#include <stats/stats.hpp>
+#include <stats/trace.hpp>
+
+#include <driver/parallel_codegen.hpp>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <new>
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Stats: allocations are charged to the innermost phase",
+          "[stats]") {
+  if (!stats::kEnabled) {
+    CHECK(stats::ThreadAllocations().count == 0);
+    return;
+  }
+
+  // Other tests allocate in these phases too
+  auto before = stats::ThreadAllocations();
+  auto codegen_before = stats::PhaseAllocations(stats::Phase::CODEGEN);
+  auto backend_before = stats::PhaseAllocations(stats::Phase::BACKEND);
+
+  {
+    stats::ScopedPhase codegen{stats::Phase::CODEGEN};
+    auto buffer = std::make_unique<char[]>(1000);
+
+    {
+      stats::ScopedPhase backend{stats::Phase::BACKEND};
+      std::vector<int> ints(10);
+    }
+  }
+
+  auto after = stats::ThreadAllocations();
+  CHECK(after.count - before.count == 2);
+  CHECK(after.bytes - before.bytes == 1000 + 10 * sizeof(int));
+
+  auto codegen = stats::PhaseAllocations(stats::Phase::CODEGEN);
+  CHECK(codegen.count - codegen_before.count == 1);
+  CHECK(codegen.bytes - codegen_before.bytes == 1000);
+
+  auto backend = stats::PhaseAllocations(stats::Phase::BACKEND);
+  CHECK(backend.count - backend_before.count == 1);
+  CHECK(backend.bytes - backend_before.bytes == 10 * sizeof(int));
+
+  auto json = stats::FormatJson();
+  CHECK(json.find("\"codegen\": {") != std::string::npos);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Stats: every form of new is counted", "[stats]") {
+  if (!stats::kEnabled) {
+    return;
+  }
+
+  auto before = stats::ThreadAllocations();
+
+  // Volatile, so that no call is optimized out as an unused pair
+  void* volatile plain = ::operator new[](24);
+  void* volatile nothrow = ::operator new(8, std::nothrow);
+  void* volatile aligned = ::operator new(100, std::align_val_t{64});
+  void* volatile aligned_array =
+      ::operator new[](64, std::align_val_t{128}, std::nothrow);
+
+  auto after = stats::ThreadAllocations();
+  CHECK(after.count - before.count == 4);
+  CHECK(after.bytes - before.bytes == 24 + 8 + 100 + 64);
+  CHECK(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+  CHECK(reinterpret_cast<uintptr_t>(aligned_array) % 128 == 0);
+
+  ::operator delete[](plain);
+  ::operator delete(nothrow, std::nothrow);
+  ::operator delete(aligned, 100, std::align_val_t{64});
+  ::operator delete[](aligned_array, std::align_val_t{128});
+}
+
+TEST_CASE("Stats: counters", "[stats]") {
+  stats::Count(stats::Counter::FUNCTIONS, 3);
+
+  auto table = stats::FormatTable();
+  if (stats::kEnabled) {
+    CHECK(table.find("functions") != std::string::npos);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Trace: events from worker threads", "[stats]") {
+  auto path = std::filesystem::temp_directory_path() / "etude-trace.json";
+  stats::EnableTracing(path);
+
+  {
+    stats::TraceScope scope{"test", "a \"quoted\" name"};
+  }
+
+  driver::ParallelCodegen codegen{4};
+  codegen.LowerAll(16, [](size_t, qbe::IrEmitter& out) {
+    out.Emit("# nothing");
+  });
+
+  REQUIRE(stats::WriteTrace(path));
+
+  std::ifstream file{path};
+  std::stringstream json;
+  json << file.rdbuf();
+  auto text = json.str();
+
+  CHECK(text.starts_with("{\"traceEvents\": ["));
+  CHECK(text.find("\"name\": \"a \\\"quoted\\\" name\"") != std::string::npos);
+  CHECK(text.find("\"name\": \"function #15\"") != std::string::npos);
+  CHECK(text.find("\"name\": \"lower all\"") != std::string::npos);
+
+  // Off again for the tests after this one, and nothing left to dump
+  stats::DisableTracing();
+  CHECK_FALSE(stats::TracingEnabled());
+
+  {
+    stats::TraceScope scope{"test", "not recorded"};
+  }
+
+  REQUIRE(stats::WriteTrace(path));
+  std::ifstream empty{path};
+  std::stringstream rest;
+  rest << empty.rdbuf();
+  CHECK(rest.str() == "{\"traceEvents\": [\n\n]}\n");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Trace: scope open when tracing starts", "[stats]") {
+  auto path = std::filesystem::temp_directory_path() / "etude-trace.json";
+
+  {
+    stats::TraceScope scope{"test"};
+    stats::EnableTracing(path);
+    scope.SetName("never begun");
+  }
+
+  REQUIRE(stats::WriteTrace(path));
+  stats::DisableTracing();
+
+  std::ifstream file{path};
+  std::stringstream json;
+  json << file.rdbuf();
+  CHECK(json.str() == "{\"traceEvents\": [\n\n]}\n");
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -0,0 +1,264 @@
+#include <x86/assembler.hpp>
+#include <x86/elf_writer.hpp>
+#include <x86/stack_frame.hpp>
+#include <x86/jit.hpp>
+
+#include <elf.h>
+
+// Finally,
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using x86::Reg;
+
+//////////////////////////////////////////////////////////////////////
+
+static std::vector<uint8_t> Bytes(std::initializer_list<uint8_t> bytes) {
+  return bytes;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("x86: encodings", "[x86]") {
+  x86::Assembler a;
+
+  SECTION("mov") {
+    a.MovRegReg(Reg::RAX, Reg::RDI);
+    CHECK(a.Code() == Bytes({0x48, 0x89, 0xF8}));
+  }
+
+  SECTION("mov imm") {
+    a.MovRegImm(Reg::R10, 42);
+    CHECK(a.Code() == Bytes({0x49, 0xC7, 0xC2, 42, 0, 0, 0}));
+  }
+
+  SECTION("load from a slot") {
+    a.Load(Reg::RAX, Reg::RBP, -8);
+    CHECK(a.Code() == Bytes({0x48, 0x8B, 0x85, 0xF8, 0xFF, 0xFF, 0xFF}));
+  }
+
+  SECTION("store through rsp") {
+    a.Store(Reg::RSP, 0, Reg::R8);
+    CHECK(a.Code() == Bytes({0x4C, 0x89, 0x84, 0x24, 0, 0, 0, 0}));
+  }
+
+  SECTION("push/pop") {
+    a.Push(Reg::RBP);
+    a.Pop(Reg::R12);
+    CHECK(a.Code() == Bytes({0x55, 0x41, 0x5C}));
+  }
+
+  SECTION("imul") {
+    a.Imul(Reg::RAX, Reg::RCX);
+    CHECK(a.Code() == Bytes({0x48, 0x0F, 0xAF, 0xC1}));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("x86: labels", "[x86]") {
+  x86::Assembler a;
+
+  auto back = a.NewLabel();
+  auto forward = a.NewLabel();
+
+  a.Bind(back);
+  a.JmpIf(x86::Cond::EQUAL, forward);  // 6 bytes
+  a.Jmp(back);                         // 5 bytes
+  a.Bind(forward);
+
+  CHECK(a.Code() == Bytes({0x0F, 0x84, 5, 0, 0, 0,  //
+                           0xE9, 0xF5, 0xFF, 0xFF, 0xFF}));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("x86: stack frame", "[x86]") {
+  x86::StackFrame frame;
+
+  CHECK(frame.Allocate(8) == -8);
+  CHECK(frame.Allocate(1, 1) == -9);
+  CHECK(frame.Allocate(8) == -24);
+  CHECK(frame.FrameSize() == 32);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("x86: relocatable object", "[x86]") {
+  x86::Assembler a;
+
+  a.DefineData("msg", "hi\0");
+
+  a.BeginFunction("main");
+  a.Prologue();
+  a.LeaSymbol(Reg::RDI, "msg");
+  a.Call("puts");
+  a.MovRegImm(Reg::RAX, 0);
+  a.SetFrameSize(0);
+  a.Epilogue();
+  a.EndFunction();
+
+  CHECK(a.Relocations().size() == 2);
+
+  auto object = x86::ElfWriter{a}.Serialize();
+  REQUIRE(object.size() > sizeof(Elf64_Ehdr));
+
+  Elf64_Ehdr header;
+  std::memcpy(&header, object.data(), sizeof(header));
+
+  CHECK(std::memcmp(header.e_ident, ELFMAG, SELFMAG) == 0);
+  CHECK(header.e_type == ET_REL);
+  CHECK(header.e_machine == EM_X86_64);
+  CHECK(header.e_shoff + header.e_shnum * sizeof(Elf64_Shdr) ==
+        object.size());
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static void ReturnConst(x86::Assembler& a, const char* name, int64_t value) {
+  a.BeginFunction(name);
+  a.MovRegImm(Reg::RAX, value);
+  a.Ret();
+  a.EndFunction();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("x86: jit and redefinition", "[x86]") {
+  x86::Jit jit;
+
+  {
+    x86::Assembler a;
+    ReturnConst(a, "answer", 42);
+
+    // fun twice() { answer() * 2 }
+    a.BeginFunction("twice");
+    a.Prologue();
+    a.Call("answer");
+    a.Add(Reg::RAX, Reg::RAX);
+    a.SetFrameSize(0);
+    a.Epilogue();
+    a.EndFunction();
+
+    jit.Load(a);
+  }
+
+  auto twice = jit.Get<long()>("twice");
+  REQUIRE(twice != nullptr);
+  CHECK(twice() == 84);
+
+  {
+    x86::Assembler a;
+    ReturnConst(a, "answer", 50);
+    jit.Load(a);
+  }
+
+  // `twice` is not reloaded, its call site got patched
+  CHECK(jit.Get<long()>("twice") == twice);
+  CHECK(twice() == 100);
+  CHECK(jit.Lookup("missing") == nullptr);
+
+  {
+    // Redefines `answer`, but `broken` cannot be linked: nothing of
+    // it is loaded
+    x86::Assembler a;
+    ReturnConst(a, "answer", 7);
+    a.BeginFunction("broken");
+    a.Call("answer");
+    a.Call("no_such_function_anywhere");
+    a.EndFunction();
+
+    CHECK_THROWS_AS(jit.Load(a), x86::errors::JitError);
+  }
+
+  CHECK(jit.Lookup("broken") == nullptr);
+  CHECK(twice() == 100);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("x86: jit calls into libc", "[x86]") {
+  x86::Jit jit;
+  x86::Assembler a;
+
+  a.DefineData("digits", "1234\0");
+
+  a.BeginFunction("parse");
+  a.Prologue();
+  a.LeaSymbol(Reg::RDI, "digits");
+  a.Call("atol");
+  a.SetFrameSize(0);
+  a.Epilogue();
+  a.EndFunction();
+
+  jit.Load(a);
+  CHECK(jit.Get<long()>("parse")() == 1234);
+
+  x86::Assembler bad;
+  bad.BeginFunction("broken");
+  bad.Call("no_such_function_anywhere");
+  bad.EndFunction();
+
+  CHECK_THROWS_AS(jit.Load(bad), x86::errors::JitError);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("x86: jump table", "[x86]") {
+  x86::Jit jit;
+
+  // Plain and extended registers, caller-saved only
+  std::pair<Reg, Reg> registers[] = {{Reg::RDI, Reg::RCX},
+                                     {Reg::R10, Reg::R11}};
+
+  for (auto [index, scratch] : registers) {
+    x86::Assembler a;
+
+    // fun pick(x) = switch x { 10 => 100, 11 => 111, 13 => 133 } else -1
+    a.BeginFunction("pick");
+    a.MovRegReg(index, Reg::RDI);
+
+    auto ten = a.NewLabel();
+    auto eleven = a.NewLabel();
+    auto other = a.NewLabel();
+
+    // 12 is a hole; 13 is bound before the table is emitted
+    auto thirteen = a.NewLabel();
+    auto skip = a.NewLabel();
+    a.Jmp(skip);
+    a.Bind(thirteen);
+    a.MovRegImm(Reg::RAX, 133);
+    a.Ret();
+    a.Bind(skip);
+
+    x86::Assembler::Label targets[] = {ten, eleven, other, thirteen};
+    a.JumpTable(index, scratch, 10, targets, other);
+
+    a.Bind(ten);
+    a.MovRegImm(Reg::RAX, 100);
+    a.Ret();
+    a.Bind(eleven);
+    a.MovRegImm(Reg::RAX, 111);
+    a.Ret();
+    a.Bind(other);
+    a.MovRegImm(Reg::RAX, -1);
+    a.Ret();
+    a.EndFunction();
+
+    jit.Load(a);
+
+    auto pick = jit.Get<long(long)>("pick");
+    CHECK(pick(10) == 100);
+    CHECK(pick(11) == 111);
+    CHECK(pick(12) == -1);
+    CHECK(pick(13) == 133);
+    CHECK(pick(9) == -1);
+    CHECK(pick(14) == -1);
+    CHECK(pick(-5) == -1);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////